@@ -58,6 +58,8 @@
 #define configUSE_APPLICATION_TASK_TAG 0
 #define configUSE_COUNTING_SEMAPHORES 1
 #define configQUEUE_REGISTRY_SIZE 8
+/* Índice 0: acordar a task (uso geral); índice 1: fim de consulta DNS (net_dns.c) */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 2
 #define configUSE_QUEUE_SETS 1
 #define configUSE_TIME_SLICING 1
 #define configUSE_NEWLIB_REENTRANT 0
@@ -105,7 +107,7 @@
 #define configNUM_CORES 2
 #define configTICK_CORE 0
 #define configRUN_MULTIPLE_PRIORITIES 1
-#define configUSE_CORE_AFFINITY 0
+#define configUSE_CORE_AFFINITY 1
 
 /* RP2040 specific */
 #define configSUPPORT_PICO_SYNC_INTEROP 1
@@ -15,12 +15,43 @@
 // ==============================
 #define APP_WIFI_SSID     "PATRICIO MEGA WAVE"
 #define APP_WIFI_PASSWORD "patricioalves"
+#define APP_WIFI_JOIN_TIMEOUT_MS   30000u   /**< Associação + DHCP antes de desistir da tentativa. */
+#define APP_WIFI_RETRY_MS          5000u    /**< Espera entre tentativas. */
+#define APP_WIFI_POLL_MS           250u     /**< Conferência do link (além do aviso da netif). */
+
+// Reentrada rápida (net_wifi_store.c: último setor da flash)
+#define APP_WIFI_FAST_JOIN         1        /**< Tenta primeiro o BSSID/canal guardados (sem varredura). */
+#define APP_WIFI_FAST_TIMEOUT_MS   4000u    /**< Desiste do caminho rápido e faz a varredura completa. */
+#define APP_WIFI_PIN_LEASE         0        /**< 1 = reaproveita o último lease como IP fixo (rede com reserva DHCP). */
+#define APP_WIFI_STATIC_IP         0        /**< 1 = IP fixo abaixo, sem DHCP. */
+#define APP_WIFI_IP                "192.168.0.50"
+#define APP_WIFI_NETMASK           "255.255.255.0"
+#define APP_WIFI_GATEWAY           "192.168.0.1"
+#define APP_WIFI_DNS               "192.168.0.1"
+#define APP_WIFI_STORE_TIMEOUT_MS  100u     /**< Espera para parar o outro core antes de gravar. */
 
 // ==============================
 // Serial RPC (USB-Serial JSON)
 // ==============================
 #define APP_SERIAL_ACCESS_PASSWORD "1234"   /**< Troque para uma senha forte. */
 #define APP_SERIAL_TELE_PERIOD_MS  200u     /**< Período de telemetria via SerialRPC. */
+#define APP_SERIAL_BIN_TELE_PERIOD_MS 100u  /**< Período no modo binário (amostra de lux). */
+#define APP_SERIAL_LINE_MAX        512u     /**< Maior linha JSON aceita (bytes). */
+#define APP_SERIAL_PIPELINE_DEPTH  8u       /**< Pedidos enfileirados antes de pausar o RX (potência de 2). */
+#define APP_SERIAL_TX_MAX          256u     /**< Buffer de uma resposta JSON (escrita única). */
+#define APP_SERIAL_IDLE_WAKE_MS    1000u    /**< Acorda sem RX só para manutenção. */
+#define APP_SERIAL_SUB_MIN_PERIOD_MS 20u    /**< Menor período aceito no "subscribe". */
+#define APP_SERIAL_DUMP_CHUNK      32u      /**< Quadros do histórico por linha do "dump". */
+#define APP_SERIAL_DUMP_CREDIT     8u       /**< Blocos do "dump" sem "dump_credit" (padrão). */
+#define APP_LUX_SAMPLES_LEN        16u      /**< Amostras brutas de lux aguardando o SerialRPC. */
+
+// ==============================
+// USB composto (CDC 0 = SerialRPC, CDC 1 = log)
+// ==============================
+#define APP_USB_VID                0x2E8Au  /**< Raspberry Pi */
+#define APP_USB_PID                0x000Au  /**< Mesmo PID do stdio USB do SDK... */
+#define APP_USB_BCD_DEVICE         0x0200u  /**< ...com bcdDevice próprio (2 CDC). */
+#define APP_USB_RPC_TX_TIMEOUT_MS  50u      /**< Espera máxima por espaço na FIFO do RPC. */
 
 // ==============================
 // MQTT (HiveMQ Public - sem TLS / sem user/pass)
@@ -30,7 +61,21 @@
 #define APP_MQTT_KEEPALIVE_S       30u
 #define APP_MQTT_QOS               1u
 #define APP_MQTT_RETAIN            0u
-#define APP_MQTT_ACK_TIMEOUT_MS    2000u
+#define APP_MQTT_ACK_TIMEOUT_MS    2000u    /**< PUBACK mais antigo atrasado além disso: reconecta e reenvia. */
+#define APP_MQTT_INFLIGHT_LEN      64u      /**< Telemetria guardada até o PUBACK (~2 min de frames a 0,5 Hz: 1 a cada 2 s). */
+#define APP_MQTT_FRAME_QUEUE_LEN   32u      /**< Frames do display à espera da task MQTT (~1 min a 0,5 Hz; pior bloqueio em DNS/connect ~6 s). */
+#define APP_MQTT_RECONNECT_WINDOW_MS 10000u /**< 1a tentativa após queda/boot: sorteada em [0, janela]. */
+#define APP_MQTT_BACKOFF_BASE_MS   1000u    /**< Backoff após falha: base * 2^n (full jitter)... */
+#define APP_MQTT_BACKOFF_CAP_MS    60000u   /**< ...até este teto. */
+#define APP_CMD_RING_LEN           8u       /**< Comandos pendentes (potência de 2). */
+
+// DNS (net_dns.c)
+#define APP_DNS_CACHE_LEN          4u       /**< Hosts no cache. */
+#define APP_DNS_HOST_MAX           64u      /**< Maior hostname (com '\0'). */
+#define APP_DNS_WAITERS            4u       /**< Tasks esperando o mesmo host. */
+#define APP_DNS_TTL_MS             300000u  /**< Validade de uma resposta. */
+#define APP_DNS_STALE_MAX_MS       86400000u /**< Serve vencido (revalidando) até esta idade. */
+#define APP_DNS_NEG_TTL_MS         2000u    /**< Após falha, não consulta de novo antes disto. */
 
 #define APP_TOPIC_PREFIX           "embarcatech"
 
@@ -40,6 +85,22 @@
 #define APP_LED_PIN                7u
 #define APP_LED_COUNT              25u
 
+// Canais da luminária (uma fita por state machine, pio0 + pio1)
+#define APP_LUM_MAX_CHANNELS       7u       /**< 8 SMs menos 1 para o gSPI do CYW43 (iniciado depois, em vTaskWifi). */
+#define APP_LUM_MAX_LEDS_PER_CH    64u
+#define APP_LUM_CHANNEL_COUNT      1u
+#define APP_LUM_CHANNEL_PINS       { APP_LED_PIN }     /**< Um pino por canal. */
+#define APP_LUM_CHANNEL_LEDS       { APP_LED_COUNT }   /**< LEDs por canal. */
+
+// ==============================
+// Hardware: saída PWM para drivers de LED (corrente constante / 0-10 V)
+// ==============================
+#define APP_PWM_ENABLE             0                   /**< 1 = habilita backend PWM. */
+#define APP_PWM_CHANNEL_COUNT      1u                  /**< <= APP_LUM_CHANNEL_COUNT. */
+#define APP_PWM_CHANNEL_PINS       { 12u }             /**< Canal i segue o canal i do matrix_control. */
+#define APP_PWM_FREQ_HZ            1900u               /**< Portadora (>1.25 kHz, IEEE 1789). */
+#define APP_PWM_INVERT             0                   /**< 1 = saída invertida (interface 0-10 V open-collector). */
+
 // ==============================
 // I2C0: BH1750 + AHT10
 // ==============================
@@ -54,7 +115,14 @@
 #define APP_I2C1_PORT              i2c1
 #define APP_I2C1_SDA_PIN           14u
 #define APP_I2C1_SCL_PIN           15u
-#define APP_I2C1_BAUD_HZ           (100u * 1000u)
+#define APP_I2C1_BAUD_HZ           (400u * 1000u)   /**< 400 kHz (Fast-mode); até 1 MHz (Fm+) com pull-ups fortes. */
+
+// ==============================
+// OLED: histórico e páginas de tendência
+// ==============================
+#define APP_HIST_LEN               512u    /**< Quadros guardados (múltiplo de APP_HIST_BLOCKS). */
+#define APP_HIST_BLOCKS            8u      /**< Blocos para min/max da janela. */
+#define APP_OLED_PAGE_FRAMES       5u      /**< Quadros por página do OLED (0 = sem rotação). */
 
 // ==============================
 // Auto-brightness: mapeamento lux -> brilho
@@ -62,6 +130,16 @@
 #define APP_LUX_MIN                150.0f
 #define APP_LUX_MAX                400.0f
 
+// ==============================
+// Log assíncrono (app_log)
+// ==============================
+#define APP_LOG_LEVEL              1       /**< Menor nível gravado (0 debug, 1 info, 2 warn, 3 error). */
+#define APP_LOG_RING_LEN           32u     /**< Registros no anel (potência de 2). */
+#define APP_LOG_MSG_MAX            96u     /**< Maior mensagem (truncada além disso). */
+#define APP_LOG_DRAIN_POLL_MS      50u     /**< Revisão do anel sem notificação. */
+#define APP_TRACE_ENABLE           1       /**< Trace binário (app_trace); 0 remove as chamadas. */
+#define APP_TRACE_RING_LEN         64u     /**< Eventos no anel do trace (potência de 2). */
+
 // ==============================
 // Sincronização do I2C0 entre tasks (recomendado)
 // ==============================
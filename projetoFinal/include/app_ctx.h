@@ -19,22 +19,19 @@
 #endif
 
 #include "mqtt_app.h"
+#include "sensor_frame.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /**
- * @brief Frame agregado de sensores para telemetria / display.
+ * @brief Leitura bruta do BH1750 (uma por ciclo do vTaskLuminos).
  */
 typedef struct {
-    float lux;
-    float luxPercLum;
-    float temp;
-    float hum;
-    uint32_t seq;
-    TickType_t tick;
-} sensor_frame_t;
+    uint32_t t_ms;
+    float    lux;
+} lux_sample_t;
 
 /**
  * @brief Contexto da aplicação (passado para tasks via pvParameters).
@@ -50,12 +47,26 @@ typedef struct app_ctx {
     QueueHandle_t q_hum;
     QueueHandle_t q_perc;
 
+    // amostras brutas de lux (FIFO); só alimentada com assinante "raw" no SerialRPC
+    QueueHandle_t q_lux_samples;
+    volatile bool lux_samples_on;
+    volatile uint32_t lux_samples_drop;
+
+    // frames para a fila de saída MQTT (FIFO): a task MQTT pode estar bloqueada (DNS,
+    // delays) enquanto o display produz; q_frame guarda só o último
+    QueueHandle_t q_tele;
+    volatile uint32_t tele_drop;
+
 #if APP_USE_I2C0_MUTEX
     SemaphoreHandle_t i2c0_mutex;
 #endif
 
     // tasks
     TaskHandle_t task_mqtt;
+    TaskHandle_t task_serial;
+
+    // boot -> primeira atualização dos LEDs (ms desde o reset; 0 = ainda não)
+    volatile uint32_t boot_led_ms;
 
     // MQTT state
     mqtt_app_t mqtt;
@@ -0,0 +1,76 @@
+#ifndef APP_LOG_H
+#define APP_LOG_H
+
+/**
+ * @file app_log.h
+ * @brief Log assíncrono: tasks (dos dois cores) e IRQs gravam num anel; uma task de
+ *        baixa prioridade escreve no stdio.
+ *
+ * Quem loga nunca espera pelo USB: a chamada só reserva um slot, formata nele e marca
+ * como pronto. Com o anel cheio o registro é descartado e contado.
+ *
+ * O M0+ não tem LDREX/STREX; a reserva (um incremento de contador) usa um spinlock de
+ * hardware do RP2040 com IRQs desligadas por poucos ciclos. A formatação e a cópia
+ * acontecem fora dele, em paralelo entre produtores.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR
+} log_level_t;
+
+/**
+ * @brief Contadores do log (leitura aproximada, sem trava).
+ */
+typedef struct {
+    uint32_t written;      /**< registros já escritos no stdio */
+    uint32_t dropped;      /**< descartados por anel cheio */
+    uint32_t lat_max_us;   /**< pior tempo de uma chamada app_log() */
+} app_log_stats_t;
+
+/**
+ * @brief Reserva o spinlock. Chamar em main() antes de qualquer log.
+ */
+void app_log_init(void);
+
+/**
+ * @brief Registra uma mensagem (estilo printf, sem '\n' no final). Não bloqueia.
+ *
+ * Níveis abaixo de APP_LOG_LEVEL são descartados sem formatar.
+ */
+void app_log(log_level_t level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void app_log_v(log_level_t level, const char *fmt, va_list ap);
+
+void app_log_get_stats(app_log_stats_t *out);
+
+/**
+ * @brief Acorda a task de dreno (task ou IRQ). Usado também pelo app_trace.
+ */
+void app_log_kick(void);
+
+/**
+ * @brief Task que esvazia o anel (e o do app_trace) no stdio (pvParameters ignorado).
+ */
+void vTaskLogDrain(void *pvParameters);
+
+#define LOG_D(...) app_log(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_I(...) app_log(LOG_LEVEL_INFO,  __VA_ARGS__)
+#define LOG_W(...) app_log(LOG_LEVEL_WARN,  __VA_ARGS__)
+#define LOG_E(...) app_log(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_LOG_H
@@ -0,0 +1,72 @@
+#ifndef APP_TRACE_H
+#define APP_TRACE_H
+
+/**
+ * @file app_trace.h
+ * @brief Trace binário com formatação adiada: grava id do formato + argumentos crus.
+ *
+ * A chamada não formata nada: reserva um registro no anel (mesmo esquema do app_log),
+ * copia até 4 palavras e marca como pronto. A task de dreno do log escreve cada
+ * registro como uma linha de texto "~<base64>" (registro + CRC-16), que atravessa o
+ * console junto com o resto do log; tools/trace_decode.cpp a transforma em texto.
+ *
+ * Registro (LE): u16 id | u8 nargs | u8 core | u32 t_us | u32 args[nargs]
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "app_trace_ids.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_TRACE_MAX_ARGS 4u
+
+/**
+ * @brief Reserva o spinlock. Chamar em main() antes de qualquer trace.
+ */
+void app_trace_init(void);
+
+/**
+ * @brief Grava um evento (n argumentos válidos em a..d). Não bloqueia; anel cheio = descarta.
+ */
+void app_trace_rec(app_trace_id_t id, uint8_t n, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+
+/**
+ * @brief Escreve no stdio os registros prontos (chamada pela task de dreno do log).
+ */
+void app_trace_drain(void);
+
+/** @brief Registros descartados por anel cheio. */
+uint32_t app_trace_dropped(void);
+
+/** @brief Bits de um float como argumento (%f/%e/%g). */
+static inline uint32_t trace_f(float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+
+#if APP_TRACE_ENABLE
+#define TRACE0(ev)             app_trace_rec(TRACE_ID_##ev, 0, 0, 0, 0, 0)
+#define TRACE1(ev, a)          app_trace_rec(TRACE_ID_##ev, 1, (uint32_t)(a), 0, 0, 0)
+#define TRACE2(ev, a, b)       app_trace_rec(TRACE_ID_##ev, 2, (uint32_t)(a), (uint32_t)(b), 0, 0)
+#define TRACE3(ev, a, b, c)    app_trace_rec(TRACE_ID_##ev, 3, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), 0)
+#define TRACE4(ev, a, b, c, d) app_trace_rec(TRACE_ID_##ev, 4, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+#else
+#define TRACE0(ev)             ((void)0)
+#define TRACE1(ev, a)          ((void)0)
+#define TRACE2(ev, a, b)       ((void)0)
+#define TRACE3(ev, a, b, c)    ((void)0)
+#define TRACE4(ev, a, b, c, d) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_TRACE_H
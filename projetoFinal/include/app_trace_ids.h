@@ -0,0 +1,29 @@
+#ifndef APP_TRACE_IDS_H
+#define APP_TRACE_IDS_H
+
+/**
+ * @file app_trace_ids.h
+ * @brief Tabela de eventos do trace binário: id -> string de formato.
+ *
+ * Só macros, sem dependência do SDK: o firmware gera o enum de ids e o decodificador
+ * do host (tools/trace_decode.cpp) gera a tabela de strings a partir da mesma lista,
+ * em tempo de compilação. As strings não vão para a flash do firmware.
+ *
+ * Argumentos são palavras de 32 bits: %d/%i (int32), %u/%x/%X/%c (uint32),
+ * %f/%e/%g (float, passado com trace_f()). %s não é suportado.
+ * Para um evento novo: acrescentar uma linha no fim (ids existentes não mudam).
+ */
+#define APP_TRACE_EVENTS(X)                                                        \
+    X(LUX,        "Lux: %.2f  auto=%u  target=%u  current=%u")                      \
+    X(TEMP_HUM,   "Temp: %.2f C | Umid: %.2f %%")                                   \
+    X(OLED_DRAW,  "OLED: draw %u ciclos, %u bytes, %u paginas, %u us")              \
+    X(CMD_TARGET, "[CMD] target=%u%% channel=%d")
+
+#define APP_TRACE_ID(name, fmt) TRACE_ID_##name,
+
+typedef enum {
+    APP_TRACE_EVENTS(APP_TRACE_ID)
+    TRACE_ID_COUNT
+} app_trace_id_t;
+
+#endif // APP_TRACE_IDS_H
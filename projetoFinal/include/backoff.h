@@ -0,0 +1,47 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+/**
+ * @file backoff.h
+ * @brief Espera entre tentativas de reconexão: janela de espalhamento + backoff
+ * exponencial com teto e "full jitter" (C puro; usado no firmware e no host).
+ *
+ * Tentativa 0 (logo após perder o broker ou subir o link): uniforme em [0, window_ms],
+ * para que uma frota que caiu junta não volte junta.
+ * Tentativa n >= 1 (a anterior falhou): uniforme em [0, min(cap_ms, base_ms * 2^(n-1))].
+ *
+ * O gerador (xorshift32) é semeado pelo id único da placa: nós diferentes sorteiam
+ * sequências diferentes mesmo ligando no mesmo instante.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t base_ms;
+    uint32_t cap_ms;
+    uint32_t window_ms;
+    uint32_t attempt;    /**< tentativas desde o último backoff_reset */
+    uint32_t rng;        /**< estado do xorshift32 (nunca 0) */
+} backoff_t;
+
+/** @brief Semente a partir de um id (ex.: pico_get_unique_board_id), FNV-1a. */
+uint32_t backoff_seed(const uint8_t *id, size_t len);
+
+void backoff_init(backoff_t *b, uint32_t base_ms, uint32_t cap_ms, uint32_t window_ms, uint32_t seed);
+
+/** @brief Volta à tentativa 0 (conexão bem-sucedida ou novo evento de queda). */
+void backoff_reset(backoff_t *b);
+
+/** @brief Espera antes da próxima tentativa (e conta a tentativa). */
+uint32_t backoff_next_ms(backoff_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BACKOFF_H
@@ -0,0 +1,68 @@
+#ifndef CMD_PARSER_H
+#define CMD_PARSER_H
+
+/**
+ * @file cmd_parser.h
+ * @brief Parser JSON incremental (retomável) para comandos da luminária.
+ *
+ * Consome o payload em fragmentos, na ordem em que o lwIP os entrega, sem bufferizar
+ * a mensagem: só guarda a chave e o valor escalar correntes (poucos bytes). Chaves
+ * desconhecidas e valores aninhados são descartados em streaming, então o tamanho da
+ * mensagem não é limitado. Ao fechar o objeto raiz o comando fica em cmd_parser_t::cmd.
+ *
+ * Aceita as mesmas chaves de matrix_control_apply_cmd_payload():
+ *   mode, matrixPercent, brightness, percent, channel.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "matrix_control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CMD_PARSER_KEY_MAX   16u   /**< chaves maiores são tratadas como desconhecidas */
+#define CMD_PARSER_VAL_MAX   16u   /**< valores escalares maiores são truncados */
+#define CMD_PARSER_DEPTH_MAX 32u   /**< aninhamento máximo dentro de valores ignorados */
+
+typedef enum {
+    CMD_PARSE_MORE = 0,   /**< objeto ainda aberto: aguardando mais bytes */
+    CMD_PARSE_DONE,       /**< objeto raiz fechado; comando em cmd_parser_t::cmd */
+    CMD_PARSE_ERROR       /**< JSON malformado (estado fica preso até reset) */
+} cmd_parse_status_t;
+
+/**
+ * @brief Estado do parser (pode ficar em estrutura estática; sem alocação).
+ */
+typedef struct {
+    uint8_t  state;
+    int8_t   key;          /**< matrix_key_t da chave corrente */
+    uint8_t  key_len;
+    uint8_t  val_len;
+    uint8_t  depth;        /**< profundidade ao descartar objeto/array */
+    uint8_t  skip_str;     /**< dentro de string ao descartar */
+    uint8_t  pct_rank;     /**< prioridade da chave de percent já vista */
+    uint32_t depth_bits;   /**< bit i = 1 se o nível i é objeto (valida '}' x ']') */
+    char     key_buf[CMD_PARSER_KEY_MAX];
+    char     val_buf[CMD_PARSER_VAL_MAX];
+    matrix_cmd_t cmd;
+} cmd_parser_t;
+
+/**
+ * @brief Prepara o parser para uma nova mensagem.
+ */
+void cmd_parser_reset(cmd_parser_t *p);
+
+/**
+ * @brief Consome um fragmento do payload.
+ * @return CMD_PARSE_DONE quando o objeto raiz fechou (espaços depois são aceitos).
+ */
+cmd_parse_status_t cmd_parser_feed(cmd_parser_t *p, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CMD_PARSER_H
@@ -0,0 +1,79 @@
+#ifndef CMD_RING_H
+#define CMD_RING_H
+
+/**
+ * @file cmd_ring.h
+ * @brief Fila SPSC sem trava de comandos decodificados (callbacks lwIP -> task MQTT).
+ *
+ * Produtor: contexto lwIP (callbacks de dados MQTT). Consumidor: vTaskMqtt.
+ * Nenhum comando é perdido: com a fila cheia, os novos comandos são fundidos em um
+ * bloco de overflow (último valor vence, por alvo: modo e percent de cada canal),
+ * entregue depois do que já estava na fila. Cada fusão é contada em `coalesced`.
+ *
+ * O bloco é entregue ao consumidor por reivindicação (ovf_claim): depois dela o
+ * produtor passa a fundir no outro dos dois blocos, então um bloco já entregue nunca
+ * recebe comandos nem é entregue de novo. O produtor nunca espera.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "matrix_control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Estado final equivalente de vários comandos (último valor vence por alvo).
+ */
+typedef struct {
+    uint8_t  has_mode;
+    uint8_t  mode;                               /**< matrix_mode_t */
+    uint32_t pct_mask;                           /**< canais com percent pendente */
+    uint8_t  pct[APP_LUM_CHANNEL_COUNT];
+} cmd_ring_merge_t;
+
+typedef struct {
+    matrix_cmd_t slot[APP_CMD_RING_LEN];
+    volatile uint32_t head;        /**< escrito só pelo produtor */
+    volatile uint32_t tail;        /**< escrito só pelo consumidor */
+
+    // blocos de overflow: ovf[ovf_gen & 1] é o atual (ovf_seq ímpar = produtor escrevendo)
+    cmd_ring_merge_t  ovf[2];
+    volatile uint32_t ovf_gen;     /**< geração do bloco atual (produtor; 0 = nenhum ainda) */
+    volatile uint32_t ovf_seq;
+    volatile uint32_t ovf_claim;   /**< geração reivindicada (consumidor) */
+    volatile uint32_t ovf_taken;   /**< geração já copiada para pend (consumidor) */
+
+    // contadores (produtor)
+    volatile uint32_t pushed;
+    volatile uint32_t coalesced;
+
+    // consumidor: bloco de overflow sendo expandido em comandos
+    cmd_ring_merge_t  pend;
+} cmd_ring_t;
+
+/**
+ * @brief Zera a fila (antes de registrar os callbacks).
+ */
+void cmd_ring_init(cmd_ring_t *r);
+
+/**
+ * @brief Enfileira um comando (produtor).
+ * @return true se entrou na fila; false se foi fundido no bloco de overflow.
+ */
+bool cmd_ring_push(cmd_ring_t *r, const matrix_cmd_t *cmd);
+
+/**
+ * @brief Retira o próximo comando (consumidor), na ordem de chegada.
+ * @return true se havia comando.
+ */
+bool cmd_ring_pop(cmd_ring_t *r, matrix_cmd_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CMD_RING_H
@@ -0,0 +1,51 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+/**
+ * @file dispatch.h
+ * @brief Hash perfeito para tabelas pequenas de nomes (ops do SerialRPC, chaves de comando).
+ *
+ * dispatch_build() procura uma semente para a qual todos os nomes caem em posições
+ * distintas da tabela; depois disso, dispatch_lookup() custa um hash + uma comparação,
+ * independente da quantidade de nomes. Para acrescentar um nome basta incluí-lo na
+ * lista do módulo dono da tabela; a semente é recalculada na inicialização.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISPATCH_SLOTS_MAX 64u   /**< tabela até 64 posições (nomes <= 32) */
+#define DISPATCH_EMPTY     0xFFu
+
+typedef struct {
+    const char *const *names;
+    uint8_t  count;
+    uint8_t  mask;                       /**< tamanho da tabela - 1 */
+    uint32_t seed;
+    uint8_t  slot[DISPATCH_SLOTS_MAX];   /**< índice em names[] ou DISPATCH_EMPTY */
+    uint8_t  len[DISPATCH_SLOTS_MAX / 2u]; /**< strlen(names[i]), comparado antes do memcmp */
+} dispatch_table_t;
+
+/**
+ * @brief Monta a tabela para a lista de nomes (chamar uma vez, na inicialização).
+ * @return false se não achou semente (lista grande demais, nome com mais de 255
+ *         caracteres ou nomes repetidos).
+ */
+bool dispatch_build(dispatch_table_t *t, const char *const *names, uint8_t count);
+
+/**
+ * @brief Índice do nome em names[] ou -1. O texto não precisa terminar em '\0'; um
+ *        '\0' dentro de s[0..len) não casa com nenhum nome.
+ */
+int dispatch_lookup(const dispatch_table_t *t, const char *s, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISPATCH_H
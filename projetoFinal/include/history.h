@@ -0,0 +1,103 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/**
+ * @file history.h
+ * @brief Histórico em RAM dos últimos APP_HIST_LEN quadros (delta int16 por campo).
+ *
+ * Cada campo é quantizado (lux em 1 lx, temp/umidade em 0,01, percentual em 1%) e
+ * guardado como diferença para a amostra anterior. Inserção e min/max custam O(1)
+ * (min/max por blocos de APP_HIST_LEN / APP_HIST_BLOCKS quadros), independentemente
+ * do tamanho do histórico. Memória totalmente estática.
+ *
+ * O instante de cada quadro também é guardado (delta em ms) e cada quadro tem um
+ * índice absoluto crescente (não volta com o anel), usado como offset de retomada
+ * no dump do SerialRPC. Inserção e history_read_span() são protegidas por mutex;
+ * as demais leituras devem ser feitas pela mesma task que insere (display).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_ctx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HIST_LUX = 0,
+    HIST_TEMP,
+    HIST_HUM,
+    HIST_PERC,
+    HIST_FIELDS
+} hist_field_t;
+
+/**
+ * @brief Um quadro reconstruído (valores quantizados; ver history_scale()).
+ */
+typedef struct {
+    uint32_t idx;                 /**< índice absoluto */
+    uint32_t t_ms;                /**< instante (ms desde o boot) */
+    int32_t  v[HIST_FIELDS];
+} hist_sample_t;
+
+/**
+ * @brief Limpa o histórico e cria o mutex. Chamar em main(), antes das tasks.
+ */
+void history_init(void);
+
+/**
+ * @brief Acrescenta um quadro (descarta o mais antigo quando cheio).
+ */
+void history_push(const sensor_frame_t *f);
+
+/**
+ * @brief Quantidade de quadros guardados.
+ */
+uint16_t history_count(void);
+
+/**
+ * @brief Fator de escala do campo (valor real = quantizado / escala).
+ */
+int32_t history_scale(hist_field_t f);
+
+/**
+ * @brief Valor quantizado mais recente do campo (0 se vazio).
+ */
+int32_t history_latest(hist_field_t f);
+
+/**
+ * @brief Min/max quantizados da janela recente.
+ *
+ * A janela cobre entre APP_HIST_LEN - bloco e APP_HIST_LEN quadros (granularidade de bloco).
+ * @return false se o histórico está vazio.
+ */
+bool history_minmax(hist_field_t f, int32_t *mn, int32_t *mx);
+
+/**
+ * @brief Lê as n amostras mais recentes do campo (out[0] = mais antiga).
+ * @return Quantidade efetivamente lida (<= n).
+ */
+uint16_t history_read_recent(hist_field_t f, int32_t *out, uint16_t n);
+
+/**
+ * @brief Faixa de índices absolutos guardados: [*first, *next).
+ */
+void history_span(uint32_t *first, uint32_t *next);
+
+/**
+ * @brief Lê até n quadros a partir do índice absoluto `from` (em ordem crescente).
+ *
+ * Se `from` já saiu do anel, começa no mais antigo (out[0].idx mostra o salto).
+ * Parte da âncora do bloco de `from`: custa O(bloco + n), não O(APP_HIST_LEN).
+ * Pode ser chamada de qualquer task.
+ * @return Quantidade lida (0 se from >= next).
+ */
+uint16_t history_read_span(uint32_t from, hist_sample_t *out, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HISTORY_H
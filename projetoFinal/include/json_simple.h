@@ -3,21 +3,117 @@
 
 /**
  * @file json_simple.h
- * @brief Parser JSON simples (sem biblioteca externa).
+ * @brief Tokenizador JSON de passada única, sem alocação e reentrante.
  *
- * Observação: este parser é propositalmente simples e assume payloads pequenos e bem-formados.
- * Ele procura por "chaves" e extrai string/int. Não valida JSON completo.
+ * json_parse() percorre o texto uma vez e preenche um vetor de tokens fornecido pelo
+ * chamador (offsets no texto original, nada é copiado). As buscas json_doc_get_*()
+ * consideram apenas chaves do objeto raiz, então uma chave que aparece dentro de um
+ * valor string ou de um objeto aninhado não casa por engano. Várias chaves podem ser
+ * buscadas sobre o mesmo documento sem reprocessar o texto.
  */
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define JSON_MAX_TOKENS_DEFAULT 32   /**< Suficiente para os comandos/respostas do projeto. */
+
+typedef enum {
+    JSON_TOK_OBJECT = 0,
+    JSON_TOK_ARRAY,
+    JSON_TOK_STRING,
+    JSON_TOK_PRIMITIVE   /**< número, true, false, null */
+} json_tok_type_t;
+
+typedef enum {
+    JSON_ERR_NOMEM = -1,   /**< Tokens insuficientes. */
+    JSON_ERR_INVAL = -2,   /**< JSON malformado. */
+    JSON_ERR_PART  = -3    /**< Texto terminou no meio de um valor. */
+} json_err_t;
+
+/**
+ * @brief Token: intervalo [start, end) no texto (strings sem as aspas).
+ */
+typedef struct {
+    uint8_t  type;     /**< json_tok_type_t */
+    int16_t  parent;   /**< índice do token pai (-1 na raiz) */
+    uint16_t start;
+    uint16_t end;
+    uint16_t size;     /**< filhos diretos (pares chave/valor contam 1 por chave) */
+} json_tok_t;
+
+/**
+ * @brief Documento analisado (texto + tokens do chamador).
+ */
+typedef struct {
+    const char *json;
+    const json_tok_t *toks;
+    int count;
+} json_doc_t;
+
+/**
+ * @brief Analisa o texto em uma passada.
+ * @param doc       Saída: documento para as buscas.
+ * @param json      Texto JSON (não precisa terminar em '\0' se len for informado).
+ * @param len       Tamanho do texto (ou strlen).
+ * @param toks      Vetor de tokens do chamador.
+ * @param max_toks  Capacidade do vetor.
+ * @return Quantidade de tokens (>= 1) ou json_err_t (< 0).
+ */
+int json_parse(json_doc_t *doc, const char *json, size_t len, json_tok_t *toks, int max_toks);
+
+/**
+ * @brief Índice do token valor de uma chave do objeto raiz, ou -1.
+ */
+int json_doc_find(const json_doc_t *doc, const char *key);
+
+/**
+ * @brief Percorre os membros do objeto raiz, em ordem.
+ * @param iter  Cursor (iniciar em 0).
+ * @param key   Saída: início do nome da chave (sem aspas, não termina em '\0').
+ * @param klen  Saída: tamanho do nome.
+ * @return Índice do token valor, ou -1 ao terminar.
+ */
+int json_doc_next_member(const json_doc_t *doc, int *iter, const char **key, size_t *klen);
+
+/**
+ * @brief Copia (com unescape básico) o token string idx; false se vazio ou não string.
+ */
+bool json_doc_tok_string(const json_doc_t *doc, int idx, char *out, size_t outsz);
+
+/**
+ * @brief Inteiro do token idx (primitivo ou string numérica).
+ */
+bool json_doc_tok_int(const json_doc_t *doc, int idx, int *out);
+
+/**
+ * @brief Extrai o valor string (não vazio) de uma chave do objeto raiz.
+ */
+bool json_doc_get_string(const json_doc_t *doc, const char *key, char *out, size_t outsz);
+
+/**
+ * @brief Extrai o valor inteiro de uma chave do objeto raiz (aceita também "123" entre aspas).
+ */
+bool json_doc_get_int(const json_doc_t *doc, const char *key, int *out);
+
+/**
+ * @brief Extrai o valor true/false de uma chave do objeto raiz.
+ */
+bool json_doc_get_bool(const json_doc_t *doc, const char *key, bool *out);
+
+/**
+ * @brief Compara o valor string de uma chave com um literal, sem copiar.
+ */
+bool json_doc_string_eq(const json_doc_t *doc, const char *key, const char *value);
+
 /**
  * @brief Extrai o valor de uma chave JSON do tipo string.
+ *
+ * Conveniência para uma única chave (analisa o texto a cada chamada).
  * @param json     Texto JSON.
  * @param key      Nome da chave (sem aspas).
  * @param out      Buffer de saída.
@@ -28,6 +124,8 @@ bool json_get_string(const char *json, const char *key, char *out, size_t outsz)
 
 /**
  * @brief Extrai o valor de uma chave JSON do tipo inteiro.
+ *
+ * Conveniência para uma única chave (analisa o texto a cada chamada).
  * @param json     Texto JSON.
  * @param key      Nome da chave (sem aspas).
  * @param out      Ponteiro para receber o inteiro.
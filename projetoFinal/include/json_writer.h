@@ -0,0 +1,86 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+/**
+ * @file json_writer.h
+ * @brief Escritor JSON em streaming: cada pedaço vai direto para um "sink".
+ *
+ * Não há buffer intermediário nem limite de tamanho no escritor; quem define onde
+ * os bytes vão é o sink (contador, buffer/pbuf, stdout/USB). Números são formatados
+ * sem printf (ponto fixo), o que também evita o custo do %f do newlib.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Destino dos bytes. Retorna quantos bytes aceitou (menos que len = erro).
+ */
+typedef size_t (*json_sink_fn)(void *arg, const char *data, size_t len);
+
+typedef struct {
+    json_sink_fn sink;
+    void  *arg;
+    size_t len;     /**< bytes emitidos até agora */
+    bool   comma;   /**< próximo membro precisa de ',' */
+    bool   err;     /**< algum sink recusou bytes */
+} json_writer_t;
+
+/**
+ * @brief Sink de buffer contíguo (ex.: payload de um pbuf PBUF_RAM).
+ */
+typedef struct {
+    char  *buf;
+    size_t cap;
+    size_t len;
+} json_buf_sink_t;
+
+void json_w_init(json_writer_t *w, json_sink_fn sink, void *arg);
+
+void json_w_begin(json_writer_t *w);                       /**< '{' */
+void json_w_end(json_writer_t *w);                         /**< '}' */
+void json_w_begin_obj(json_writer_t *w, const char *key);  /**< "key":{ */
+void json_w_begin_arr(json_writer_t *w, const char *key);  /**< "key":[ */
+void json_w_end_arr(json_writer_t *w);                     /**< ']' */
+
+void json_w_str(json_writer_t *w, const char *key, const char *val);
+void json_w_uint(json_writer_t *w, const char *key, uint32_t val);
+void json_w_int(json_writer_t *w, const char *key, int32_t val);
+void json_w_bool(json_writer_t *w, const char *key, bool val);
+
+/**
+ * @brief Número em ponto fixo com `decimals` casas (0..6); NaN/inf viram null.
+ */
+void json_w_fixed(json_writer_t *w, const char *key, float val, uint8_t decimals);
+
+/**
+ * @brief Bytes literais (já em JSON), sem separador.
+ *
+ * Nas funções de membro, key = NULL escreve um elemento de array.
+ */
+void json_w_raw(json_writer_t *w, const char *data, size_t len);
+
+/**
+ * @brief Membro cujo valor já está em JSON (ex.: "id" copiado do pedido).
+ */
+void json_w_member_raw(json_writer_t *w, const char *key, const char *data, size_t len);
+
+/** @brief Sink que só conta bytes (arg ignorado): mede o tamanho antes de alocar. */
+size_t json_sink_count(void *arg, const char *data, size_t len);
+
+/** @brief Sink de buffer (arg = json_buf_sink_t*). */
+size_t json_sink_buf(void *arg, const char *data, size_t len);
+
+/** @brief Sink stdout (USB CDC / UART via stdio), arg ignorado. */
+size_t json_sink_stdout(void *arg, const char *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,48 @@
+#ifndef LUMINAIRE_H
+#define LUMINAIRE_H
+
+/**
+ * @file luminaire.h
+ * @brief Canais de luminária WS2812 (até 8 fitas em pio0/pio1, envio paralelo via DMA).
+ *
+ * Cada canal ocupa uma state machine livre (pio0 primeiro, depois pio1) e um canal
+ * de DMA alimentado pelo DREQ do TX FIFO. luminaire_show() dispara todos os canais
+ * ao mesmo tempo, então o tempo de quadro é o da fita mais longa, não a soma.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Inicializa os canais definidos em APP_LUM_CHANNEL_PINS / APP_LUM_CHANNEL_LEDS.
+ * @return Quantidade de canais efetivamente inicializados (0 se nenhum).
+ */
+uint8_t luminaire_init(void);
+
+/**
+ * @brief Quantidade de canais ativos.
+ */
+uint8_t luminaire_channel_count(void);
+
+/**
+ * @brief Define a mesma cor (GRB) para todos os LEDs do canal.
+ *
+ * Só altera o buffer; o envio acontece em luminaire_show().
+ */
+void luminaire_set_channel_color(uint8_t ch, uint32_t pixel_grb);
+
+/**
+ * @brief Dispara o envio de todos os canais em paralelo (DMA).
+ * @return false se o quadro anterior ainda está em transmissão (quadro descartado).
+ */
+bool luminaire_show(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LUMINAIRE_H
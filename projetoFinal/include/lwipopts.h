@@ -24,6 +24,10 @@
 #ifndef LWIP_MQTT
 #define LWIP_MQTT                   1
 #endif
+// Ring de saída do cliente MQTT (padrão 256): cabe a telemetria completa + tópico
+#ifndef MQTT_OUTPUT_RINGBUF_SIZE
+#define MQTT_OUTPUT_RINGBUF_SIZE    512
+#endif
 
 // ===== Memória lwIP (não exagere senão estoura .bss)
 #ifndef MEM_SIZE
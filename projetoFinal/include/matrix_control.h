@@ -3,11 +3,15 @@
 
 /**
  * @file matrix_control.h
- * @brief Controle do modo AUTO/MANUAL, alvo e fading de brilho para a matriz WS2812.
+ * @brief Controle do modo AUTO/MANUAL, alvo e fading de brilho por canal da luminária.
  */
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "json_simple.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -17,6 +21,37 @@ typedef enum {
     MATRIX_MODE_MANUAL = 1
 } matrix_mode_t;
 
+/** @name Campos presentes em matrix_cmd_t::flags */
+/**@{*/
+#define MATRIX_CMD_F_MODE      0x01u   /**< "mode" válido em matrix_cmd_t::mode */
+#define MATRIX_CMD_F_MODE_BAD  0x02u   /**< "mode" presente, mas desconhecido */
+#define MATRIX_CMD_F_PERCENT   0x04u   /**< matrixPercent/brightness/percent */
+#define MATRIX_CMD_F_CHANNEL   0x08u   /**< "channel" */
+/**@}*/
+
+/**
+ * @brief Chaves aceitas nos comandos (índices na tabela de hash perfeito).
+ */
+typedef enum {
+    MATRIX_KEY_NONE = -1,
+    MATRIX_KEY_MODE = 0,
+    MATRIX_KEY_MATRIX_PERCENT,
+    MATRIX_KEY_BRIGHTNESS,
+    MATRIX_KEY_PERCENT,
+    MATRIX_KEY_CHANNEL,
+    MATRIX_KEY_COUNT
+} matrix_key_t;
+
+/**
+ * @brief Comando já decodificado (independente de texto/transporte).
+ */
+typedef struct {
+    uint8_t flags;     /**< MATRIX_CMD_F_* */
+    uint8_t mode;      /**< matrix_mode_t */
+    int16_t channel;
+    int32_t percent;   /**< sem saturação; aplicada em matrix_control_apply_cmd() */
+} matrix_cmd_t;
+
 /**
  * @brief Inicializa o controlador (modo AUTO, 100%).
  */
@@ -28,20 +63,52 @@ void matrix_control_init(void);
  * Payloads esperados (exemplos):
  *   {"mode":"auto"}
  *   {"mode":"manual","matrixPercent":80}
+ *   {"channel":2,"matrixPercent":40}   (só o canal 2; sem "channel" = todos)
  * Também aceita chaves alternativas: "brightness" ou "percent".
  *
  * @param payload JSON como string.
  */
 void matrix_control_apply_cmd_payload(const char *payload);
 
+/**
+ * @brief Igual a matrix_control_apply_cmd_payload(), sobre um documento já analisado.
+ *
+ * Evita reprocessar o texto quando o chamador já fez json_parse() (ex.: SerialRPC).
+ */
+void matrix_control_apply_cmd_doc(const json_doc_t *doc);
+
+/**
+ * @brief Identifica o nome de uma chave de comando (hash perfeito, O(1)).
+ * @param name Nome sem aspas (não precisa terminar em '\0').
+ */
+matrix_key_t matrix_control_key_lookup(const char *name, size_t len);
+
+/**
+ * @brief Grava no comando o valor de uma chave (texto bruto do valor, sem aspas).
+ *
+ * Regra única para os dois parsers (documento e streaming): "mode" só aceita string,
+ * números aceitam também string numérica e matrixPercent > brightness > percent.
+ * @param pct_rank Estado da precedência de percent (iniciar em 0 a cada comando).
+ */
+void matrix_control_cmd_field(matrix_cmd_t *cmd, uint8_t *pct_rank, matrix_key_t key,
+                              const char *val, size_t len, bool is_string);
+
+/**
+ * @brief Aplica um comando já decodificado (ex.: pelo parser incremental do MQTT).
+ *
+ * Com "channel" fora de [0, APP_LUM_CHANNEL_COUNT) o comando inteiro é recusado
+ * (nem o modo muda).
+ */
+void matrix_control_apply_cmd(const matrix_cmd_t *cmd);
+
 /**
  * @brief Atualiza o brilho (com fading) a partir do lux filtrado.
  *
- * - Em modo MANUAL: segue o target (0..100).
- * - Em modo AUTO: calcula percent invertido do lux (APP_LUX_MIN..APP_LUX_MAX).
+ * - Em modo MANUAL: cada canal segue o seu target (0..100).
+ * - Em modo AUTO: calcula percent invertido do lux (APP_LUX_MIN..APP_LUX_MAX) para todos.
  *
  * @param lux_filtered Lux após filtragem (EMA).
- * @return Percentual atual aplicado (0..100).
+ * @return Percentual atual aplicado no canal 0 (0..100).
  */
 uint8_t matrix_control_update_from_lux(float lux_filtered);
 
@@ -51,15 +118,30 @@ uint8_t matrix_control_update_from_lux(float lux_filtered);
 matrix_mode_t matrix_control_get_mode(void);
 
 /**
- * @brief Retorna alvo manual (0..100).
+ * @brief Retorna alvo manual do canal 0 (0..100).
  */
 uint8_t matrix_control_get_target_percent(void);
 
 /**
- * @brief Retorna percentual atualmente aplicado (0..100).
+ * @brief Retorna percentual atualmente aplicado no canal 0 (0..100).
  */
 uint8_t matrix_control_get_current_percent(void);
 
+/**
+ * @brief Retorna alvo manual de um canal (0..100).
+ */
+uint8_t matrix_control_get_channel_target(uint8_t ch);
+
+/**
+ * @brief Retorna percentual aplicado (com fade) de um canal (0..100).
+ */
+uint8_t matrix_control_get_channel_percent(uint8_t ch);
+
+/**
+ * @brief Define o alvo manual de um canal (não altera o modo).
+ */
+void matrix_control_set_channel_target(uint8_t ch, uint8_t percent);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,8 +7,10 @@
  *  - conexão/reconexão
  *  - subscribe em tópico de comando
  *  - publish de telemetria com QoS/ACK (opcional)
+ *  - fila de saída limitada: a telemetria só sai da fila com o PUBACK e o que ficou
+ *    sem confirmação é reenviado, na ordem, após a reconexão
  *
- * Observação: callbacks do lwIP não devem usar APIs do FreeRTOS.
+ * Observação: callbacks do lwIP rodam em IRQ; só usam as variantes FromISR do FreeRTOS.
  */
 
 #include <stdbool.h>
@@ -21,10 +23,45 @@
 #include "lwip/apps/mqtt.h"
 #include "lwip/ip_addr.h"
 
+#include "app_config.h"
+#include "cmd_parser.h"
+#include "cmd_ring.h"
+#include "sensor_frame.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Estado de uma telemetria na fila de saída.
+ */
+typedef enum {
+    MQTT_OUT_QUEUED = 0,   /**< a enviar (nova, ou reenvio após reconexão) */
+    MQTT_OUT_SENT,         /**< entregue ao lwIP, aguardando PUBACK */
+    MQTT_OUT_ACKED,        /**< confirmada; sai da fila quando chegar à frente */
+    MQTT_OUT_FAILED        /**< o lwIP desistiu (timeout/erro): reenvia na próxima conexão */
+} mqtt_out_state_t;
+
+typedef struct {
+    sensor_frame_t    frame;
+    TickType_t        sent_at;
+    volatile uint8_t  state;   // mqtt_out_state_t; SENT -> ACKED/FAILED no callback do lwIP
+    uint8_t           sends;   // publishes deste frame (> 1 = reenvio)
+} mqtt_out_entry_t;
+
+/**
+ * @brief Fila circular de telemetria QoS1 ainda sem PUBACK (ordem de seq).
+ */
+typedef struct {
+    mqtt_out_entry_t e[APP_MQTT_INFLIGHT_LEN];
+    uint32_t head;        // mais antiga
+    uint32_t count;
+    uint32_t last_seq;    // último frame enfileirado
+    uint32_t acked;
+    uint32_t resent;      // publishes repetidos após reconexão
+    uint32_t lost;        // descartados com a fila cheia
+} mqtt_outbox_t;
+
 typedef struct {
     mqtt_client_t *client;
 
@@ -34,25 +71,24 @@ typedef struct {
     volatile bool need_subscribe;
     volatile bool conn_event;
     volatile int  conn_status;
+    volatile bool dns_suspect;    // tentativa falhou: revalida o endereço do broker
 
-    // comando RX (preenchido em callbacks)
-    volatile bool     cmd_ready;
-    volatile uint16_t cmd_len;
-    char cmd_buf[256];
-    char cmd_topic[96];
-
-    // publish ACK
-    volatile bool pub_done;
-    volatile err_t pub_err;
+    // comando RX (decodificado em streaming nos callbacks, sem cópia do payload)
+    cmd_parser_t       cmd_parser;
+    bool               cmd_skip;      // mensagem atual não é do tópico de comando / já falhou
+    cmd_ring_t         cmd_ring;      // callbacks -> task, sem perda (funde no overflow)
+    volatile uint32_t  cmd_errors;    // payloads malformados/incompletos descartados
 
     // identificação / tópicos
     char device_id[32];
     char topic_tele[96];
     char topic_cmd[96];
 
-    // controle de reconexão / seq
-    TickType_t last_attempt;
+    // seq
     uint32_t   last_sent_seq;
+
+    // telemetria aguardando PUBACK
+    mqtt_outbox_t out;
 } mqtt_app_t;
 
 /**
@@ -75,18 +111,35 @@ bool mqtt_app_connect_once(mqtt_app_t *m);
 bool mqtt_app_subscribe_cmd(mqtt_app_t *m);
 
 /**
- * @brief Publica um frame (telemetria) no tópico de telemetry.
- * @param m  módulo.
- * @param f  ponteiro para frame.
- * @return true se publish ok (e ACK ok quando QoS>0); false caso falhe.
+ * @brief Põe um frame na fila de saída (conectado ou não); ignora seq repetido.
+ *
+ * Com a fila cheia descarta o mais antigo que não esteja aguardando PUBACK
+ * (ou o próprio frame, se todos estiverem) e conta em out.lost.
+ * @return true se o frame entrou na fila.
+ */
+bool mqtt_app_queue_telemetry(mqtt_app_t *m, const sensor_frame_t *fr);
+
+/**
+ * @brief Retira os confirmados e publica os pendentes, em ordem, sem esperar PUBACK.
+ *
+ * Cada frame vira JSON (esquema de telemetry_json.h) direto no payload de um pbuf do
+ * tamanho exato. Para quando o lwIP não aceita mais (ring/requisições cheios); o
+ * PUBACK acorda a task que chamou esta função para continuar.
+ * @return false se um PUBACK passou de APP_MQTT_ACK_TIMEOUT_MS ou o publish falhou:
+ *         a conexão deve ser derrubada (mqtt_app_drop) e a fila é reenviada na próxima.
+ */
+bool mqtt_app_flush_telemetry(mqtt_app_t *m);
+
+/**
+ * @brief Derruba a conexão (o lwIP descarta as requisições pendentes) e zera os flags.
  */
-bool mqtt_app_publish_frame(mqtt_app_t *m, const void *f, size_t f_sz, uint32_t seq, TickType_t tick);
+void mqtt_app_drop(mqtt_app_t *m);
 
 /**
- * @brief Se existir comando pendente, copia topic/payload e limpa flag.
+ * @brief Retira o próximo comando pendente (chamar em laço até retornar false).
  * @return true se havia comando; false caso contrário.
  */
-bool mqtt_app_take_cmd(mqtt_app_t *m, char *topic_out, size_t topic_sz, char *payload_out, size_t payload_sz);
+bool mqtt_app_take_cmd(mqtt_app_t *m, matrix_cmd_t *out);
 
 #ifdef __cplusplus
 }
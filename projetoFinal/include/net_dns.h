@@ -3,7 +3,20 @@
 
 /**
  * @file net_dns.h
- * @brief Resolução DNS (lwIP) em modo threadsafe_background.
+ * @brief Resolução DNS (lwIP) com cache e revalidação em segundo plano.
+ *
+ * Cada host tem uma entrada no cache, que também é o contexto da consulta em
+ * andamento (argumento do callback do lwIP): não há estado global compartilhado
+ * entre chamadas, e várias tasks podem esperar pelo mesmo host.
+ *
+ * Validade: APP_DNS_TTL_MS (o callback do lwIP não informa o TTL da resposta; o
+ * cache interno do lwIP continua respeitando o TTL real). Vencida a validade, o
+ * endereço antigo ainda é devolvido na hora ("stale-while-revalidate") e uma nova
+ * consulta é disparada em segundo plano, por até APP_DNS_STALE_MAX_MS.
+ *
+ * A conclusão acorda as tasks em espera por notificação (sem polling), no índice
+ * NET_DNS_NOTIFY_INDEX: o índice 0 continua livre para os outros avisos da task
+ * (ex.: enlace no ar para vTaskMqtt) sem que um consuma o do outro.
  */
 
 #include <stdbool.h>
@@ -15,10 +28,38 @@
 extern "C" {
 #endif
 
+#define NET_DNS_NOTIFY_INDEX 1u   /**< índice de notificação da task usado pelo DNS */
+
+typedef enum {
+    NET_DNS_HIT = 0,    /**< endereço válido do cache */
+    NET_DNS_STALE,      /**< endereço vencido (utilizável); revalidação disparada */
+    NET_DNS_PENDING,    /**< consulta em andamento; a task chamadora será notificada */
+    NET_DNS_FAIL        /**< falha recente (cache negativo) ou sem entrada livre */
+} net_dns_result_t;
+
+/**
+ * @brief Consulta sem bloquear.
+ *
+ * Em NET_DNS_PENDING a task chamadora fica registrada e recebe xTaskNotifyGiveIndexed
+ * (NET_DNS_NOTIFY_INDEX) ao fim da consulta (sucesso ou falha); basta chamar de novo
+ * para ler o resultado.
+ * @param out  Saída: IP (em HIT/STALE).
+ */
+net_dns_result_t net_dns_lookup(const char *host, ip_addr_t *out);
+
+/**
+ * @brief Marca o endereço do host como vencido (ex.: conexão recusada).
+ *
+ * A próxima consulta ainda o devolve, mas já dispara a revalidação.
+ */
+void net_dns_expire(const char *host);
+
 /**
  * @brief Resolve um hostname em ip_addr_t usando lwIP DNS.
  *
- * Esta função é bloqueante (com timeout) e usa cyw43_arch_lwip_begin/end.
+ * Retorna na hora com o cache (válido ou vencido); senão bloqueia a task
+ * (notificação, não polling) até a resposta ou o timeout. Pode ser chamada por
+ * várias tasks ao mesmo tempo.
  *
  * @param host        Hostname (ex.: "broker.hivemq.com").
  * @param out         Saída: IP resolvido.
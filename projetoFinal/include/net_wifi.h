@@ -3,20 +3,71 @@
 
 /**
  * @file net_wifi.h
- * @brief Inicialização do Wi-Fi (Pico W / cyw43).
+ * @brief Gerenciador do link Wi-Fi (Pico W / cyw43) em task própria.
+ *
+ * O cyw43 é iniciado e associado depois que o escalonador já está rodando, sem
+ * bloquear o boot: sensores, LEDs e OLED funcionam sem rede. Máquina de estados:
+ *
+ *   INIT -> JOINING -> UP -> (link caiu) -> JOINING ...
+ *             \-> falha/timeout -> BACKOFF -> JOINING
+ *
+ * JOINING tenta primeiro o caminho rápido (BSSID + canal da última associação, de
+ * net_wifi_store; sem varredura) e, se falhar, a associação completa. O endereço vem
+ * do DHCP, ou é fixo (APP_WIFI_STATIC_IP / APP_WIFI_PIN_LEASE), sem DHCP.
+ *
+ * Subida e queda do link são avisadas pelo callback de eventos (na task do link).
+ * O lwIP só existe depois de INIT: nenhuma outra task deve usá-lo antes de
+ * net_wifi_is_up() (ou do evento NET_WIFI_EV_UP).
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef enum {
+    NET_WIFI_INIT = 0,   /**< cyw43 ainda não iniciado */
+    NET_WIFI_JOINING,    /**< associação + DHCP em andamento */
+    NET_WIFI_UP,         /**< com IP */
+    NET_WIFI_BACKOFF     /**< falhou; espera para tentar de novo */
+} net_wifi_state_t;
+
+typedef enum {
+    NET_WIFI_EV_UP = 0,
+    NET_WIFI_EV_DOWN
+} net_wifi_event_t;
+
+typedef void (*net_wifi_event_fn)(net_wifi_event_t ev, void *arg);
+
+typedef struct {
+    uint32_t joins;          /**< associações bem-sucedidas */
+    uint32_t fails;          /**< tentativas que falharam (timeout/erro) */
+    uint32_t drops;          /**< quedas depois de UP */
+    uint32_t boot_up_ms;     /**< boot -> primeiro IP (0 = ainda não) */
+    uint32_t last_join_ms;   /**< início da tentativa -> IP, na última associação */
+    uint32_t fast_joins;     /**< associações pelo caminho rápido */
+    uint32_t fast_fails;     /**< caminho rápido que caiu para a varredura */
+    uint32_t fast_ip_ms;     /**< tempo até IP na última associação rápida */
+    uint32_t full_ip_ms;     /**< tempo até IP na última associação completa */
+} net_wifi_stats_t;
+
+/**
+ * @brief Callback de eventos do link (chamado na task do link). Chamar antes do escalonador.
+ */
+void net_wifi_set_event_callback(net_wifi_event_fn fn, void *arg);
+
+net_wifi_state_t net_wifi_state(void);
+
+static inline bool net_wifi_is_up(void) { return net_wifi_state() == NET_WIFI_UP; }
+
+void net_wifi_get_stats(net_wifi_stats_t *out);
+
 /**
- * @brief Inicializa Wi-Fi, entra em STA mode e conecta com timeout.
- * @return true se conectado; false caso falhe.
+ * @brief Task do gerenciador de link (fixa no core 0: as IRQs do cyw43 ficam nele).
  */
-bool net_wifi_init_and_connect(void);
+void vTaskWifi(void *pvParameters);
 
 #ifdef __cplusplus
 }
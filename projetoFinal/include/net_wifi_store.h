@@ -0,0 +1,51 @@
+#ifndef NET_WIFI_STORE_H
+#define NET_WIFI_STORE_H
+
+/**
+ * @file net_wifi_store.h
+ * @brief Dados da última associação Wi-Fi guardados no último setor da flash.
+ *
+ * Usados pelo net_wifi para reentrar sem varredura (BSSID + canal) e, opcionalmente,
+ * sem DHCP (último lease reaproveitado como endereço fixo).
+ * O registro só vale para o SSID configurado (hash) e só é regravado quando muda.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t ssid_hash;      /**< FNV-1a do SSID em que o registro foi obtido */
+    uint8_t  bssid[6];
+    uint8_t  channel;        /**< 0 = desconhecido (join só pelo BSSID) */
+    uint8_t  has_lease;      /**< ip/mask/gw/dns válidos */
+    uint32_t ip;             /**< IPv4 em ordem de rede (ip4_addr_get_u32) */
+    uint32_t mask;
+    uint32_t gw;
+    uint32_t dns;
+} net_wifi_store_t;
+
+/** @brief FNV-1a de uma string (identifica o SSID sem guardá-lo). */
+uint32_t net_wifi_store_hash(const char *s);
+
+/**
+ * @brief Lê o registro; false se ausente, corrompido ou de outro SSID.
+ */
+bool net_wifi_store_load(const char *ssid, net_wifi_store_t *out);
+
+/**
+ * @brief Grava o registro se diferente do atual (apaga + programa um setor).
+ *
+ * Usa flash_safe_execute(): o outro core e as IRQs param durante a escrita (~50 ms).
+ * @return true se gravou ou já estava igual.
+ */
+bool net_wifi_store_save(const net_wifi_store_t *rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_WIFI_STORE_H
@@ -0,0 +1,33 @@
+#ifndef OLED_TREND_H
+#define OLED_TREND_H
+
+/**
+ * @file oled_trend.h
+ * @brief Páginas de tendência do OLED: sparkline + valor atual + min/max de um campo do histórico.
+ *
+ * Ao entrar na página o gráfico é desenhado inteiro (últimas 128 amostras). Depois, a cada
+ * quadro, a área do gráfico é deslocada 1 coluna e só a coluna nova é desenhada; o redesenho
+ * completo só acontece se a escala (min/max do histórico) mudar.
+ */
+
+#include "history.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Limpa a tela e desenha a página de tendência do campo.
+ */
+void oled_trend_enter(hist_field_t f);
+
+/**
+ * @brief Atualiza a página atual com a amostra mais recente do histórico.
+ */
+void oled_trend_update(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OLED_TREND_H
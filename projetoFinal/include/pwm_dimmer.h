@@ -0,0 +1,56 @@
+#ifndef PWM_DIMMER_H
+#define PWM_DIMMER_H
+
+/**
+ * @file pwm_dimmer.h
+ * @brief Saída de dimerização por PWM de hardware (16 bits) para drivers de LED reais.
+ *
+ * Cada canal PWM segue o percentual (com fade) do canal correspondente em matrix_control.
+ * O percentual é convertido por curva CIE 1931 (luminosidade percebida) para um duty de
+ * 16 bits. Os novos duties são publicados em buffer duplo e gravados nos registradores
+ * dentro da IRQ de wrap do PWM, nunca no meio de um período.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief TOP = 0xFFFE -> período de 65535 contagens. */
+#define PWM_DIMMER_TOP       0xFFFEu
+
+/** @brief Nível de compare que corresponde a 100% (saída sempre ligada). */
+#define PWM_DIMMER_LEVEL_MAX 0xFFFFu
+
+/**
+ * @brief Inicializa slices/pinos de APP_PWM_CHANNEL_PINS e a IRQ de wrap.
+ * @return Quantidade de canais ativos (0 se APP_PWM_ENABLE == 0).
+ */
+uint8_t pwm_dimmer_init(void);
+
+/**
+ * @brief Converte percentual (0..100) em nível de compare de 16 bits (curva CIE 1931).
+ *
+ * 0 -> 0 (desligado) e 100 -> PWM_DIMMER_LEVEL_MAX. Função pura, sem acesso a hardware
+ * (pwm_dimmer_curve.c; testada no host por tools/pwm_duty_test.cpp).
+ */
+uint16_t pwm_dimmer_duty_from_percent(uint8_t percent_0_100);
+
+/**
+ * @brief Define o percentual do canal (aplicado no próximo pwm_dimmer_commit()).
+ */
+void pwm_dimmer_set_channel_percent(uint8_t ch, uint8_t percent_0_100);
+
+/**
+ * @brief Publica os duties pendentes para a IRQ de wrap.
+ * @return false se a publicação anterior ainda não foi consumida (tenta no próximo ciclo).
+ */
+bool pwm_dimmer_commit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PWM_DIMMER_H
@@ -0,0 +1,39 @@
+#ifndef SENSOR_FRAME_H
+#define SENSOR_FRAME_H
+
+/**
+ * @file sensor_frame.h
+ * @brief Frame agregado de sensores (display -> MQTT/SerialRPC/histórico).
+ */
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Frame agregado de sensores para telemetria / display.
+ *
+ * Leva também o estado da luminária no instante do frame: quem serializa o mesmo
+ * frame duas vezes (contagem + escrita) ou o reenvia depois gera o mesmo texto.
+ */
+typedef struct sensor_frame {
+    float lux;
+    float luxPercLum;
+    float temp;
+    float hum;
+    uint32_t seq;
+    TickType_t tick;
+    uint8_t mode;        /**< matrix_mode_t */
+    uint8_t target;      /**< alvo manual do canal 0 (0..100) */
+    uint8_t current;     /**< aplicado no canal 0 (0..100) */
+} sensor_frame_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_FRAME_H
@@ -0,0 +1,121 @@
+#ifndef SERIAL_BIN_H
+#define SERIAL_BIN_H
+
+/**
+ * @file serial_bin.h
+ * @brief Modo binário do SerialRPC: quadros COBS + CRC-16 (usado no firmware e no host).
+ *
+ * Quadro no fio:  0x00 | COBS( tipo | payload | crc16 LE ) | 0x00
+ *
+ * O 0x00 inicial fecha qualquer resto de quadro ou texto que tenha chegado antes; esse
+ * lixo vira um "quadro" que falha no CRC e é descartado pelo receptor, sem corromper o
+ * seguinte.
+ * CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) sobre tipo + payload.
+ * Campos multibyte são little-endian; os layouts abaixo são os bytes do payload.
+ *
+ * Negociação: em modo texto, {"op":"binary"} -> ack JSON e troca para binário.
+ * SERIAL_BIN_T_TEXT volta para JSON.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SERIAL_BIN_PAYLOAD_MAX  64u
+/** Pior caso codificado: tipo + payload + CRC + overhead COBS + dois delimitadores. */
+#define SERIAL_BIN_WIRE_MAX     (1u + SERIAL_BIN_PAYLOAD_MAX + 2u + 2u + 2u)
+
+typedef enum {
+    // host -> dispositivo
+    SERIAL_BIN_T_PING      = 0x01,  /**< vazio -> ACK */
+    SERIAL_BIN_T_AUTH      = 0x02,  /**< senha (bytes, sem '\0') -> ACK */
+    SERIAL_BIN_T_CMD       = 0x03,  /**< serial_bin_cmd_t -> ACK */
+    SERIAL_BIN_T_TEXT      = 0x04,  /**< volta ao modo JSON -> ACK (ainda binário) */
+
+    // dispositivo -> host
+    SERIAL_BIN_T_ACK       = 0x80,  /**< u8 tipo do pedido, u8 status (serial_bin_status_t) */
+    SERIAL_BIN_T_TELEMETRY = 0x81,  /**< serial_bin_tele_t */
+    SERIAL_BIN_T_LUX       = 0x82   /**< u32 t_ms, i32 lux x100 */
+} serial_bin_type_t;
+
+typedef enum {
+    SERIAL_BIN_OK = 0,
+    SERIAL_BIN_E_AUTH,      /**< não autenticado / senha errada */
+    SERIAL_BIN_E_LEN,       /**< payload com tamanho errado */
+    SERIAL_BIN_E_TYPE,      /**< tipo desconhecido */
+    SERIAL_BIN_E_ARG        /**< campo inválido (ex.: modo ou bits de flags desconhecidos) */
+} serial_bin_status_t;
+
+/**
+ * @brief Telemetria compacta (21 bytes no fio).
+ */
+typedef struct {
+    uint32_t seq;
+    uint32_t t_ms;
+    int32_t  lux_x100;
+    uint16_t lux_perc_x10;
+    int16_t  temp_x100;
+    uint16_t hum_x100;
+    uint8_t  mode;       /**< matrix_mode_t */
+    uint8_t  target;
+    uint8_t  current;
+} serial_bin_tele_t;
+#define SERIAL_BIN_TELE_LEN 21u
+
+/**
+ * @brief Comando compacto (6 bytes no fio); mesmos campos de matrix_cmd_t.
+ *
+ * flags só com MATRIX_CMD_F_MODE/PERCENT/CHANNEL e mode <= MATRIX_MODE_MANUAL; fora
+ * disso o dispositivo responde SERIAL_BIN_E_ARG sem aplicar nada.
+ */
+typedef struct {
+    uint8_t flags;       /**< MATRIX_CMD_F_* */
+    uint8_t mode;
+    int16_t channel;
+    int16_t percent;
+} serial_bin_cmd_t;
+#define SERIAL_BIN_CMD_LEN 6u
+
+uint16_t serial_bin_crc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief COBS: codifica len bytes (out precisa de len + len/254 + 1).
+ * @return Bytes escritos (sem o 0x00 final).
+ */
+size_t serial_bin_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief COBS inverso; pode operar no mesmo buffer (out <= in).
+ * @return Bytes decodificados ou 0 se inválido.
+ */
+size_t serial_bin_cobs_decode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief Monta o quadro completo (delimitadores incluídos) em out[SERIAL_BIN_WIRE_MAX].
+ * @return Tamanho no fio ou 0 se o payload for grande demais.
+ */
+size_t serial_bin_frame(uint8_t type, const uint8_t *payload, size_t len, uint8_t *out);
+
+/**
+ * @brief Valida um quadro recebido (bytes entre dois 0x00), decodificando no lugar.
+ * @param type     Saída: tipo.
+ * @param payload  Saída: início do payload dentro de buf.
+ * @param plen     Saída: tamanho do payload.
+ * @return false se COBS ou CRC inválidos.
+ */
+bool serial_bin_unframe(uint8_t *buf, size_t len, uint8_t *type, const uint8_t **payload, size_t *plen);
+
+void serial_bin_put_tele(uint8_t out[SERIAL_BIN_TELE_LEN], const serial_bin_tele_t *t);
+void serial_bin_get_tele(const uint8_t in[SERIAL_BIN_TELE_LEN], serial_bin_tele_t *t);
+void serial_bin_put_cmd(uint8_t out[SERIAL_BIN_CMD_LEN], const serial_bin_cmd_t *c);
+void serial_bin_get_cmd(const uint8_t in[SERIAL_BIN_CMD_LEN], serial_bin_cmd_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERIAL_BIN_H
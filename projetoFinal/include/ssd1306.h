@@ -8,10 +8,43 @@
 #define SSD1306_WIDTH    128
 #define SSD1306_HEIGHT   64
 
+// Estatísticas do último refresh (só regiões alteradas são enviadas)
+typedef struct {
+    uint32_t bytes;   // bytes no barramento I2C (inclui endereço/controle)
+    uint32_t us;      // do disparo até o fim do DMA
+    uint8_t  pages;   // páginas efetivamente enviadas
+} ssd1306_stats_t;
+
+// Chamado na IRQ do DMA quando o refresh assíncrono termina
+typedef void (*ssd1306_done_cb_t)(void *arg);
+
 void ssd1306_init(i2c_inst_t *i2c);
 void ssd1306_clear(void);
-void ssd1306_show(void);
-void ssd1306_draw_string(uint8_t x, uint8_t y, const char *text);
+void ssd1306_show(void);                 // bloqueante (usa o mesmo caminho DMA)
+bool ssd1306_show_start(void);           // assíncrono; false se nada mudou ou ainda ocupado
+bool ssd1306_busy(void);                 // não desenhe enquanto true: o DMA lê o framebuffer
+void ssd1306_show_abort(void);           // após timeout (ex.: NACK); força refresh completo
+void ssd1306_set_done_callback(ssd1306_done_cb_t cb, void *arg);
+void ssd1306_get_stats(ssd1306_stats_t *out);
+void ssd1306_draw_string(uint8_t x, uint8_t y, const char *text);  // colunas inteiras da fonte por vez
 void ssd1306_draw_pixel(uint8_t x, uint8_t y, bool color);
+void ssd1306_draw_vline(uint8_t x, uint8_t y0, uint8_t y1);
+void ssd1306_clear_pages(uint8_t page0, uint8_t page1);
+void ssd1306_scroll_left(uint8_t page0, uint8_t page1);      // 1 coluna; a última fica apagada; só colunas alteradas ficam sujas
+
+// Campo de texto retido: ssd1306_field_set() só redesenha os caracteres alterados.
+// Não usar ssd1306_clear() sobre campos retidos (chame ssd1306_field_invalidate()).
+#define SSD1306_FIELD_MAX_CHARS (SSD1306_WIDTH / 6)
+
+typedef struct {
+    uint8_t x, y;
+    uint8_t width;                           // largura em caracteres
+    bool    valid;                           // false = redesenha tudo no próximo set
+    char    text[SSD1306_FIELD_MAX_CHARS];   // conteúdo atual (sem terminador)
+} ssd1306_field_t;
+
+void ssd1306_field_init(ssd1306_field_t *f, uint8_t x, uint8_t y, uint8_t width_chars);
+void ssd1306_field_set(ssd1306_field_t *f, const char *text);
+void ssd1306_field_invalidate(ssd1306_field_t *f);
 
 #endif
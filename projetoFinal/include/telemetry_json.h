@@ -0,0 +1,63 @@
+#ifndef TELEMETRY_JSON_H
+#define TELEMETRY_JSON_H
+
+/**
+ * @file telemetry_json.h
+ * @brief Esquema único da telemetria (MQTT e SerialRPC usam a mesma função).
+ *
+ * Campos: device, lux, luxPercLum, temp, hum, seq, t_ms, mode, target, current.
+ * No SerialRPC o objeto leva também "op":"telemetry" (envelope do protocolo) e o
+ * cliente pode assinar só parte dos campos (máscara TELE_F_*).
+ */
+
+#include "app_ctx.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Campos da telemetria (bit = posição no esquema).
+ */
+typedef enum {
+    TELE_F_DEVICE     = 1u << 0,
+    TELE_F_LUX        = 1u << 1,
+    TELE_F_LUX_PERC   = 1u << 2,
+    TELE_F_TEMP       = 1u << 3,
+    TELE_F_HUM        = 1u << 4,
+    TELE_F_SEQ        = 1u << 5,
+    TELE_F_T_MS       = 1u << 6,
+    TELE_F_MODE       = 1u << 7,
+    TELE_F_TARGET     = 1u << 8,
+    TELE_F_CURRENT    = 1u << 9,
+    TELE_F_ALL        = (1u << 10) - 1u
+} telemetry_field_t;
+
+/**
+ * @brief Serializa um frame (mode/target/current vêm do próprio frame).
+ * @param op  Valor de "op" (ou NULL para omitir).
+ */
+void telemetry_json_write(json_writer_t *w, const char *op, const char *device_id, const sensor_frame_t *fr);
+
+/**
+ * @brief Igual a telemetry_json_write, mas só com os campos em `fields` (TELE_F_*).
+ */
+void telemetry_json_write_fields(json_writer_t *w, const char *op, const char *device_id,
+                                 const sensor_frame_t *fr, uint16_t fields);
+
+/**
+ * @brief Nome do campo (não terminado em '\0') -> bit TELE_F_*; 0 se desconhecido.
+ */
+uint16_t telemetry_json_field(const char *name, size_t len);
+
+/**
+ * @brief Escreve a máscara como array de nomes ("key":["lux",...]).
+ */
+void telemetry_json_write_field_names(json_writer_t *w, const char *key, uint16_t fields);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_JSON_H
@@ -0,0 +1,29 @@
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+/**
+ * @file tusb_config.h
+ * @brief TinyUSB: dispositivo composto com duas CDC (SerialRPC + log), ver usb_cdc.h.
+ *
+ * Substitui o pico_stdio_usb (uma CDC só). tud_task() roda na vTaskUsb e dorme na
+ * fila de eventos do TinyUSB (OSAL FreeRTOS), sem polling.
+ */
+
+#define CFG_TUSB_RHPORT0_MODE   (OPT_MODE_DEVICE)
+#define CFG_TUSB_OS             OPT_OS_FREERTOS
+
+#define CFG_TUD_ENABLED         1
+#define CFG_TUD_ENDPOINT0_SIZE  64
+
+#define CFG_TUD_CDC             2
+#define CFG_TUD_MSC             0
+#define CFG_TUD_HID             0
+#define CFG_TUD_MIDI            0
+#define CFG_TUD_VENDOR          0
+
+// FIFOs por interface: cada CDC tem as suas (o log cheio não atrasa o RPC)
+#define CFG_TUD_CDC_RX_BUFSIZE  256
+#define CFG_TUD_CDC_TX_BUFSIZE  1024
+#define CFG_TUD_CDC_EP_BUFSIZE  64
+
+#endif // TUSB_CONFIG_H
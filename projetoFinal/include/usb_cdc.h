@@ -0,0 +1,66 @@
+#ifndef USB_CDC_H
+#define USB_CDC_H
+
+/**
+ * @file usb_cdc.h
+ * @brief USB composto com duas CDC: canal do SerialRPC e canal de log/stdio.
+ *
+ * - CDC 0 ("SerialRPC"): só o protocolo; lido/escrito pela vTaskSerialRpc.
+ * - CDC 1 ("Log"): driver de stdio; printf, app_log e app_trace saem aqui.
+ *
+ * Cada interface tem suas próprias FIFOs de TX/RX. A escrita de log nunca bloqueia
+ * (o que não cabe é descartado e contado); a do RPC espera o host por um tempo
+ * limitado (APP_USB_RPC_TX_TIMEOUT_MS).
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t rpc_tx_drop;   /**< bytes do RPC descartados (host parado) */
+    uint32_t log_tx_drop;   /**< bytes de log descartados (FIFO cheia ou porta fechada) */
+} usb_cdc_stats_t;
+
+/**
+ * @brief Inicializa o TinyUSB e liga o driver de stdio na CDC de log.
+ */
+void usb_cdc_init(void);
+
+/**
+ * @brief Task do TinyUSB (tud_task). Prioridade acima das tasks de aplicação.
+ */
+void vTaskUsb(void *pvParameters);
+
+/**
+ * @brief Callback chamado (contexto da vTaskUsb) quando chegam bytes no RPC ou o
+ *        host abre a porta (DTR).
+ */
+void usb_rpc_set_rx_callback(void (*fn)(void *param), void *param);
+
+/** @brief Próximo byte recebido no RPC ou -1 se não há. */
+int usb_rpc_getc(void);
+
+/**
+ * @brief Escreve no RPC; espera espaço na FIFO até APP_USB_RPC_TX_TIMEOUT_MS.
+ * @return Bytes aceitos (o restante é descartado e contado).
+ */
+size_t usb_rpc_write(const void *data, size_t len);
+
+/** @brief Inicia a transmissão do que está na FIFO do RPC. */
+void usb_rpc_flush(void);
+
+/** @brief Consome o evento "host abriu a porta do RPC" (para reenviar o hello). */
+bool usb_rpc_take_connect(void);
+
+void usb_cdc_get_stats(usb_cdc_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // USB_CDC_H
@@ -0,0 +1,146 @@
+#include "app_log.h"
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "pico/platform.h"
+#include "hardware/sync.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "app_trace.h"
+
+_Static_assert((APP_LOG_RING_LEN & (APP_LOG_RING_LEN - 1u)) == 0u, "APP_LOG_RING_LEN potencia de 2");
+
+#define LOG_MASK (APP_LOG_RING_LEN - 1u)
+
+enum { REC_FREE = 0, REC_BUSY, REC_READY };
+
+/**
+ * @brief Um registro do anel (formatado pelo produtor, no próprio slot).
+ */
+typedef struct {
+    volatile uint8_t state;   // REC_*
+    uint8_t  level;
+    uint16_t len;
+    uint32_t t_ms;
+    char     msg[APP_LOG_MSG_MAX];
+} log_rec_t;
+
+static log_rec_t g_ring[APP_LOG_RING_LEN];
+static volatile uint32_t g_head;     // próxima reserva (sob o spinlock)
+static volatile uint32_t g_tail;     // próximo a escrever (só a task de dreno)
+static spin_lock_t *g_lock;
+
+static TaskHandle_t g_drain;
+static volatile uint32_t g_written;
+static volatile uint32_t g_dropped;
+static volatile uint32_t g_lat_max_us;
+
+void app_log_init(void)
+{
+    g_lock = spin_lock_instance((uint)spin_lock_claim_unused(true));
+}
+
+void app_log_v(log_level_t level, const char *fmt, va_list ap)
+{
+    if ((int)level < (int)APP_LOG_LEVEL) return;
+
+    uint32_t t0 = time_us_32();
+
+    // reserva: um incremento; anel cheio = descarta
+    uint32_t irq = spin_lock_blocking(g_lock);
+    uint32_t idx = g_head;
+    bool full = (idx - g_tail) >= APP_LOG_RING_LEN;
+    bool was_empty = (idx == g_tail);
+    if (full) g_dropped++;
+    else      g_head = idx + 1u;
+    spin_unlock(g_lock, irq);
+
+    if (!full) {
+        log_rec_t *r = &g_ring[idx & LOG_MASK];
+        r->state = REC_BUSY;
+        r->level = (uint8_t)level;
+        r->t_ms  = to_ms_since_boot(get_absolute_time());
+
+        int n = vsnprintf(r->msg, sizeof(r->msg), fmt, ap);
+        if (n < 0) n = 0;
+        if (n >= (int)sizeof(r->msg)) n = (int)sizeof(r->msg) - 1;
+        r->len = (uint16_t)n;
+
+        __dmb();                  // conteúdo visível antes do estado
+        r->state = REC_READY;
+
+        // acorda o dreno só na transição vazio -> não vazio
+        if (was_empty) app_log_kick();
+    }
+
+    // máximo aproximado: corrida entre cores só pode perder uma atualização
+    uint32_t lat = time_us_32() - t0;
+    if (lat > g_lat_max_us) g_lat_max_us = lat;
+}
+
+void app_log_kick(void)
+{
+    if (!g_drain) return;
+
+    if (__get_current_exception()) {
+        BaseType_t hpw = pdFALSE;
+        vTaskNotifyGiveFromISR(g_drain, &hpw);
+        portYIELD_FROM_ISR(hpw);
+    } else {
+        xTaskNotifyGive(g_drain);
+    }
+}
+
+void app_log(log_level_t level, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    app_log_v(level, fmt, ap);
+    va_end(ap);
+}
+
+void app_log_get_stats(app_log_stats_t *out)
+{
+    out->written    = g_written;
+    out->dropped    = g_dropped;
+    out->lat_max_us = g_lat_max_us;
+}
+
+void vTaskLogDrain(void *pvParameters)
+{
+    (void)pvParameters;
+    static const char k_lvl[] = { 'D', 'I', 'W', 'E' };
+
+    g_drain = xTaskGetCurrentTaskHandle();
+    uint32_t dropped_seen = 0;
+
+    for (;;) {
+        // em ordem; para no primeiro slot ainda sendo formatado
+        while (g_tail != g_head) {
+            log_rec_t *r = &g_ring[g_tail & LOG_MASK];
+            if (r->state != REC_READY) break;
+            __dmb();
+
+            printf("[%c %lu] %.*s\n", k_lvl[r->level & 3u], (unsigned long)r->t_ms, (int)r->len, r->msg);
+
+            r->state = REC_FREE;
+            __dmb();                  // slot livre antes de devolvê-lo aos produtores
+            g_tail = g_tail + 1u;
+            g_written++;
+        }
+
+        uint32_t d = g_dropped;
+        if (d != dropped_seen) {
+            printf("[W] log: %lu registro(s) descartado(s) (anel cheio)\n", (unsigned long)(d - dropped_seen));
+            dropped_seen = d;
+        }
+
+        app_trace_drain();
+
+        // notificação na 1ª entrada; timeout cobre o slot que ainda estava ocupado
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(APP_LOG_DRAIN_POLL_MS));
+    }
+}
@@ -5,20 +5,28 @@
 
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
+#include "pico/unique_id.h"
 
 #include "hardware/i2c.h"
-#include "hardware/pio.h"
+#include "hardware/clocks.h"
 
 #include "app_config.h"
 #include "app_ctx.h"
+#include "app_log.h"
+#include "app_trace.h"
+#include "backoff.h"
 #include "matrix_control.h"
+#include "net_wifi.h"
 
-#include "ws2812.pio.h"
 #include "matrix_led_lib.h"
+#include "luminaire.h"
+#include "pwm_dimmer.h"
 #include "bh1750.h"
 #include "aht10.h"
 #include "auto_brightness.h"
 #include "ssd1306.h"
+#include "history.h"
+#include "oled_trend.h"
 
 // ------------------------------------------------------------
 // Helpers (mutex I2C0)
@@ -35,10 +43,29 @@ static inline void i2c0_unlock(app_ctx_t *ctx) { (void)ctx; }
 // Task: Luminosidade + WS2812
 // ------------------------------------------------------------
 /**
- * @brief Task que lê BH1750, filtra lux (EMA) e atualiza brilho da matriz WS2812.
+ * @brief Aplica o percentual atual de cada canal nas saídas WS2812 e PWM.
+ */
+static void luminos_apply(uint8_t n_ch, uint8_t n_pwm)
+{
+    for (uint8_t ch = 0; ch < n_ch; ch++) {
+        uint32_t color = matrix_set_brightness_percent(matrix_control_get_channel_percent(ch));
+        luminaire_set_channel_color(ch, color);
+    }
+    (void)luminaire_show();
+
+    for (uint8_t ch = 0; ch < n_pwm; ch++) {
+        pwm_dimmer_set_channel_percent(ch, matrix_control_get_channel_percent(ch));
+    }
+    (void)pwm_dimmer_commit();
+}
+
+/**
+ * @brief Task que lê BH1750, filtra lux (EMA) e atualiza brilho dos canais WS2812.
  *
  * - Modo AUTO/MANUAL e fading são tratados por matrix_control_*.
- * - Publica nas filas: q_lux (lux bruto) e q_perc (percentual aplicado).
+ * - Canais/pinos em APP_LUM_CHANNEL_PINS (luminaire_*).
+ * - Publica nas filas: q_lux (lux bruto) e q_perc (percentual aplicado no canal 0).
+ * - Com assinante "raw" no SerialRPC, enfileira cada leitura em q_lux_samples.
  */
 void vTaskLuminos(void *pvParameters)
 {
@@ -56,6 +83,17 @@ void vTaskLuminos(void *pvParameters)
         auto_brightness_set_config(&cfg);
     }
 
+    // WS2812: um canal por state machine (pio0/pio1), envio via DMA
+    uint8_t n_ch = luminaire_init();
+
+    // PWM 16 bits para drivers de LED (opcional, APP_PWM_ENABLE)
+    uint8_t n_pwm = pwm_dimmer_init();
+
+    // acende já no brilho inicial do controle, antes da primeira leitura do sensor
+    luminos_apply(n_ch, n_pwm);
+    ctx->boot_led_ms = to_ms_since_boot(get_absolute_time());
+    LOG_I("boot -> 1o LED: %lu ms", (unsigned long)ctx->boot_led_ms);
+
     vTaskDelay(pdMS_TO_TICKS(100));
 
     // BH1750 (I2C0)
@@ -63,12 +101,6 @@ void vTaskLuminos(void *pvParameters)
     bh1750_init(APP_I2C0_PORT);
     i2c0_unlock(ctx);
 
-    // WS2812 via PIO
-    PIO pio = pio0;
-    uint sm = 0;
-    uint offset = pio_add_program(pio, &ws2812_program);
-    ws2812_program_init(pio, sm, offset, APP_LED_PIN, 800000.0f, false);
-
     float lux_f = cfg.lux_max; // inicia filtro
     float lux = 0.0f;
 
@@ -79,32 +111,33 @@ void vTaskLuminos(void *pvParameters)
         lux = bh1750_read_lux(APP_I2C0_PORT);
         i2c0_unlock(ctx);
 
-        // debug a cada ~10 ciclos
-        static uint32_t cnt = 0;
-        if ((cnt++ % 10) == 0) {
-            printf("Lux: %.2f  mode=%s  target=%u  current=%u\n",
-                   lux,
-                   (matrix_control_get_mode() == MATRIX_MODE_AUTO) ? "AUTO" : "MANUAL",
-                   (unsigned)matrix_control_get_target_percent(),
-                   (unsigned)matrix_control_get_current_percent());
-        }
+        // trace a cada ciclo (formatado só no host)
+        TRACE4(LUX, trace_f(lux),
+               matrix_control_get_mode() == MATRIX_MODE_AUTO,
+               matrix_control_get_target_percent(),
+               matrix_control_get_current_percent());
 
         // filtro EMA
         lux_f = ema_filter(lux_f, lux, cfg.alpha);
 
-        // atualiza controlador e aplica brilho
+        // atualiza controlador e aplica brilho (todos os canais em paralelo)
         uint8_t cur_percent = matrix_control_update_from_lux(lux_f);
-        uint32_t color = matrix_set_brightness_percent(cur_percent);
-
-        for (int i = 0; i < (int)APP_LED_COUNT; i++) {
-            put_pixel(pio, sm, color);
-        }
+        luminos_apply(n_ch, n_pwm);
 
         // filas (overwrite)
         float perc = (float)cur_percent;
         xQueueOverwrite(ctx->q_lux, &lux);
         xQueueOverwrite(ctx->q_perc, &perc);
 
+        if (ctx->lux_samples_on) {
+            lux_sample_t smp = { .t_ms = pdTICKS_TO_MS(xTaskGetTickCount()), .lux = lux };
+            if (xQueueSend(ctx->q_lux_samples, &smp, 0) == pdPASS) {
+                xTaskNotifyGive(ctx->task_serial);
+            } else {
+                ctx->lux_samples_drop++;
+            }
+        }
+
         vTaskDelay(pdMS_TO_TICKS(cfg.update_ms));
     }
 }
@@ -131,13 +164,13 @@ void vTaskTempUmidade(void *pvParameters)
         .initialized = false
     };
 
-    printf("Inicializando AHT10...\n");
+    LOG_I("Inicializando AHT10...");
     i2c0_lock(ctx);
     bool ok = AHT10_Init(&aht10);
     i2c0_unlock(ctx);
 
     if (!ok) {
-        printf("Falha na inicialização do sensor AHT10!\n");
+        LOG_E("Falha na inicialização do sensor AHT10!");
     }
 
     float temp = 0.0f, hum = 0.0f;
@@ -148,10 +181,7 @@ void vTaskTempUmidade(void *pvParameters)
         i2c0_unlock(ctx);
 
         if (rd) {
-            static uint32_t cnt = 0;
-            if ((cnt++ % 10) == 0) {
-                printf("Temp: %.2f C | Umid: %.2f %%\n", temp, hum);
-            }
+            TRACE2(TEMP_HUM, trace_f(temp), trace_f(hum));
         }
 
         xQueueOverwrite(ctx->q_temp, &temp);
@@ -164,13 +194,24 @@ void vTaskTempUmidade(void *pvParameters)
 // ------------------------------------------------------------
 // Task: Display SSD1306 (I2C1) + agrega frame
 // ------------------------------------------------------------
+/**
+ * @brief Callback (IRQ do DMA) de fim do refresh do OLED: acorda a task do display.
+ */
+static void display_done_cb(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR((TaskHandle_t)arg, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
 /**
  * @brief Task do display OLED (SSD1306) e agregação do frame de telemetria.
  *
  * - Recebe temp e umidade (bloqueante).
  * - Pega lux e percentual via peek.
- * - Atualiza OLED e escreve o sensor_frame_t em q_frame.
- * - Notifica task MQTT para enviar telemetria.
+ * - Guarda o frame no histórico e alterna páginas do OLED (valores / tendências).
+ * - Atualiza OLED (refresh por DMA, task bloqueada até o fim) e escreve o sensor_frame_t em q_frame.
+ * - Enfileira o frame em q_tele e notifica task MQTT para enviar telemetria.
  */
 void vTaskDisplay(void *pvParameters)
 {
@@ -180,7 +221,7 @@ void vTaskDisplay(void *pvParameters)
     char msg1[32];
     sensor_frame_t frame = {0};
 
-    printf("Display...\n");
+    LOG_I("Display...");
 
     // I2C1 para OLED
     i2c_init(APP_I2C1_PORT, APP_I2C1_BAUD_HZ);
@@ -196,6 +237,19 @@ void vTaskDisplay(void *pvParameters)
 
     vTaskDelay(pdMS_TO_TICKS(30));
     ssd1306_clear();
+    ssd1306_draw_string(0, 0, "Lux, Temp. e Umidade");
+
+    ssd1306_field_t f_lux, f_temp, f_hum, f_perc;
+    ssd1306_field_init(&f_lux,  0, 10, SSD1306_FIELD_MAX_CHARS);
+    ssd1306_field_init(&f_temp, 0, 20, SSD1306_FIELD_MAX_CHARS);
+    ssd1306_field_init(&f_hum,  0, 30, SSD1306_FIELD_MAX_CHARS);
+    ssd1306_field_init(&f_perc, 0, 40, SSD1306_FIELD_MAX_CHARS);
+
+    uint8_t page = 0;
+    uint32_t page_frames = 0;
+
+    // daqui em diante o refresh é assíncrono (DMA); a task dorme até a IRQ de fim
+    ssd1306_set_done_callback(display_done_cb, xTaskGetCurrentTaskHandle());
 
     for (;;)
     {
@@ -218,27 +272,73 @@ void vTaskDisplay(void *pvParameters)
         frame.hum  = hum;
         frame.seq++;
         frame.tick = xTaskGetTickCount();
+        frame.mode    = (uint8_t)matrix_control_get_mode();
+        frame.target  = matrix_control_get_target_percent();
+        frame.current = matrix_control_get_current_percent();
+
+        history_push(&frame);
+
+        // rotação de páginas: 0 = valores, 1..HIST_FIELDS = tendência de cada campo
+        bool entering = false;
+        if (APP_OLED_PAGE_FRAMES > 0 && ++page_frames >= APP_OLED_PAGE_FRAMES) {
+            page_frames = 0;
+            page = (uint8_t)((page + 1u) % (1u + HIST_FIELDS));
+            entering = true;
+        }
+
+        // OLED (rótulo fixo já desenhado; campos só redesenham caracteres alterados)
+        uint32_t t_draw = time_us_32();
+
+        if (page == 0) {
+            if (entering) {
+                ssd1306_clear();
+                ssd1306_draw_string(0, 0, "Lux, Temp. e Umidade");
+                ssd1306_field_invalidate(&f_lux);
+                ssd1306_field_invalidate(&f_temp);
+                ssd1306_field_invalidate(&f_hum);
+                ssd1306_field_invalidate(&f_perc);
+            }
+
+            snprintf(msg1, sizeof(msg1), "Lux: %.2f Lx", lux_local);
+            ssd1306_field_set(&f_lux, msg1);
 
-        // OLED
-        ssd1306_clear();
-        ssd1306_draw_string(0, 0, "Lux, Temp. e Umidade");
+            snprintf(msg1, sizeof(msg1), "Temp: %.2f C", temp);
+            ssd1306_field_set(&f_temp, msg1);
 
-        snprintf(msg1, sizeof(msg1), "Lux: %.2f Lx", lux_local);
-        ssd1306_draw_string(0, 10, msg1);
+            snprintf(msg1, sizeof(msg1), "Umid: %.2f %%", hum);
+            ssd1306_field_set(&f_hum, msg1);
 
-        snprintf(msg1, sizeof(msg1), "Temp: %.2f C", temp);
-        ssd1306_draw_string(0, 20, msg1);
+            snprintf(msg1, sizeof(msg1), "Perc.Lum: %.0f %%", perc);
+            ssd1306_field_set(&f_perc, msg1);
+        } else if (entering) {
+            oled_trend_enter((hist_field_t)(page - 1u));
+        } else {
+            oled_trend_update();
+        }
 
-        snprintf(msg1, sizeof(msg1), "Umid: %.2f %%", hum);
-        ssd1306_draw_string(0, 30, msg1);
+        t_draw = time_us_32() - t_draw;
 
-        snprintf(msg1, sizeof(msg1), "Perc.Lum: %.0f %%", perc);
-        ssd1306_draw_string(0, 40, msg1);
+        if (ssd1306_show_start() &&
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) == 0) {
+            LOG_W("OLED: timeout no refresh -> abort");
+            ssd1306_show_abort();
+            // um "done" que chegou entre o timeout e o abort não pode liberar o próximo quadro
+            (void)ulTaskNotifyTake(pdTRUE, 0);
+        }
 
-        ssd1306_show();
+        // custo do refresh parcial, a cada quadro
+        {
+            ssd1306_stats_t st;
+            ssd1306_get_stats(&st);
+            TRACE4(OLED_DRAW, t_draw * (clock_get_hz(clk_sys) / 1000000u), st.bytes, st.pages, st.us);
+        }
 
-        // fila do frame + notifica MQTT
+        // último frame (SerialRPC) + FIFO da telemetria MQTT, que não perde frames
+        // enquanto a task MQTT está bloqueada; notifica MQTT
         xQueueOverwrite(ctx->q_frame, &frame);
+        if (xQueueSend(ctx->q_tele, &frame, 0) != pdPASS) {
+            ctx->tele_drop++;
+        }
 
         if (ctx->task_mqtt) {
             xTaskNotifyGive(ctx->task_mqtt);
@@ -256,30 +356,48 @@ void vTaskDisplay(void *pvParameters)
  *  - reconexão
  *  - subscribe
  *  - recepção de comando (/cmd)
- *  - publish de telemetria (/telemetry)
+ *  - publish de telemetria (/telemetry): todo frame novo entra na fila de saída, com
+ *    ou sem broker, e só sai dela com o PUBACK
  */
 void vTaskMqtt(void *pvParameters)
 {
     app_ctx_t *ctx = (app_ctx_t*)pvParameters;
 
-    printf("MQTT: client_id=%s\n", ctx->mqtt.device_id);
-    printf("MQTT: tele=%s\n", ctx->mqtt.topic_tele);
-    printf("MQTT: cmd =%s\n", ctx->mqtt.topic_cmd);
+    LOG_I("MQTT: client_id=%s", ctx->mqtt.device_id);
+    LOG_I("MQTT: tele=%s", ctx->mqtt.topic_tele);
+    LOG_I("MQTT: cmd =%s", ctx->mqtt.topic_cmd);
 
     // (Opcional) watchdog de "connecting"
     // Se ficar mais que X ms em connecting, reseta para tentar de novo
     const TickType_t CONNECTING_TIMEOUT = pdMS_TO_TICKS(15000);
     TickType_t connecting_since = 0;
 
+    // reconexão: janela de espalhamento + backoff exponencial com jitter (semente = id da placa)
+    pico_unique_board_id_t uid;
+    pico_get_unique_board_id(&uid);
+    backoff_t bo;
+    backoff_init(&bo, APP_MQTT_BACKOFF_BASE_MS, APP_MQTT_BACKOFF_CAP_MS, APP_MQTT_RECONNECT_WINDOW_MS,
+                 backoff_seed(uid.id, sizeof(uid.id)));
+    bool spread = true;          // próxima tentativa é a primeira após boot/queda
+    bool attempt_open = false;   // tentativa em curso ainda sem resultado
+    TickType_t retry_at = 0;
+
     for (;;)
     {
-        // Acorda por notificação do display (ou timeout para manutenção)
+        // Acorda por notificação do display, PUBACK (ou timeout para manutenção)
         ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
 
+        // todo frame produzido desde a última volta vai para a fila de saída, mesmo sem
+        // conexão (reenviado ao reconectar)
+        sensor_frame_t frame;
+        while (xQueueReceive(ctx->q_tele, &frame, 0) == pdPASS) {
+            (void)mqtt_app_queue_telemetry(&ctx->mqtt, &frame);
+        }
+
         // evento de conexão
         if (ctx->mqtt.conn_event) {
             ctx->mqtt.conn_event = false;
-            printf("MQTT: connection status=%d  connected=%d  connecting=%d\n",
+            LOG_I("MQTT: connection status=%d  connected=%d  connecting=%d",
                    ctx->mqtt.conn_status,
                    ctx->mqtt.connected,
                    ctx->mqtt.connecting);
@@ -290,6 +408,13 @@ void vTaskMqtt(void *pvParameters)
         // -------------------------
         if (!ctx->mqtt.connected)
         {
+            // sem link não há o que tentar; a subida do link acorda esta task
+            if (!net_wifi_is_up()) {
+                connecting_since = 0;
+                spread = true;
+                continue;
+            }
+
             // Se está "connecting", não chama connect de novo.
             if (ctx->mqtt.connecting) {
                 if (connecting_since == 0) {
@@ -297,7 +422,7 @@ void vTaskMqtt(void *pvParameters)
                 } else {
                     // (Opcional) se "connecting" ficou preso tempo demais, reseta flags
                     if ((xTaskGetTickCount() - connecting_since) > CONNECTING_TIMEOUT) {
-                        printf("MQTT: connecting timeout -> forcing retry\n");
+                        LOG_W("MQTT: connecting timeout -> forcing retry");
                         ctx->mqtt.connecting = false;
                         // Se você quiser ser mais agressivo, pode também:
                         // cyw43_arch_lwip_begin();
@@ -313,8 +438,26 @@ void vTaskMqtt(void *pvParameters)
             // não está conectado e não está conectando: tenta com backoff
             connecting_since = 0;
             TickType_t now = xTaskGetTickCount();
-            if ((now - ctx->mqtt.last_attempt) > pdMS_TO_TICKS(3000)) {
-                ctx->mqtt.last_attempt = now;
+
+            if (spread) {
+                // broker caiu / link voltou: a frota inteira vê o mesmo evento, então a
+                // primeira tentativa é sorteada na janela em vez de imediata
+                spread = false;
+                attempt_open = false;
+                backoff_reset(&bo);
+                uint32_t ms = backoff_next_ms(&bo);
+                retry_at = now + pdMS_TO_TICKS(ms);
+                LOG_I("MQTT: connect in %lu ms (spread)", (unsigned long)ms);
+            } else if (attempt_open) {
+                // a tentativa terminou sem conectar (recusa, timeout, DNS)
+                attempt_open = false;
+                uint32_t ms = backoff_next_ms(&bo);
+                retry_at = now + pdMS_TO_TICKS(ms);
+                LOG_I("MQTT: retry %lu in %lu ms", (unsigned long)bo.attempt, (unsigned long)ms);
+            }
+
+            if ((int32_t)(now - retry_at) >= 0) {
+                attempt_open = true;
                 (void)mqtt_app_connect_once(&ctx->mqtt);
             }
 
@@ -324,6 +467,8 @@ void vTaskMqtt(void *pvParameters)
 
         // Se conectou, zera marcador de connecting_since
         connecting_since = 0;
+        attempt_open = false;
+        spread = true;           // uma queda daqui em diante volta a espalhar
 
         // -------------------------
         // 2) Subscribe após conectar
@@ -334,23 +479,29 @@ void vTaskMqtt(void *pvParameters)
                 ctx->mqtt.need_subscribe = false;
             } else {
                 // tenta de novo em próximas iterações
-                printf("MQTT: subscribe failed, will retry\n");
+                LOG_W("MQTT: subscribe failed, will retry");
             }
         }
 
         // -------------------------
         // 3) Comando RX
         // -------------------------
-        char topic_local[96];
-        char payload_local[256];
-
-        if (mqtt_app_take_cmd(&ctx->mqtt,
-                              topic_local, sizeof(topic_local),
-                              payload_local, sizeof(payload_local))) {
-
-            printf("CMD RX topic=%s payload=%s\n", topic_local, payload_local);
+        matrix_cmd_t cmd;
+        unsigned n_cmd = 0;
+
+        // drena tudo o que chegou desde a última volta (na ordem de chegada)
+        while (mqtt_app_take_cmd(&ctx->mqtt, &cmd)) {
+            LOG_I("CMD RX topic=%s flags=0x%02x", ctx->mqtt.topic_cmd, (unsigned)cmd.flags);
+            matrix_control_apply_cmd(&cmd);
+            n_cmd++;
+        }
 
-            matrix_control_apply_cmd_payload(payload_local);
+        if (n_cmd > 0) {
+            LOG_I("CMD: %u aplicados (fila=%lu, fundidos=%lu, erros=%lu)",
+                   n_cmd,
+                   (unsigned long)ctx->mqtt.cmd_ring.pushed,
+                   (unsigned long)ctx->mqtt.cmd_ring.coalesced,
+                   (unsigned long)ctx->mqtt.cmd_errors);
 
             // blink LED onboard (feedback)
             cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
@@ -361,43 +512,15 @@ void vTaskMqtt(void *pvParameters)
         // -------------------------
         // 4) TX Telemetria
         // -------------------------
-        sensor_frame_t frame;
-        if (xQueuePeek(ctx->q_frame, &frame, 0) != pdPASS) {
-            continue;
-        }
-        if (frame.seq == ctx->mqtt.last_sent_seq) {
-            continue;
-        }
-
-        char payload[240];
-        int n = snprintf(payload, sizeof(payload),
-            "{\"device\":\"%s\",\"lux\":%.2f,\"luxPercLum\":%.1f,"
-            "\"temp\":%.2f,\"hum\":%.2f,\"seq\":%lu,\"t_ms\":%lu}",
-            ctx->mqtt.device_id,
-            (double)frame.lux,
-            (double)frame.luxPercLum,
-            (double)frame.temp,
-            (double)frame.hum,
-            (unsigned long)frame.seq,
-            (unsigned long)pdTICKS_TO_MS(frame.tick)
-        );
-        if (n <= 0 || n >= (int)sizeof(payload)) {
-            continue;
-        }
-
-        if (!mqtt_app_publish_frame(&ctx->mqtt,
-                                    payload, (size_t)strlen(payload),
-                                    frame.seq, frame.tick)) {
-            // Falha no publish: força reconectar
-            printf("MQTT: publish failed -> mark disconnected\n");
-            ctx->mqtt.connected   = false;
-            ctx->mqtt.connecting  = false;   // <<< importante para não travar em estado
-            ctx->mqtt.need_subscribe = false;
+        if (!mqtt_app_flush_telemetry(&ctx->mqtt)) {
+            // PUBACK atrasado ou publish recusado: derruba a conexão (o lwIP descarta as
+            // requisições) e a fila inteira sai de novo, na ordem, na próxima conexão
+            LOG_W("MQTT: publish failed -> reconnect (%lu in flight)",
+                  (unsigned long)ctx->mqtt.out.count);
+            mqtt_app_drop(&ctx->mqtt);
 
             vTaskDelay(pdMS_TO_TICKS(300));
             continue;
         }
-
-        // Se publish OK, segue loop
     }
 }
@@ -0,0 +1,139 @@
+#include "app_trace.h"
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "pico/platform.h"
+#include "hardware/sync.h"
+
+#include "app_log.h"
+#include "serial_bin.h"
+
+_Static_assert((APP_TRACE_RING_LEN & (APP_TRACE_RING_LEN - 1u)) == 0u, "APP_TRACE_RING_LEN potencia de 2");
+
+#define TRACE_MASK      (APP_TRACE_RING_LEN - 1u)
+#define TRACE_HDR_LEN   8u
+#define TRACE_REC_MAX   (TRACE_HDR_LEN + 4u * APP_TRACE_MAX_ARGS)
+
+/**
+ * @brief Registro no anel (ainda em formato nativo; serializado só no dreno).
+ */
+typedef struct {
+    volatile uint8_t ready;
+    uint8_t  nargs;
+    uint8_t  core;
+    uint16_t id;
+    uint32_t t_us;
+    uint32_t args[APP_TRACE_MAX_ARGS];
+} trace_rec_t;
+
+static trace_rec_t g_ring[APP_TRACE_RING_LEN];
+static volatile uint32_t g_head;
+static volatile uint32_t g_tail;
+static volatile uint32_t g_dropped;
+static spin_lock_t *g_lock;
+
+void app_trace_init(void)
+{
+    g_lock = spin_lock_instance((uint)spin_lock_claim_unused(true));
+}
+
+void app_trace_rec(app_trace_id_t id, uint8_t n, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    uint32_t irq = spin_lock_blocking(g_lock);
+    uint32_t idx = g_head;
+    bool full = (idx - g_tail) >= APP_TRACE_RING_LEN;
+    bool was_empty = (idx == g_tail);
+    if (full) g_dropped++;
+    else      g_head = idx + 1u;
+    spin_unlock(g_lock, irq);
+
+    if (full) return;
+
+    trace_rec_t *r = &g_ring[idx & TRACE_MASK];
+    r->id      = (uint16_t)id;
+    r->nargs   = n;
+    r->core    = (uint8_t)get_core_num();
+    r->t_us    = time_us_32();
+    r->args[0] = a;
+    r->args[1] = b;
+    r->args[2] = c;
+    r->args[3] = d;
+
+    __dmb();
+    r->ready = 1;
+
+    if (was_empty) app_log_kick();
+}
+
+uint32_t app_trace_dropped(void)
+{
+    return g_dropped;
+}
+
+/**
+ * @brief Base64 padrão (com '='); out precisa de 4 * ceil(len / 3) bytes.
+ */
+static size_t b64_encode(const uint8_t *in, size_t len, char *out)
+{
+    static const char k[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+
+        out[o++] = k[(v >> 18) & 63u];
+        out[o++] = k[(v >> 12) & 63u];
+        out[o++] = (i + 1 < len) ? k[(v >> 6) & 63u] : '=';
+        out[o++] = (i + 2 < len) ? k[v & 63u] : '=';
+    }
+    return o;
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+void app_trace_drain(void)
+{
+    uint8_t raw[TRACE_REC_MAX + 2u];
+    char line[1u + 4u * ((sizeof(raw) + 2u) / 3u) + 1u];
+    bool any = false;
+
+    while (g_tail != g_head) {
+        trace_rec_t *r = &g_ring[g_tail & TRACE_MASK];
+        if (!r->ready) break;
+        __dmb();
+
+        uint8_t n = (r->nargs > APP_TRACE_MAX_ARGS) ? APP_TRACE_MAX_ARGS : r->nargs;
+        raw[0] = (uint8_t)r->id;
+        raw[1] = (uint8_t)(r->id >> 8);
+        raw[2] = n;
+        raw[3] = r->core;
+        put_u32(&raw[4], r->t_us);
+        for (uint8_t i = 0; i < n; i++) put_u32(&raw[TRACE_HDR_LEN + 4u * i], r->args[i]);
+
+        size_t len = TRACE_HDR_LEN + 4u * n;
+        uint16_t crc = serial_bin_crc16(raw, len);
+        raw[len++] = (uint8_t)crc;
+        raw[len++] = (uint8_t)(crc >> 8);
+
+        r->ready = 0;
+        __dmb();
+        g_tail = g_tail + 1u;
+
+        size_t o = 0;
+        line[o++] = '~';
+        o += b64_encode(raw, len, &line[o]);
+        line[o++] = '\n';
+        fwrite(line, 1, o, stdout);
+        any = true;
+    }
+    if (any) fflush(stdout);
+}
@@ -0,0 +1,195 @@
+#include "cmd_parser.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+typedef enum {
+    ST_START = 0,     // antes do '{'
+    ST_KEY_OR_END,    // logo após '{'
+    ST_KEY_REQ,       // após ',' (precisa de chave)
+    ST_KEY,
+    ST_KEY_ESC,
+    ST_COLON,
+    ST_VALUE,
+    ST_STR,
+    ST_STR_ESC,
+    ST_PRIM,
+    ST_SKIP,          // descartando objeto/array aninhado
+    ST_COMMA_OR_END,
+    ST_DONE,
+    ST_ERROR
+} st_t;
+
+static inline bool is_space(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * @brief Grava no comando o valor escalar recém-terminado.
+ */
+static void commit_value(cmd_parser_t *p, bool is_string)
+{
+    size_t n = (p->val_len < CMD_PARSER_VAL_MAX) ? p->val_len : CMD_PARSER_VAL_MAX;
+    matrix_control_cmd_field(&p->cmd, &p->pct_rank, (matrix_key_t)p->key, p->val_buf, n, is_string);
+}
+
+static inline void val_put(cmd_parser_t *p, uint8_t c)
+{
+    if (p->val_len < CMD_PARSER_VAL_MAX) p->val_buf[p->val_len] = (char)c;
+    if (p->val_len < 0xFFu) p->val_len++;
+}
+
+static inline void key_put(cmd_parser_t *p, uint8_t c)
+{
+    if (p->key_len < CMD_PARSER_KEY_MAX) p->key_buf[p->key_len] = (char)c;
+    if (p->key_len < 0xFFu) p->key_len++;
+}
+
+/**
+ * @brief Entra/sai de um nível de objeto/array durante o descarte.
+ */
+static bool skip_open(cmd_parser_t *p, uint8_t c)
+{
+    if (p->depth >= CMD_PARSER_DEPTH_MAX) return false;
+    if (c == '{') p->depth_bits |= (1u << p->depth);
+    else          p->depth_bits &= ~(1u << p->depth);
+    p->depth++;
+    return true;
+}
+
+static bool skip_close(cmd_parser_t *p, uint8_t c)
+{
+    if (p->depth == 0) return false;
+    p->depth--;
+    bool is_obj = (p->depth_bits >> p->depth) & 1u;
+    return is_obj == (c == '}');
+}
+
+void cmd_parser_reset(cmd_parser_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->state = ST_START;
+    p->cmd.channel = -1;
+}
+
+cmd_parse_status_t cmd_parser_feed(cmd_parser_t *p, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len && p->state != ST_ERROR; i++) {
+        uint8_t c = data[i];
+
+        switch ((st_t)p->state) {
+        case ST_START:
+            if (c == '{') p->state = ST_KEY_OR_END;
+            else if (!is_space(c)) p->state = ST_ERROR;
+            break;
+
+        case ST_KEY_OR_END:
+        case ST_KEY_REQ:
+            if (c == '"') {
+                p->key_len = 0;
+                p->state = ST_KEY;
+            } else if (c == '}' && p->state == ST_KEY_OR_END) {
+                p->state = ST_DONE;
+            } else if (!is_space(c)) {
+                p->state = ST_ERROR;
+            }
+            break;
+
+        case ST_KEY:
+            if (c == '\\') p->state = ST_KEY_ESC;
+            else if (c == '"') {
+                // chave truncada nunca casa
+                p->key = (p->key_len < CMD_PARSER_KEY_MAX)
+                       ? (int8_t)matrix_control_key_lookup(p->key_buf, p->key_len)
+                       : (int8_t)MATRIX_KEY_NONE;
+                p->state = ST_COLON;
+            }
+            else key_put(p, c);
+            break;
+
+        case ST_KEY_ESC:
+            key_put(p, c);
+            p->state = ST_KEY;
+            break;
+
+        case ST_COLON:
+            if (c == ':') p->state = ST_VALUE;
+            else if (!is_space(c)) p->state = ST_ERROR;
+            break;
+
+        case ST_VALUE:
+            p->val_len = 0;
+            if (c == '"') {
+                p->state = ST_STR;
+            } else if (c == '{' || c == '[') {
+                p->depth = 0;
+                p->skip_str = 0;
+                (void)skip_open(p, c);
+                p->state = ST_SKIP;
+            } else if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+                val_put(p, c);
+                p->state = ST_PRIM;
+            } else if (!is_space(c)) {
+                p->state = ST_ERROR;
+            }
+            break;
+
+        case ST_STR:
+            if (c == '\\') p->state = ST_STR_ESC;
+            else if (c == '"') { commit_value(p, true); p->state = ST_COMMA_OR_END; }
+            else val_put(p, c);
+            break;
+
+        case ST_STR_ESC:
+            val_put(p, c);
+            p->state = ST_STR;
+            break;
+
+        case ST_PRIM:
+            if (is_space(c) || c == ',' || c == '}') {
+                commit_value(p, false);
+                p->state = ST_COMMA_OR_END;
+                i--; // reprocessa o delimitador
+            } else if (c < 32 || c >= 127 || c == ']' || c == ':' || c == '"') {
+                p->state = ST_ERROR;
+            } else {
+                val_put(p, c);
+            }
+            break;
+
+        case ST_SKIP:
+            if (p->skip_str) {
+                if (p->skip_str == 2) p->skip_str = 1;      // caractere escapado
+                else if (c == '\\') p->skip_str = 2;
+                else if (c == '"')  p->skip_str = 0;
+            } else if (c == '"') {
+                p->skip_str = 1;
+            } else if (c == '{' || c == '[') {
+                if (!skip_open(p, c)) p->state = ST_ERROR;
+            } else if (c == '}' || c == ']') {
+                if (!skip_close(p, c)) p->state = ST_ERROR;
+                else if (p->depth == 0) p->state = ST_COMMA_OR_END;
+            }
+            break;
+
+        case ST_COMMA_OR_END:
+            if (c == ',') p->state = ST_KEY_REQ;
+            else if (c == '}') p->state = ST_DONE;
+            else if (!is_space(c)) p->state = ST_ERROR;
+            break;
+
+        case ST_DONE:
+            if (!is_space(c)) p->state = ST_ERROR; // lixo após o objeto
+            break;
+
+        default:
+            p->state = ST_ERROR;
+            break;
+        }
+    }
+
+    if (p->state == ST_DONE)  return CMD_PARSE_DONE;
+    if (p->state == ST_ERROR) return CMD_PARSE_ERROR;
+    return CMD_PARSE_MORE;
+}
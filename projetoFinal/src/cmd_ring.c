@@ -0,0 +1,161 @@
+#include "cmd_ring.h"
+
+#include <string.h>
+
+#include "hardware/sync.h"
+
+#define RING_MASK (APP_CMD_RING_LEN - 1u)
+
+_Static_assert((APP_CMD_RING_LEN & (APP_CMD_RING_LEN - 1u)) == 0u, "APP_CMD_RING_LEN potencia de 2");
+_Static_assert(APP_LUM_CHANNEL_COUNT <= 32u, "mascara de canais em 32 bits");
+
+/**
+ * @brief Funde um comando no bloco, com a mesma semântica de matrix_control_apply_cmd().
+ */
+static void merge_cmd(cmd_ring_merge_t *m, const matrix_cmd_t *cmd)
+{
+    // canal inválido: o comando inteiro é ignorado (como no apply)
+    if ((cmd->flags & MATRIX_CMD_F_CHANNEL) &&
+        (cmd->channel < 0 || cmd->channel >= (int)APP_LUM_CHANNEL_COUNT)) {
+        return;
+    }
+
+    if (cmd->flags & MATRIX_CMD_F_MODE) {
+        m->has_mode = 1;
+        m->mode = cmd->mode;
+    }
+
+    if (cmd->flags & MATRIX_CMD_F_PERCENT) {
+        uint32_t mask;
+        if (cmd->flags & MATRIX_CMD_F_CHANNEL) {
+            mask = 1u << (uint32_t)cmd->channel;
+        } else {
+            mask = (APP_LUM_CHANNEL_COUNT >= 32u) ? 0xFFFFFFFFu : ((1u << APP_LUM_CHANNEL_COUNT) - 1u);
+        }
+
+        int32_t v = cmd->percent;
+        uint8_t p = (v < 0) ? 0u : (v > 100) ? 100u : (uint8_t)v;
+        for (uint8_t ch = 0; ch < APP_LUM_CHANNEL_COUNT; ch++) {
+            if (mask & (1u << ch)) m->pct[ch] = p;
+        }
+        m->pct_mask |= mask;
+
+        // percent força MANUAL depois de aplicar o modo do próprio comando
+        m->has_mode = 1;
+        m->mode = MATRIX_MODE_MANUAL;
+    }
+}
+
+void cmd_ring_init(cmd_ring_t *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+bool cmd_ring_push(cmd_ring_t *r, const matrix_cmd_t *cmd)
+{
+    // bloco atual com comandos e ainda não reivindicado: tudo vai para ele (preserva a ordem)
+    uint32_t g = r->ovf_gen;
+    bool open = (g != r->ovf_claim);
+    uint32_t h = r->head;
+
+    if (!open && (h - r->tail) < APP_CMD_RING_LEN) {
+        r->slot[h & RING_MASK] = *cmd;
+        __dmb();
+        r->head = h + 1u;
+        r->pushed++;
+        return true;
+    }
+
+    r->ovf_seq++;             // ímpar: consumidor não pode copiar agora
+    __dmb();
+    // confere de novo depois de marcar a escrita: se o consumidor reivindicou o bloco
+    // neste meio tempo, ele já pode estar copiando -> começa um bloco novo no outro buffer
+    if (!open || r->ovf_claim == g) {
+        g++;
+        memset(&r->ovf[g & 1u], 0, sizeof(r->ovf[0]));
+        r->ovf_gen = g;
+    }
+    merge_cmd(&r->ovf[g & 1u], cmd);
+    __dmb();
+    r->ovf_seq++;
+    r->coalesced++;
+    return false;
+}
+
+/**
+ * @brief Expande o bloco de overflow em comandos: cada canal, depois o modo.
+ *
+ * O modo fundido já é o final (percent força MANUAL na fusão), e aplicar um percent
+ * força MANUAL: por isso ele vem por último, senão {"percent":50} seguido de
+ * {"mode":"auto"} terminaria em MANUAL.
+ */
+static bool pend_next(cmd_ring_merge_t *m, matrix_cmd_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    for (uint8_t ch = 0; ch < APP_LUM_CHANNEL_COUNT; ch++) {
+        if (m->pct_mask & (1u << ch)) {
+            m->pct_mask &= ~(1u << ch);
+            out->flags = MATRIX_CMD_F_PERCENT | MATRIX_CMD_F_CHANNEL;
+            out->channel = (int16_t)ch;
+            out->percent = m->pct[ch];
+            return true;
+        }
+    }
+
+    if (m->has_mode) {
+        m->has_mode = 0;
+        out->flags = MATRIX_CMD_F_MODE;
+        out->mode = m->mode;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Copia o bloco reivindicado para pend; false se o produtor está escrevendo.
+ *
+ * ovf_claim foi publicado antes de ler ovf_seq: uma escrita que começa depois disso vê a
+ * reivindicação e vai para o outro buffer; uma que já estava em curso deixa ovf_seq ímpar.
+ */
+static bool ovf_copy(cmd_ring_t *r)
+{
+    uint32_t g = r->ovf_claim;
+
+    __dmb();
+    if (r->ovf_seq & 1u) return false;
+    __dmb();
+    r->pend = r->ovf[g & 1u];
+    __dmb();
+    r->ovf_taken = g;
+    return true;
+}
+
+bool cmd_ring_pop(cmd_ring_t *r, matrix_cmd_t *out)
+{
+    if (pend_next(&r->pend, out)) return true;
+
+    // bloco reivindicado e ainda não copiado vem antes do que entrou na fila depois dele
+    if (r->ovf_claim != r->ovf_taken) {
+        return ovf_copy(r) && pend_next(&r->pend, out);
+    }
+
+    // geração lida antes de head: se a fila encheu de novo e abriu um bloco depois de
+    // head ser lido, esse bloco ainda não é visto aqui e não passa na frente da fila
+    uint32_t g = r->ovf_gen;
+    uint32_t t = r->tail;
+    __dmb();
+    if (t != r->head) {
+        __dmb();
+        *out = r->slot[t & RING_MASK];
+        __dmb();
+        r->tail = t + 1u;
+        return true;
+    }
+
+    // fila vazia: reivindica o bloco de overflow, se houver
+    if (g == r->ovf_taken) return false;
+
+    r->ovf_claim = g;
+    return ovf_copy(r) && pend_next(&r->pend, out);
+}
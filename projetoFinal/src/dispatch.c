@@ -0,0 +1,74 @@
+#include "dispatch.h"
+
+#include <string.h>
+
+#define SEED_TRIES 4096u
+
+/**
+ * @brief FNV-1a com a semente misturada na base.
+ */
+static inline uint32_t name_hash(uint32_t seed, const char *s, size_t len)
+{
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+bool dispatch_build(dispatch_table_t *t, const char *const *names, uint8_t count)
+{
+    memset(t, 0, sizeof(*t));
+    t->names = names;
+    t->count = count;
+
+    // tabela >= 2x a quantidade de nomes: semente encontrada em poucas tentativas
+    uint32_t size = 4u;
+    while (size < 2u * count) size <<= 1;
+    if (size > DISPATCH_SLOTS_MAX) {
+        t->count = 0;
+        return false;
+    }
+    t->mask = (uint8_t)(size - 1u);
+
+    for (uint8_t i = 0; i < count; i++) {
+        size_t n = strlen(names[i]);
+        if (n > UINT8_MAX) {
+            t->count = 0;
+            return false;
+        }
+        t->len[i] = (uint8_t)n;
+    }
+
+    for (uint32_t seed = 1; seed <= SEED_TRIES; seed++) {
+        memset(t->slot, DISPATCH_EMPTY, sizeof(t->slot));
+
+        bool ok = true;
+        for (uint8_t i = 0; i < count && ok; i++) {
+            uint32_t h = name_hash(seed, names[i], t->len[i]) & t->mask;
+            if (t->slot[h] != DISPATCH_EMPTY) ok = false;
+            else t->slot[h] = i;
+        }
+
+        if (ok) {
+            t->seed = seed;
+            return true;
+        }
+    }
+
+    t->count = 0;
+    return false;
+}
+
+int dispatch_lookup(const dispatch_table_t *t, const char *s, size_t len)
+{
+    if (!t || t->count == 0 || !s) return -1;
+
+    uint8_t i = t->slot[name_hash(t->seed, s, len) & t->mask];
+    if (i == DISPATCH_EMPTY) return -1;
+
+    // tamanho primeiro: memcmp não lê além do nome nem aceita "mode\0xx" como "mode"
+    if (len != t->len[i] || memcmp(t->names[i], s, len) != 0) return -1;
+    return (int)i;
+}
@@ -0,0 +1,230 @@
+#include "history.h"
+
+#include <string.h>
+
+#include "app_config.h"
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#define HIST_BLOCK_LEN (APP_HIST_LEN / APP_HIST_BLOCKS)
+
+_Static_assert(APP_HIST_LEN % APP_HIST_BLOCKS == 0, "APP_HIST_LEN deve ser multiplo de APP_HIST_BLOCKS");
+_Static_assert(APP_HIST_LEN <= 0xFFFFu, "APP_HIST_LEN");
+_Static_assert(APP_HIST_BLOCKS <= 32u, "APP_HIST_BLOCKS");
+
+/**
+ * @brief Estado do histórico.
+ *
+ * delta[f][i] = valor(i) - valor(i-1); o delta da amostra mais antiga não é usado.
+ * newest[f] é o valor reconstruído da última amostra (leitura caminha para trás).
+ */
+static int16_t  g_delta[HIST_FIELDS][APP_HIST_LEN];
+static int32_t  g_newest[HIST_FIELDS];
+static uint16_t g_head = 0;     // próxima posição de escrita
+static uint16_t g_count = 0;
+
+// tempo: dt[i] = t(i) - t(i-1) em ms (saturado); índice absoluto do próximo quadro
+static uint16_t g_dt[APP_HIST_LEN];
+static uint32_t g_newest_t = 0;
+static uint32_t g_total = 0;
+
+static SemaphoreHandle_t g_mtx;
+
+// min/max por bloco (bloco atual só contém amostras novas desde que começou)
+static int32_t g_blk_min[HIST_FIELDS][APP_HIST_BLOCKS];
+static int32_t g_blk_max[HIST_FIELDS][APP_HIST_BLOCKS];
+static uint32_t g_blk_valid = 0; // bitmask de blocos com dados
+
+// âncoras: valor e instante do primeiro quadro de cada bloco (leitura por índice absoluto)
+static int32_t  g_blk_key[HIST_FIELDS][APP_HIST_BLOCKS];
+static uint32_t g_blk_key_t[APP_HIST_BLOCKS];
+
+static const int32_t k_scale[HIST_FIELDS] = { 1, 100, 100, 1 };
+
+static inline int32_t quantize(float v, int32_t scale)
+{
+    float q = v * (float)scale;
+    return (int32_t)(q < 0.0f ? q - 0.5f : q + 0.5f);
+}
+
+void history_init(void)
+{
+    if (!g_mtx) g_mtx = xSemaphoreCreateMutex();
+    configASSERT(g_mtx != NULL);
+
+    memset(g_delta, 0, sizeof(g_delta));
+    memset(g_newest, 0, sizeof(g_newest));
+    memset(g_dt, 0, sizeof(g_dt));
+    memset(g_blk_key, 0, sizeof(g_blk_key));
+    memset(g_blk_key_t, 0, sizeof(g_blk_key_t));
+    g_head = 0;
+    g_count = 0;
+    g_blk_valid = 0;
+    g_newest_t = 0;
+    g_total = 0;
+}
+
+void history_push(const sensor_frame_t *fr)
+{
+    int32_t v[HIST_FIELDS] = {
+        quantize(fr->lux,        k_scale[HIST_LUX]),
+        quantize(fr->temp,       k_scale[HIST_TEMP]),
+        quantize(fr->hum,        k_scale[HIST_HUM]),
+        quantize(fr->luxPercLum, k_scale[HIST_PERC]),
+    };
+
+    uint32_t t = (uint32_t)pdTICKS_TO_MS(fr->tick);
+
+    xSemaphoreTake(g_mtx, portMAX_DELAY);
+
+    uint32_t dt = (g_count == 0) ? 0u : t - g_newest_t;
+    g_dt[g_head] = (uint16_t)((dt > 0xFFFFu) ? 0xFFFFu : dt);
+    g_newest_t = t;
+
+    uint16_t blk = (uint16_t)(g_head / HIST_BLOCK_LEN);
+    bool blk_start = (g_head % HIST_BLOCK_LEN) == 0;
+    if (blk_start) g_blk_key_t[blk] = t;
+    bool full = (g_count == APP_HIST_LEN);
+
+    for (int f = 0; f < HIST_FIELDS; f++) {
+        int32_t d = (g_count == 0) ? 0 : v[f] - g_newest[f];
+        if (d > INT16_MAX) d = INT16_MAX;   // saltos maiores convergem nas próximas amostras
+        if (d < INT16_MIN) d = INT16_MIN;
+        g_delta[f][g_head] = (int16_t)d;
+
+        int32_t rec = (g_count == 0) ? v[f] : g_newest[f] + d;
+        g_newest[f] = rec;
+
+        if (blk_start) {
+            g_blk_key[f][blk] = rec;
+            g_blk_min[f][blk] = rec;
+            g_blk_max[f][blk] = rec;
+        } else {
+            if (rec < g_blk_min[f][blk]) g_blk_min[f][blk] = rec;
+            if (rec > g_blk_max[f][blk]) g_blk_max[f][blk] = rec;
+        }
+    }
+    g_blk_valid |= 1u << blk;
+
+    g_head = (uint16_t)((g_head + 1u) % APP_HIST_LEN);
+    if (!full) g_count++;
+    g_total++;
+
+    xSemaphoreGive(g_mtx);
+}
+
+uint16_t history_count(void)
+{
+    return g_count;
+}
+
+int32_t history_scale(hist_field_t f)
+{
+    return (f < HIST_FIELDS) ? k_scale[f] : 1;
+}
+
+int32_t history_latest(hist_field_t f)
+{
+    return (f < HIST_FIELDS && g_count) ? g_newest[f] : 0;
+}
+
+bool history_minmax(hist_field_t f, int32_t *mn, int32_t *mx)
+{
+    if (f >= HIST_FIELDS || g_count == 0) return false;
+
+    int32_t lo = INT32_MAX, hi = INT32_MIN;
+    for (uint8_t b = 0; b < APP_HIST_BLOCKS; b++) {
+        if (!(g_blk_valid & (1u << b))) continue;
+        if (g_blk_min[f][b] < lo) lo = g_blk_min[f][b];
+        if (g_blk_max[f][b] > hi) hi = g_blk_max[f][b];
+    }
+    *mn = lo;
+    *mx = hi;
+    return true;
+}
+
+uint16_t history_read_recent(hist_field_t f, int32_t *out, uint16_t n)
+{
+    if (f >= HIST_FIELDS) return 0;
+    if (n > g_count) n = g_count;
+    if (n == 0) return 0;
+
+    // caminha para trás a partir da mais recente: valor(i-1) = valor(i) - delta(i)
+    int32_t v = g_newest[f];
+    uint16_t idx = (uint16_t)((g_head + APP_HIST_LEN - 1u) % APP_HIST_LEN);
+    for (uint16_t k = n; k > 0; k--) {
+        out[k - 1] = v;
+        v -= g_delta[f][idx];
+        idx = (uint16_t)((idx + APP_HIST_LEN - 1u) % APP_HIST_LEN);
+    }
+    return n;
+}
+
+void history_span(uint32_t *first, uint32_t *next)
+{
+    xSemaphoreTake(g_mtx, portMAX_DELAY);
+    *first = g_total - g_count;
+    *next  = g_total;
+    xSemaphoreGive(g_mtx);
+}
+
+uint16_t history_read_span(uint32_t from, hist_sample_t *out, uint16_t n)
+{
+    xSemaphoreTake(g_mtx, portMAX_DELAY);
+
+    uint32_t first = g_total - g_count;
+    if (from < first) from = first;
+    if (from >= g_total || n == 0) {
+        xSemaphoreGive(g_mtx);
+        return 0;
+    }
+    if ((uint32_t)n > g_total - from) n = (uint16_t)(g_total - from);
+
+    // âncora mais próxima de `from` (o índice absoluto i fica na posição i % APP_HIST_LEN):
+    // início do bloco dele, se ainda está no anel; senão o início do bloco seguinte ou a
+    // mais recente. Caminha no máximo um bloco, sem depender do tamanho do histórico.
+    int32_t v[HIST_FIELDS];
+    uint32_t t;
+    uint32_t a = from - (from % HIST_BLOCK_LEN);
+    if (a < first) a += HIST_BLOCK_LEN;
+    if (a < g_total) {
+        uint16_t blk = (uint16_t)((a % APP_HIST_LEN) / HIST_BLOCK_LEN);
+        for (int f = 0; f < HIST_FIELDS; f++) v[f] = g_blk_key[f][blk];
+        t = g_blk_key_t[blk];
+    } else {
+        a = g_total - 1u;
+        memcpy(v, g_newest, sizeof(v));
+        t = g_newest_t;
+    }
+
+    // valor(i+1) = valor(i) + delta(i+1); valor(i-1) = valor(i) - delta(i)
+    uint16_t idx = (uint16_t)(a % APP_HIST_LEN);
+    while (a < from) {
+        a++;
+        idx = (uint16_t)(a % APP_HIST_LEN);
+        for (int f = 0; f < HIST_FIELDS; f++) v[f] += g_delta[f][idx];
+        t += g_dt[idx];
+    }
+    while (a > from) {
+        for (int f = 0; f < HIST_FIELDS; f++) v[f] -= g_delta[f][idx];
+        t -= g_dt[idx];
+        a--;
+        idx = (uint16_t)(a % APP_HIST_LEN);
+    }
+
+    // e avança gerando a saída: valor(i+1) = valor(i) + delta(i+1)
+    for (uint16_t k = 0; k < n; k++) {
+        if (k > 0) {
+            idx = (uint16_t)((idx + 1u) % APP_HIST_LEN);
+            for (int f = 0; f < HIST_FIELDS; f++) v[f] += g_delta[f][idx];
+            t += g_dt[idx];
+        }
+        out[k].idx  = from + k;
+        out[k].t_ms = t;
+        memcpy(out[k].v, v, sizeof(v));
+    }
+
+    xSemaphoreGive(g_mtx);
+    return n;
+}
@@ -1,64 +1,312 @@
 #include "json_simple.h"
 
-#include <ctype.h>
-#include <stdio.h>
+#include <limits.h>
 #include <string.h>
 
+#define TOK_UNSET 0xFFFFu
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool is_delim(char c)
+{
+    return is_space(c) || c == ',' || c == ']' || c == '}' || c == ':';
+}
+
 /**
- * @brief Procura a ocorrência de uma chave no formato "key" dentro do JSON.
- * @param json Texto JSON.
- * @param key  Nome da chave (sem aspas).
- * @return Ponteiro para a ocorrência da chave ou NULL.
+ * @brief Reserva e inicializa o próximo token.
  */
-static const char *find_key(const char *json, const char *key)
+static json_tok_t *tok_new(json_tok_t *toks, int max_toks, int *next, json_tok_type_t type,
+                           int16_t parent, size_t start, size_t end)
 {
-    static char pat[64];
-    snprintf(pat, sizeof(pat), "\"%s\"", key);
-    return strstr(json, pat);
+    if (*next >= max_toks) return NULL;
+    json_tok_t *t = &toks[(*next)++];
+    t->type   = (uint8_t)type;
+    t->parent = parent;
+    t->start  = (uint16_t)start;
+    t->end    = (uint16_t)end;
+    t->size   = 0;
+    return t;
 }
 
-bool json_get_string(const char *json, const char *key, char *out, size_t outsz)
+/**
+ * @brief Valida a posição de um novo valor em relação ao token "super" atual.
+ *
+ * Dentro de objeto só pode aparecer chave (string); depois de ':' o super é a chave,
+ * que aceita exatamente um valor. Em objeto/array, todo item depois do primeiro
+ * precisa vir após uma ',' (sep).
+ */
+static bool attach_ok(const json_tok_t *toks, int super, json_tok_type_t type, bool sep)
+{
+    if (super < 0) return true;
+    const json_tok_t *s = &toks[super];
+    if (s->type == JSON_TOK_STRING) return s->size == 0;
+    if (s->size > 0 && !sep) return false;
+    if (s->type == JSON_TOK_OBJECT) return type == JSON_TOK_STRING;
+    return true; // array
+}
+
+int json_parse(json_doc_t *doc, const char *js, size_t len, json_tok_t *toks, int max_toks)
 {
-    const char *p = find_key(json, key);
-    if (!p) return false;
+    if (doc) { doc->json = js; doc->toks = toks; doc->count = 0; }
+    if (!js || !toks || max_toks <= 0) return JSON_ERR_INVAL;
+    if (len >= TOK_UNSET) return JSON_ERR_NOMEM;
+
+    int next = 0;
+    int super = -1;
+    bool root_done = false;
+    bool sep = false;          // ',' vista: o próximo token tem de ser um item
+    bool need_colon = false;   // chave de objeto vista: o próximo token tem de ser ':'
+
+    for (size_t pos = 0; pos < len && js[pos] != '\0'; pos++) {
+        char c = js[pos];
+
+        if (is_space(c)) continue;
+        if (root_done) return JSON_ERR_INVAL; // lixo após o valor raiz
+        if (need_colon && c != ':') return JSON_ERR_INVAL;
 
-    p = strchr(p, ':');
-    if (!p) return false;
-    p++;
+        switch (c) {
+        case '{':
+        case '[': {
+            json_tok_type_t type = (c == '{') ? JSON_TOK_OBJECT : JSON_TOK_ARRAY;
+            if (!attach_ok(toks, super, type, sep)) return JSON_ERR_INVAL;
+            json_tok_t *t = tok_new(toks, max_toks, &next, type, (int16_t)super, pos, TOK_UNSET);
+            if (!t) return JSON_ERR_NOMEM;
+            if (super >= 0) toks[super].size++;
+            super = next - 1;
+            sep = false;
+            break;
+        }
 
-    while (*p && isspace((unsigned char)*p)) p++;
-    if (*p != '"') return false;
-    p++;
+        case '}':
+        case ']': {
+            json_tok_type_t type = (c == '}') ? JSON_TOK_OBJECT : JSON_TOK_ARRAY;
+            if (sep) return JSON_ERR_INVAL; // vírgula final: {"a":1,} / [1,]
+            // chave sem valor ("a":}) é inválida; sobe da chave para o objeto
+            if (super >= 0 && toks[super].type == JSON_TOK_STRING) {
+                if (toks[super].size == 0) return JSON_ERR_INVAL;
+                super = toks[super].parent;
+            }
+            if (super < 0 || toks[super].type != type || toks[super].end != TOK_UNSET) {
+                return JSON_ERR_INVAL;
+            }
+            toks[super].end = (uint16_t)(pos + 1);
+            super = toks[super].parent;
+            // valor de uma chave terminou: volta para o objeto
+            if (super >= 0 && toks[super].type == JSON_TOK_STRING) super = toks[super].parent;
+            if (super < 0) root_done = true;
+            break;
+        }
+
+        case '"': {
+            if (!attach_ok(toks, super, JSON_TOK_STRING, sep)) return JSON_ERR_INVAL;
+            size_t start = pos + 1;
+            size_t end = start;
+            while (end < len && js[end] != '\0' && js[end] != '"') {
+                if (js[end] == '\\') {
+                    end++;
+                    if (end >= len || js[end] == '\0') return JSON_ERR_PART;
+                }
+                end++;
+            }
+            if (end >= len || js[end] != '"') return JSON_ERR_PART;
+
+            json_tok_t *t = tok_new(toks, max_toks, &next, JSON_TOK_STRING, (int16_t)super, start, end);
+            if (!t) return JSON_ERR_NOMEM;
+            if (super >= 0) toks[super].size++;
+            need_colon = (super >= 0 && toks[super].type == JSON_TOK_OBJECT);
+            sep = false;
+            pos = end;
+            if (super < 0) root_done = true;
+            break;
+        }
+
+        case ':':
+            // a chave é o último token e pertence ao objeto atual; ela vira o "super" do valor
+            if (super < 0 || toks[super].type != JSON_TOK_OBJECT || next == 0) return JSON_ERR_INVAL;
+            if (toks[next - 1].type != JSON_TOK_STRING || toks[next - 1].parent != super) return JSON_ERR_INVAL;
+            if (toks[next - 1].size != 0) return JSON_ERR_INVAL;
+            super = next - 1;
+            need_colon = false;
+            break;
+
+        case ',':
+            if (sep) return JSON_ERR_INVAL;
+            if (super >= 0 && toks[super].type == JSON_TOK_STRING) {
+                if (toks[super].size == 0) return JSON_ERR_INVAL;
+                super = toks[super].parent;
+            }
+            // só separa itens: precisa de um item antes ({,} / [,1] são inválidos)
+            if (super < 0 || toks[super].size == 0) return JSON_ERR_INVAL;
+            sep = true;
+            break;
+
+        default: {
+            // primitivo: número, true, false, null
+            if (!(c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')) {
+                return JSON_ERR_INVAL;
+            }
+            if (!attach_ok(toks, super, JSON_TOK_PRIMITIVE, sep)) return JSON_ERR_INVAL;
+            size_t end = pos;
+            while (end < len && js[end] != '\0' && !is_delim(js[end])) {
+                if (js[end] < 32 || js[end] >= 127) return JSON_ERR_INVAL;
+                end++;
+            }
+            json_tok_t *t = tok_new(toks, max_toks, &next, JSON_TOK_PRIMITIVE, (int16_t)super, pos, end);
+            if (!t) return JSON_ERR_NOMEM;
+            if (super >= 0) toks[super].size++;
+            sep = false;
+            pos = end - 1;
+            if (super < 0) root_done = true;
+            break;
+        }
+        }
+
+        // depois de um valor simples de chave, volta para o objeto
+        if (c != ':' && c != '{' && c != '[' && c != '}' && c != ']' && c != ',' &&
+            super >= 0 && toks[super].type == JSON_TOK_STRING && toks[super].size == 1) {
+            super = toks[super].parent;
+        }
+    }
+
+    if (next == 0 || super >= 0) return JSON_ERR_PART;
+
+    if (doc) doc->count = next;
+    return next;
+}
+
+int json_doc_next_member(const json_doc_t *doc, int *iter, const char **key, size_t *klen)
+{
+    if (!doc || !iter || doc->count < 2 || doc->toks[0].type != JSON_TOK_OBJECT) return -1;
+
+    for (int i = (*iter < 1) ? 1 : *iter; i + 1 < doc->count; i++) {
+        const json_tok_t *k = &doc->toks[i];
+        if (k->parent != 0 || k->type != JSON_TOK_STRING || k->size != 1) continue;
+        if (key)  *key  = doc->json + k->start;
+        if (klen) *klen = (size_t)(k->end - k->start);
+        *iter = i + 1;
+        return i + 1; // o valor vem logo após a chave
+    }
+    *iter = doc->count;
+    return -1;
+}
+
+int json_doc_find(const json_doc_t *doc, const char *key)
+{
+    if (!key) return -1;
+
+    size_t klen = strlen(key);
+    const char *k;
+    size_t n;
+    int it = 0;
+    int v;
+    while ((v = json_doc_next_member(doc, &it, &k, &n)) >= 0) {
+        if (n == klen && memcmp(k, key, klen) == 0) return v;
+    }
+    return -1;
+}
+
+bool json_doc_tok_string(const json_doc_t *doc, int idx, char *out, size_t outsz)
+{
+    if (!doc || idx < 0 || idx >= doc->count || outsz == 0) return false;
+    if (doc->toks[idx].type != JSON_TOK_STRING) return false;
+
+    const char *p   = doc->json + doc->toks[idx].start;
+    const char *end = doc->json + doc->toks[idx].end;
 
     size_t i = 0;
-    while (*p && *p != '"' && i + 1 < outsz) {
-        out[i++] = *p++;
+    while (p < end && i + 1 < outsz) {
+        char c = *p++;
+        if (c == '\\' && p < end) {
+            c = *p++;
+            switch (c) {
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case 'r': c = '\r'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'u': c = '?'; p = (end - p > 4) ? p + 4 : end; break; // sem suporte a unicode
+            default: break; // \" \\ \/
+            }
+        }
+        out[i++] = c;
     }
     out[i] = '\0';
     return (i > 0);
 }
 
-bool json_get_int(const char *json, const char *key, int *out)
+bool json_doc_tok_int(const json_doc_t *doc, int idx, int *out)
 {
-    const char *p = find_key(json, key);
-    if (!p) return false;
+    if (!doc || idx < 0 || idx >= doc->count) return false;
 
-    p = strchr(p, ':');
-    if (!p) return false;
-    p++;
+    const json_tok_t *t = &doc->toks[idx];
+    if (t->type != JSON_TOK_PRIMITIVE && t->type != JSON_TOK_STRING) return false;
 
-    while (*p && (isspace((unsigned char)*p) || *p == '"')) p++;
+    const char *p   = doc->json + t->start;
+    const char *end = doc->json + t->end;
 
-    int sign = 1;
-    if (*p == '-') { sign = -1; p++; }
+    while (p < end && is_space(*p)) p++;
 
-    if (!isdigit((unsigned char)*p)) return false;
+    bool neg = false;
+    if (p < end && *p == '-') { neg = true; p++; }
+    if (p >= end || *p < '0' || *p > '9') return false;
 
-    int v = 0;
-    while (*p && isdigit((unsigned char)*p)) {
-        v = v * 10 + (*p - '0');
+    // satura antes de multiplicar: long tem 32 bits no RP2040, acc * 10 estouraria
+    int acc = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        int d = *p - '0';
+        acc = (acc > (INT_MAX - d) / 10) ? INT_MAX : acc * 10 + d;
         p++;
     }
-    *out = v * sign;
+    *out = (int)(neg ? -acc : acc);
     return true;
 }
+
+bool json_doc_get_string(const json_doc_t *doc, const char *key, char *out, size_t outsz)
+{
+    return json_doc_tok_string(doc, json_doc_find(doc, key), out, outsz);
+}
+
+bool json_doc_get_int(const json_doc_t *doc, const char *key, int *out)
+{
+    return json_doc_tok_int(doc, json_doc_find(doc, key), out);
+}
+
+bool json_doc_get_bool(const json_doc_t *doc, const char *key, bool *out)
+{
+    int v = json_doc_find(doc, key);
+    if (v < 0 || doc->toks[v].type != JSON_TOK_PRIMITIVE) return false;
+
+    char c = doc->json[doc->toks[v].start];
+    if (c != 't' && c != 'f') return false;
+    *out = (c == 't');
+    return true;
+}
+
+bool json_doc_string_eq(const json_doc_t *doc, const char *key, const char *value)
+{
+    int v = json_doc_find(doc, key);
+    if (v < 0 || doc->toks[v].type != JSON_TOK_STRING) return false;
+
+    size_t n = strlen(value);
+    return (size_t)(doc->toks[v].end - doc->toks[v].start) == n &&
+           memcmp(doc->json + doc->toks[v].start, value, n) == 0;
+}
+
+bool json_get_string(const char *json, const char *key, char *out, size_t outsz)
+{
+    json_tok_t toks[JSON_MAX_TOKENS_DEFAULT];
+    json_doc_t doc;
+    if (json_parse(&doc, json, json ? strlen(json) : 0, toks, JSON_MAX_TOKENS_DEFAULT) < 0) return false;
+    return json_doc_get_string(&doc, key, out, outsz);
+}
+
+bool json_get_int(const char *json, const char *key, int *out)
+{
+    json_tok_t toks[JSON_MAX_TOKENS_DEFAULT];
+    json_doc_t doc;
+    if (json_parse(&doc, json, json ? strlen(json) : 0, toks, JSON_MAX_TOKENS_DEFAULT) < 0) return false;
+    return json_doc_get_int(&doc, key, out);
+}
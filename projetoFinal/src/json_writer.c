@@ -0,0 +1,215 @@
+#include "json_writer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void emit(json_writer_t *w, const char *data, size_t len)
+{
+    if (len == 0) return;
+    size_t n = w->sink(w->arg, data, len);
+    if (n != len) w->err = true;
+    w->len += n;
+}
+
+static inline void emit_c(json_writer_t *w, char c)
+{
+    emit(w, &c, 1);
+}
+
+/**
+ * @brief String com aspas e escape mínimo exigido pelo JSON.
+ */
+static void emit_quoted(json_writer_t *w, const char *s)
+{
+    emit_c(w, '"');
+
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+
+        emit(w, run, (size_t)(s - run));
+        run = s + 1;
+
+        char esc[6] = { '\\', (char)c, 0, 0, 0, 0 };
+        size_t n = 2;
+        if (c == '\n')      esc[1] = 'n';
+        else if (c == '\r') esc[1] = 'r';
+        else if (c == '\t') esc[1] = 't';
+        else if (c < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            esc[1] = 'u'; esc[2] = '0'; esc[3] = '0';
+            esc[4] = hex[c >> 4]; esc[5] = hex[c & 0xF];
+            n = 6;
+        }
+        emit(w, esc, n);
+    }
+    emit(w, run, (size_t)(s - run));
+
+    emit_c(w, '"');
+}
+
+/**
+ * @brief Separador + "key": (key NULL = elemento de array).
+ */
+static void member(json_writer_t *w, const char *key)
+{
+    if (w->comma) emit_c(w, ',');
+    w->comma = true;
+    if (key) {
+        emit_quoted(w, key);
+        emit_c(w, ':');
+    }
+}
+
+static void emit_u32(json_writer_t *w, uint32_t v)
+{
+    char tmp[10];
+    size_t i = sizeof(tmp);
+    do {
+        tmp[--i] = (char)('0' + (v % 10u));
+        v /= 10u;
+    } while (v);
+    emit(w, &tmp[i], sizeof(tmp) - i);
+}
+
+void json_w_init(json_writer_t *w, json_sink_fn sink, void *arg)
+{
+    w->sink  = sink;
+    w->arg   = arg;
+    w->len   = 0;
+    w->comma = false;
+    w->err   = false;
+}
+
+void json_w_begin(json_writer_t *w)
+{
+    emit_c(w, '{');
+    w->comma = false;
+}
+
+void json_w_end(json_writer_t *w)
+{
+    emit_c(w, '}');
+    w->comma = true;
+}
+
+void json_w_begin_obj(json_writer_t *w, const char *key)
+{
+    member(w, key);
+    json_w_begin(w);
+}
+
+void json_w_begin_arr(json_writer_t *w, const char *key)
+{
+    member(w, key);
+    emit_c(w, '[');
+    w->comma = false;
+}
+
+void json_w_end_arr(json_writer_t *w)
+{
+    emit_c(w, ']');
+    w->comma = true;
+}
+
+void json_w_str(json_writer_t *w, const char *key, const char *val)
+{
+    member(w, key);
+    emit_quoted(w, val ? val : "");
+}
+
+void json_w_uint(json_writer_t *w, const char *key, uint32_t val)
+{
+    member(w, key);
+    emit_u32(w, val);
+}
+
+void json_w_int(json_writer_t *w, const char *key, int32_t val)
+{
+    member(w, key);
+    if (val < 0) {
+        emit_c(w, '-');
+        emit_u32(w, (uint32_t)(-(int64_t)val));
+    } else {
+        emit_u32(w, (uint32_t)val);
+    }
+}
+
+void json_w_bool(json_writer_t *w, const char *key, bool val)
+{
+    member(w, key);
+    if (val) emit(w, "true", 4);
+    else     emit(w, "false", 5);
+}
+
+void json_w_fixed(json_writer_t *w, const char *key, float val, uint8_t decimals)
+{
+    static const uint32_t pow10[] = { 1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u };
+
+    member(w, key);
+
+    // NaN (val != val) ou fora da faixa de 32 bits inteiros
+    if (val != val || val > 4.0e9f || val < -4.0e9f) {
+        emit(w, "null", 4);
+        return;
+    }
+    if (decimals > 6) decimals = 6;
+
+    bool neg = (val < 0.0f);
+    float a = neg ? -val : val;
+    uint64_t scaled = (uint64_t)(a * (float)pow10[decimals] + 0.5f);
+    if (scaled == 0) neg = false; // evita "-0.00"
+
+    uint64_t ip = scaled / pow10[decimals];
+    uint32_t fp = (uint32_t)(scaled % pow10[decimals]);
+
+    if (neg) emit_c(w, '-');
+
+    char tmp[24];
+    size_t i = sizeof(tmp);
+    for (uint8_t d = 0; d < decimals; d++) {
+        tmp[--i] = (char)('0' + (fp % 10u));
+        fp /= 10u;
+    }
+    if (decimals) tmp[--i] = '.';
+    do {
+        tmp[--i] = (char)('0' + (ip % 10u));
+        ip /= 10u;
+    } while (ip);
+    emit(w, &tmp[i], sizeof(tmp) - i);
+}
+
+void json_w_raw(json_writer_t *w, const char *data, size_t len)
+{
+    emit(w, data, len);
+}
+
+void json_w_member_raw(json_writer_t *w, const char *key, const char *data, size_t len)
+{
+    member(w, key);
+    emit(w, data, len);
+}
+
+size_t json_sink_count(void *arg, const char *data, size_t len)
+{
+    (void)arg;
+    (void)data;
+    return len;
+}
+
+size_t json_sink_buf(void *arg, const char *data, size_t len)
+{
+    json_buf_sink_t *b = (json_buf_sink_t*)arg;
+    size_t room = (b->len < b->cap) ? (b->cap - b->len) : 0;
+    size_t n = (len < room) ? len : room;
+    memcpy(b->buf + b->len, data, n);
+    b->len += n;
+    return n;
+}
+
+size_t json_sink_stdout(void *arg, const char *data, size_t len)
+{
+    (void)arg;
+    return fwrite(data, 1, len, stdout);
+}
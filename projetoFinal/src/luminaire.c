@@ -0,0 +1,142 @@
+#include "luminaire.h"
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+
+#include "app_config.h"
+#include "app_log.h"
+#include "matrix_led_lib.h"
+
+// WS2812 @ 800 kHz: 24 bits = 30 us por LED; reset > 280 us (WS2812B V5)
+#define LUM_US_PER_LED   30u
+#define LUM_RESET_US     300u
+
+/**
+ * @brief Estado de um canal (fita) da luminária.
+ */
+typedef struct {
+    PIO      pio;
+    uint     sm;
+    int      dma_ch;
+    uint16_t led_count;
+} lum_channel_t;
+
+static lum_channel_t g_ch[APP_LUM_MAX_CHANNELS];
+static uint8_t g_ch_count = 0;
+static uint32_t g_dma_mask = 0;
+
+// Buffers já deslocados (<< 8) no formato do TX FIFO, lidos diretamente pelo DMA
+static uint32_t g_pixels[APP_LUM_MAX_CHANNELS][APP_LUM_MAX_LEDS_PER_CH];
+
+// Instante a partir do qual o próximo quadro pode ser enviado (fim da fita + reset)
+static uint64_t g_ready_at_us = 0;
+static uint16_t g_max_leds = 0;
+
+// o CYW43 só sobe depois (vTaskWifi) e precisa de uma SM livre em pio0 ou pio1
+_Static_assert(APP_LUM_MAX_CHANNELS <= 2u * NUM_PIO_STATE_MACHINES - 1u, "APP_LUM_MAX_CHANNELS: reservar SM do CYW43");
+
+/**
+ * @brief Reserva uma state machine livre, tentando pio0 e depois pio1.
+ *
+ * Sem índices fixos: o driver CYW43 do Pico W usa a SM que sobrar quando inicializar
+ * (APP_LUM_MAX_CHANNELS garante que sobra uma).
+ */
+static bool claim_sm(PIO *pio_out, uint *sm_out)
+{
+    PIO pios[2] = { pio0, pio1 };
+    for (int i = 0; i < 2; i++) {
+        int sm = pio_claim_unused_sm(pios[i], false);
+        if (sm >= 0) {
+            *pio_out = pios[i];
+            *sm_out  = (uint)sm;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t luminaire_init(void)
+{
+    static const uint8_t  pins[] = APP_LUM_CHANNEL_PINS;
+    static const uint16_t leds[] = APP_LUM_CHANNEL_LEDS;
+    _Static_assert(sizeof(pins) / sizeof(pins[0]) == APP_LUM_CHANNEL_COUNT, "APP_LUM_CHANNEL_PINS");
+    _Static_assert(sizeof(leds) / sizeof(leds[0]) == APP_LUM_CHANNEL_COUNT, "APP_LUM_CHANNEL_LEDS");
+    _Static_assert(APP_LUM_CHANNEL_COUNT <= APP_LUM_MAX_CHANNELS, "APP_LUM_CHANNEL_COUNT");
+
+    g_ch_count = 0;
+    g_dma_mask = 0;
+    g_max_leds = 0;
+
+    for (uint8_t i = 0; i < APP_LUM_CHANNEL_COUNT; i++) {
+        lum_channel_t *c = &g_ch[g_ch_count];
+
+        if (!claim_sm(&c->pio, &c->sm)) {
+            LOG_W("LUM: sem state machine livre para canal %u (pino %u)", i, pins[i]);
+            break;
+        }
+        c->dma_ch = dma_claim_unused_channel(false);
+        if (c->dma_ch < 0) {
+            LOG_W("LUM: sem canal DMA livre para canal %u", i);
+            pio_sm_unclaim(c->pio, c->sm);
+            break;
+        }
+
+        c->led_count = (leds[i] > APP_LUM_MAX_LEDS_PER_CH) ? APP_LUM_MAX_LEDS_PER_CH : leds[i];
+        if (c->led_count > g_max_leds) g_max_leds = c->led_count;
+
+        matrix_init(c->pio, c->sm, pins[i]);
+
+        dma_channel_config dc = dma_channel_get_default_config((uint)c->dma_ch);
+        channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+        channel_config_set_read_increment(&dc, true);
+        channel_config_set_write_increment(&dc, false);
+        channel_config_set_dreq(&dc, pio_get_dreq(c->pio, c->sm, true));
+        dma_channel_configure((uint)c->dma_ch, &dc,
+                              &c->pio->txf[c->sm],
+                              g_pixels[g_ch_count],
+                              c->led_count,
+                              false);
+
+        g_dma_mask |= 1u << (uint)c->dma_ch;
+        g_ch_count++;
+    }
+
+    LOG_I("LUM: %u canal(is) ativo(s)", g_ch_count);
+    return g_ch_count;
+}
+
+uint8_t luminaire_channel_count(void)
+{
+    return g_ch_count;
+}
+
+void luminaire_set_channel_color(uint8_t ch, uint32_t pixel_grb)
+{
+    if (ch >= g_ch_count) return;
+
+    uint32_t word = pixel_grb << 8u;
+    uint32_t *px = g_pixels[ch];
+    for (uint16_t i = 0; i < g_ch[ch].led_count; i++) {
+        px[i] = word;
+    }
+}
+
+bool luminaire_show(void)
+{
+    if (g_ch_count == 0) return false;
+
+    uint64_t now = time_us_64();
+    if (now < g_ready_at_us) return false;
+
+    // Rearma endereço de leitura de cada canal e dispara todos juntos
+    for (uint8_t i = 0; i < g_ch_count; i++) {
+        dma_channel_set_read_addr((uint)g_ch[i].dma_ch, g_pixels[i], false);
+    }
+    dma_start_channel_mask(g_dma_mask);
+
+    g_ready_at_us = now + (uint64_t)g_max_leds * LUM_US_PER_LED + LUM_RESET_US;
+    return true;
+}
@@ -1,17 +1,27 @@
 #include "matrix_control.h"
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "app_config.h"
+#include "app_log.h"
+#include "app_trace.h"
+#include "dispatch.h"
 #include "json_simple.h"
 
 /**
  * @brief Estado interno do controlador.
  */
 static volatile matrix_mode_t g_mode = MATRIX_MODE_AUTO;
-static volatile uint8_t g_target_percent = 100;  // alvo MANUAL (0..100)
-static volatile uint8_t g_current_percent = 100; // aplicado (com fade)
+static volatile uint8_t g_target_percent[APP_LUM_CHANNEL_COUNT];  // alvo MANUAL por canal (0..100)
+static volatile uint8_t g_current_percent[APP_LUM_CHANNEL_COUNT]; // aplicado por canal (com fade)
+
+// Nomes na ordem de matrix_key_t
+static const char *const k_key_names[MATRIX_KEY_COUNT] = {
+    "mode", "matrixPercent", "brightness", "percent", "channel"
+};
+static dispatch_table_t g_keys;
 
 /**
  * @brief Saturação para [0..100].
@@ -74,63 +84,187 @@ static inline uint8_t auto_percent_inverse_from_lux(float luxv)
 
 void matrix_control_init(void)
 {
+    if (!dispatch_build(&g_keys, k_key_names, MATRIX_KEY_COUNT)) {
+        LOG_E("[CMD] falha ao montar tabela de chaves");
+    }
+
     g_mode = MATRIX_MODE_AUTO;
-    g_target_percent = 100;
-    g_current_percent = 100;
+    for (uint8_t ch = 0; ch < APP_LUM_CHANNEL_COUNT; ch++) {
+        g_target_percent[ch] = 100;
+        g_current_percent[ch] = 100;
+    }
 }
 
 void matrix_control_apply_cmd_payload(const char *payload)
 {
     if (!payload || !payload[0]) return;
 
-    // mode
-    char mode[16] = {0};
-    if (json_get_string(payload, "mode", mode, sizeof(mode))) {
-        if (strcmp(mode, "auto") == 0) {
-            g_mode = MATRIX_MODE_AUTO;
-            printf("[CMD] mode=auto\n");
-        } else if (strcmp(mode, "manual") == 0) {
-            g_mode = MATRIX_MODE_MANUAL;
-            printf("[CMD] mode=manual\n");
+    json_tok_t toks[JSON_MAX_TOKENS_DEFAULT];
+    json_doc_t doc;
+    int n = json_parse(&doc, payload, strlen(payload), toks, JSON_MAX_TOKENS_DEFAULT);
+    if (n < 0) {
+        LOG_W("[CMD] JSON invalido (%d)", n);
+        return;
+    }
+    matrix_control_apply_cmd_doc(&doc);
+}
+
+void matrix_control_apply_cmd_doc(const json_doc_t *doc)
+{
+    if (!doc || doc->count == 0) return;
+
+    matrix_cmd_t cmd = {0};
+    uint8_t pct_rank = 0;
+
+    // uma passada pelos membros da raiz; cada chave resolvida por hash
+    const char *k;
+    size_t klen;
+    int it = 0;
+    int v;
+    while ((v = json_doc_next_member(doc, &it, &k, &klen)) >= 0) {
+        matrix_key_t key = matrix_control_key_lookup(k, klen);
+        if (key == MATRIX_KEY_NONE) continue;
+
+        const json_tok_t *t = &doc->toks[v];
+        if (t->type != JSON_TOK_STRING && t->type != JSON_TOK_PRIMITIVE) continue;
+
+        matrix_control_cmd_field(&cmd, &pct_rank, key,
+                                 doc->json + t->start, (size_t)(t->end - t->start),
+                                 t->type == JSON_TOK_STRING);
+    }
+
+    matrix_control_apply_cmd(&cmd);
+}
+
+matrix_key_t matrix_control_key_lookup(const char *name, size_t len)
+{
+    int i = dispatch_lookup(&g_keys, name, len);
+    return (i < 0) ? MATRIX_KEY_NONE : (matrix_key_t)i;
+}
+
+/**
+ * @brief Inteiro com sinal (aceita espaços à esquerda; para no primeiro não-dígito).
+ */
+static bool text_to_i32(const char *s, size_t len, int32_t *out)
+{
+    const char *end = s + len;
+
+    while (s < end && (*s == ' ' || *s == '\t')) s++;
+
+    bool neg = false;
+    if (s < end && *s == '-') { neg = true; s++; }
+    if (s >= end || *s < '0' || *s > '9') return false;
+
+    int32_t acc = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        acc = (acc > (INT32_MAX - 9) / 10) ? INT32_MAX : acc * 10 + (*s - '0');
+        s++;
+    }
+    *out = neg ? -acc : acc;
+    return true;
+}
+
+void matrix_control_cmd_field(matrix_cmd_t *cmd, uint8_t *pct_rank, matrix_key_t key,
+                              const char *val, size_t len, bool is_string)
+{
+    int32_t v;
+
+    switch (key) {
+    case MATRIX_KEY_MODE:
+        if (!is_string || len == 0) break;
+        cmd->flags &= (uint8_t)~(MATRIX_CMD_F_MODE | MATRIX_CMD_F_MODE_BAD);
+        if (len == 4 && memcmp(val, "auto", 4) == 0) {
+            cmd->mode = MATRIX_MODE_AUTO;
+            cmd->flags |= MATRIX_CMD_F_MODE;
+        } else if (len == 6 && memcmp(val, "manual", 6) == 0) {
+            cmd->mode = MATRIX_MODE_MANUAL;
+            cmd->flags |= MATRIX_CMD_F_MODE;
         } else {
-            printf("[CMD] mode desconhecido: %s\n", mode);
+            cmd->flags |= MATRIX_CMD_F_MODE_BAD;
+        }
+        break;
+
+    case MATRIX_KEY_MATRIX_PERCENT:
+    case MATRIX_KEY_BRIGHTNESS:
+    case MATRIX_KEY_PERCENT: {
+        // precedência: matrixPercent (3) > brightness (2) > percent (1)
+        uint8_t rank = (uint8_t)(MATRIX_KEY_PERCENT + 1 - key);
+        if (rank >= *pct_rank && text_to_i32(val, len, &v)) {
+            cmd->percent = v;
+            cmd->flags |= MATRIX_CMD_F_PERCENT;
+            *pct_rank = rank;
+        }
+        break;
+    }
+
+    case MATRIX_KEY_CHANNEL:
+        if (text_to_i32(val, len, &v)) {
+            cmd->channel = (v < INT16_MIN) ? INT16_MIN : (v > INT16_MAX) ? INT16_MAX : (int16_t)v;
+            cmd->flags |= MATRIX_CMD_F_CHANNEL;
         }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void matrix_control_apply_cmd(const matrix_cmd_t *cmd)
+{
+    if (!cmd) return;
+
+    // comando recusado não muda nada: o canal é validado antes de qualquer estado
+    int ch = -1;
+    if (cmd->flags & MATRIX_CMD_F_CHANNEL) {
+        ch = cmd->channel;
+        if (ch < 0 || ch >= (int)APP_LUM_CHANNEL_COUNT) {
+            LOG_W("[CMD] canal invalido: %d", ch);
+            return;
+        }
+    }
+
+    if (cmd->flags & MATRIX_CMD_F_MODE) {
+        g_mode = (matrix_mode_t)cmd->mode;
+        LOG_I("[CMD] mode=%s", (g_mode == MATRIX_MODE_AUTO) ? "auto" : "manual");
+    } else if (cmd->flags & MATRIX_CMD_F_MODE_BAD) {
+        LOG_W("[CMD] mode desconhecido");
     }
 
-    // percent
-    int v = 0;
-    if (json_get_int(payload, "matrixPercent", &v) ||
-        json_get_int(payload, "brightness", &v) ||
-        json_get_int(payload, "percent", &v)) {
+    if (cmd->flags & MATRIX_CMD_F_PERCENT) {
+        uint8_t p = clamp_u8_0_100((int)cmd->percent);
 
-        uint8_t p = clamp_u8_0_100(v);
-        g_target_percent = p;
+        if (ch >= 0) {
+            g_target_percent[ch] = p;
+        } else {
+            for (uint8_t i = 0; i < APP_LUM_CHANNEL_COUNT; i++) {
+                g_target_percent[i] = p;
+            }
+        }
 
         // Se mandou percent sem declarar mode, assume MANUAL (útil para controle rápido).
         if (g_mode != MATRIX_MODE_MANUAL) {
             g_mode = MATRIX_MODE_MANUAL;
-            printf("[CMD] assumindo modo manual\n");
+            LOG_I("[CMD] assumindo modo manual");
         }
-        printf("[CMD] target=%u%%\n", (unsigned)p);
+        TRACE2(CMD_TARGET, p, ch);
     }
 }
 
 uint8_t matrix_control_update_from_lux(float lux_filtered)
 {
-    // define alvo conforme modo
-    uint8_t desired = 0;
-    if (g_mode == MATRIX_MODE_MANUAL) {
-        desired = g_target_percent;
-    } else {
-        desired = auto_percent_inverse_from_lux(lux_filtered);
-    }
+    // em AUTO todos os canais seguem o mesmo alvo derivado do lux
+    uint8_t auto_desired = auto_percent_inverse_from_lux(lux_filtered);
+    bool manual = (g_mode == MATRIX_MODE_MANUAL);
 
-    // aplica fading
-    uint8_t cur = g_current_percent;
-    cur = step_towards_u8(cur, desired);
-    g_current_percent = cur;
+    for (uint8_t ch = 0; ch < APP_LUM_CHANNEL_COUNT; ch++) {
+        // define alvo conforme modo
+        uint8_t desired = manual ? g_target_percent[ch] : auto_desired;
 
-    return cur;
+        // aplica fading
+        g_current_percent[ch] = step_towards_u8(g_current_percent[ch], desired);
+    }
+
+    return g_current_percent[0];
 }
 
 matrix_mode_t matrix_control_get_mode(void)
@@ -140,10 +274,26 @@ matrix_mode_t matrix_control_get_mode(void)
 
 uint8_t matrix_control_get_target_percent(void)
 {
-    return g_target_percent;
+    return g_target_percent[0];
 }
 
 uint8_t matrix_control_get_current_percent(void)
 {
-    return g_current_percent;
+    return g_current_percent[0];
+}
+
+uint8_t matrix_control_get_channel_target(uint8_t ch)
+{
+    return (ch < APP_LUM_CHANNEL_COUNT) ? g_target_percent[ch] : 0;
+}
+
+uint8_t matrix_control_get_channel_percent(uint8_t ch)
+{
+    return (ch < APP_LUM_CHANNEL_COUNT) ? g_current_percent[ch] : 0;
+}
+
+void matrix_control_set_channel_target(uint8_t ch, uint8_t percent)
+{
+    if (ch >= APP_LUM_CHANNEL_COUNT) return;
+    g_target_percent[ch] = clamp_u8_0_100(percent);
 }
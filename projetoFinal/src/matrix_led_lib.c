@@ -3,6 +3,7 @@
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
 #include "ws2812.pio.h"
+#include "app_log.h"
 #include "matrix_led_lib.h"
 
 #define max_value_light 50
@@ -52,7 +53,7 @@ uint32_t matrix_set_brightness_percent_inverse_from_lux_ex(float lux, uint8_t *o
 
     uint8_t v = (uint8_t)((inv * (uint32_t)max_value_light + 50) / 100);
 
-    printf("lux=%.1f  percent=%u%%  inv=%u%%  v=%u\n", lux, percent, inv, v);
+    LOG_D("lux=%.1f  percent=%u%%  inv=%u%%  v=%u", lux, percent, inv, v);
 
     return ((uint32_t)v << 16) | ((uint32_t)v << 8) | (uint32_t)v; // GRB
 }
@@ -93,6 +94,13 @@ void put_pixel(PIO pio, uint sm, uint32_t pixel_grb)
 
 void matrix_init(PIO pio, uint sm, uint pin)
 {
-    uint offset = pio_add_program(pio, &ws2812_program);
-    ws2812_program_init(pio, sm, offset, pin, 800000.0f, false);
+    // programa carregado uma única vez por bloco PIO (vários canais compartilham)
+    static bool loaded[NUM_PIOS];
+    static uint offsets[NUM_PIOS];
+    uint idx = pio_get_index(pio);
+    if (!loaded[idx]) {
+        offsets[idx] = pio_add_program(pio, &ws2812_program);
+        loaded[idx] = true;
+    }
+    ws2812_program_init(pio, sm, offsets[idx], pin, 800000.0f, false);
 }
@@ -5,9 +5,18 @@
 
 #include "pico/unique_id.h"
 #include "pico/cyw43_arch.h"
+#include "pico/platform.h"
+
+#include "lwip/pbuf.h"
 
 #include "app_config.h"
+#include "app_log.h"
+#include "json_writer.h"
 #include "net_dns.h"
+#include "telemetry_json.h"
+
+// task que chamou mqtt_app_flush_telemetry(): acordada a cada PUBACK
+static TaskHandle_t g_task;
 
 // ================================
 // Helpers
@@ -31,11 +40,15 @@ static void mqtt_connection_cb(mqtt_client_t *client, void *arg, mqtt_connection
     (void)client;
     mqtt_app_t *m = (mqtt_app_t*)arg;
 
+    bool was_connecting = m->connecting;
     m->connecting = false; // <<< FIX: terminou a tentativa (sucesso ou falha)
 
     bool ok = (status == MQTT_CONNECT_ACCEPTED);
     m->connected = ok;
 
+    // queda de uma conexão aceita mantém o endereço; falha ao conectar o põe em dúvida
+    if (!ok && was_connecting) m->dns_suspect = true;
+
     if (ok) {
         m->need_subscribe = true; // assina cmd após conectar
     } else {
@@ -51,38 +64,94 @@ static void mqtt_incoming_publish_cb(void *arg, const char *topic, u32_t tot_len
     (void)tot_len;
     mqtt_app_t *m = (mqtt_app_t*)arg;
 
-    if (m->cmd_ready) return;
-
-    snprintf(m->cmd_topic, sizeof(m->cmd_topic), "%s", topic);
-
-    m->cmd_len = 0;
-    memset(m->cmd_buf, 0, sizeof(m->cmd_buf));
+    // só o tópico de comando é interpretado; o resto é descartado sem copiar
+    m->cmd_skip = (strcmp(topic, m->topic_cmd) != 0);
+    cmd_parser_reset(&m->cmd_parser);
 }
 
 static void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t flags)
 {
     mqtt_app_t *m = (mqtt_app_t*)arg;
-    if (m->cmd_ready) return;
+    if (m->cmd_skip) return;
 
-    uint16_t can = (uint16_t)(sizeof(m->cmd_buf) - 1 - m->cmd_len);
-    uint16_t n = (len < can) ? len : can;
+    // cada fragmento é consumido no lugar, como o lwIP entrega
+    cmd_parse_status_t st = cmd_parser_feed(&m->cmd_parser, data, len);
 
-    if (n > 0) {
-        memcpy(&m->cmd_buf[m->cmd_len], data, n);
-        m->cmd_len += n;
-        m->cmd_buf[m->cmd_len] = '\0';
+    if (st == CMD_PARSE_ERROR) {
+        m->cmd_errors++;
+        m->cmd_skip = true;
+        return;
     }
 
     if (flags & MQTT_DATA_FLAG_LAST) {
-        m->cmd_ready = true;
+        if (st == CMD_PARSE_DONE) {
+            (void)cmd_ring_push(&m->cmd_ring, &m->cmd_parser.cmd);
+        } else {
+            m->cmd_errors++; // terminou com o objeto aberto
+        }
     }
 }
 
-static void mqtt_pub_cb(void *arg, err_t err)
+/**
+ * @brief PUBACK (ou desistência do lwIP) de uma telemetria da fila de saída.
+ *
+ * Ao fechar a conexão o lwIP descarta as requisições sem chamar este callback,
+ * então só entradas SENT da conexão atual chegam aqui.
+ */
+static void mqtt_out_cb(void *arg, err_t err)
 {
-    mqtt_app_t *m = (mqtt_app_t*)arg;
-    m->pub_err  = err;
-    m->pub_done = true;
+    mqtt_out_entry_t *e = (mqtt_out_entry_t*)arg;
+    e->state = (err == ERR_OK) ? MQTT_OUT_ACKED : MQTT_OUT_FAILED;
+
+    TaskHandle_t t = g_task;
+    if (!t) return;
+
+    if (__get_current_exception()) {
+        BaseType_t hpw = pdFALSE;
+        vTaskNotifyGiveFromISR(t, &hpw);
+        portYIELD_FROM_ISR(hpw);
+    } else {
+        xTaskNotifyGive(t);
+    }
+}
+
+// ================================
+// Fila de saída (telemetria até o PUBACK)
+// ================================
+static mqtt_out_entry_t *outbox_at(mqtt_outbox_t *o, uint32_t i)
+{
+    return &o->e[(o->head + i) % APP_MQTT_INFLIGHT_LEN];
+}
+
+/**
+ * @brief Retira da frente as confirmadas (só a frente: a ordem de seq é mantida).
+ */
+static void outbox_retire(mqtt_app_t *m)
+{
+    mqtt_outbox_t *o = &m->out;
+
+    while (o->count > 0 && outbox_at(o, 0)->state == MQTT_OUT_ACKED) {
+        m->last_sent_seq = outbox_at(o, 0)->frame.seq;
+        o->head = (o->head + 1u) % APP_MQTT_INFLIGHT_LEN;
+        o->count--;
+        o->acked++;
+    }
+}
+
+/**
+ * @brief Nova conexão: o que estava no ar sem PUBACK volta a ser pendente.
+ *
+ * Só chamar com o cliente desconectado (nenhum callback de publish pode chegar).
+ */
+static void outbox_requeue(mqtt_app_t *m)
+{
+    mqtt_outbox_t *o = &m->out;
+
+    outbox_retire(m);
+    for (uint32_t i = 0; i < o->count; i++) {
+        mqtt_out_entry_t *e = outbox_at(o, i);
+        if (e->state == MQTT_OUT_SENT || e->state == MQTT_OUT_FAILED) e->state = MQTT_OUT_QUEUED;
+    }
 }
 
 // ================================
@@ -99,8 +168,11 @@ void mqtt_app_init(mqtt_app_t *m, const char *device_id)
     }
 
     make_topics(m, m->device_id);
+    cmd_ring_init(&m->cmd_ring);
 
-    m->client = mqtt_client_new();
+    // sem mqtt_client_new() aqui: o lwIP só existe depois que a vTaskWifi inicia o cyw43;
+    // mqtt_app_connect_once() cria o cliente na primeira tentativa
+    m->client = NULL;
 
     m->connected = false;
     m->connecting = false;      // <<< NOVO
@@ -109,7 +181,6 @@ void mqtt_app_init(mqtt_app_t *m, const char *device_id)
     m->conn_event = false;
     m->conn_status = -999;
 
-    m->last_attempt = 0;
     m->last_sent_seq = 0;
 }
 
@@ -131,12 +202,24 @@ bool mqtt_app_connect_once(mqtt_app_t *m)
         return true;
     }
 
+    // o lwIP conecta sempre com clean session: o broker não guarda nada desta sessão,
+    // então tudo o que ficou sem PUBACK é publicado de novo, na ordem, ao conectar
+    outbox_requeue(m);
+
+    // cache do net_dns: reconexão usa o endereço conhecido na hora (revalida em segundo plano)
+    if (m->dns_suspect) {
+        m->dns_suspect = false;
+        net_dns_expire(APP_MQTT_BROKER_HOST);
+    }
+
     ip_addr_t broker_addr;
-    printf("MQTT: resolving %s...\n", APP_MQTT_BROKER_HOST);
+    TickType_t t0 = xTaskGetTickCount();
     if (!net_dns_resolve_host_to_ip(APP_MQTT_BROKER_HOST, &broker_addr, 5000)) {
-        printf("MQTT: DNS failed\n");
+        LOG_W("MQTT: DNS failed");
         return false;
     }
+    LOG_I("MQTT: %s -> %s (%lu ms)", APP_MQTT_BROKER_HOST, ipaddr_ntoa(&broker_addr),
+          (unsigned long)pdTICKS_TO_MS(xTaskGetTickCount() - t0));
 
     struct mqtt_connect_client_info_t ci;
     memset(&ci, 0, sizeof(ci));
@@ -156,19 +239,19 @@ bool mqtt_app_connect_once(mqtt_app_t *m)
 
     // ERR_OK = iniciou tentativa
     if (e == ERR_OK) {
-        printf("MQTT: connect started\n");
+        LOG_I("MQTT: connect started");
         return true;
     }
 
     // ERR_ISCONN (-10) ou ERR_ALREADY (-9) => ignore como “já em andamento”
     if (e == ERR_ISCONN || e == ERR_ALREADY) {
-        printf("MQTT: connect already in progress/connected (err=%d)\n", (int)e);
+        LOG_I("MQTT: connect already in progress/connected (err=%d)", (int)e);
         return true;
     }
 
     // outro erro: limpa connecting para permitir retry
     m->connecting = false;
-    printf("MQTT: mqtt_client_connect() err=%d\n", (int)e);
+    LOG_I("MQTT: mqtt_client_connect() err=%d", (int)e);
     return false;
 }
 
@@ -184,60 +267,131 @@ bool mqtt_app_subscribe_cmd(mqtt_app_t *m)
     err_t e = mqtt_subscribe(m->client, m->topic_cmd, 1, NULL, NULL);
     cyw43_arch_lwip_end();
 
-    printf("MQTT: subscribe cmd (%s) err=%d\n", m->topic_cmd, (int)e);
+    LOG_I("MQTT: subscribe cmd (%s) err=%d", m->topic_cmd, (int)e);
     return (e == ERR_OK);
 }
 
-bool mqtt_app_publish_frame(mqtt_app_t *m, const void *payload, size_t payload_sz, uint32_t seq, TickType_t tick)
+/**
+ * @brief Serializa um frame direto no payload de um pbuf do tamanho exato e publica.
+ *
+ * O lwIP copia o payload para o ring de saída do cliente; o pbuf é liberado na hora.
+ * As duas passadas medem o mesmo texto: ele depende só do frame (estado da luminária
+ * incluído), nunca de valores que mudam entre elas.
+ */
+static err_t publish_telemetry(mqtt_app_t *m, const sensor_frame_t *fr, mqtt_request_cb_t cb, void *arg)
 {
-    (void)tick;
+    // 1) mede o tamanho exato (sem escrever)
+    json_writer_t w;
+    json_w_init(&w, json_sink_count, NULL);
+    telemetry_json_write(&w, NULL, m->device_id, fr);
+    if (w.len == 0 || w.len > 0xFFFFu) return ERR_VAL;
 
-    if (!m->client || !m->connected) return false;
+    // 2) serializa direto no payload de um pbuf do tamanho certo
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t)w.len, PBUF_RAM);
+    cyw43_arch_lwip_end();
+    if (!p) return ERR_MEM;
 
-    m->pub_done = false;
-    m->pub_err  = ERR_INPROGRESS;
+    json_buf_sink_t sink = { .buf = (char*)p->payload, .cap = p->len, .len = 0 };
+    json_w_init(&w, json_sink_buf, &sink);
+    telemetry_json_write(&w, NULL, m->device_id, fr);
 
+    err_t e = ERR_VAL;
     cyw43_arch_lwip_begin();
-    err_t e = mqtt_publish(m->client, m->topic_tele,
-                           (const char*)payload,
-                           (u16_t)payload_sz,
-                           APP_MQTT_QOS, APP_MQTT_RETAIN,
-                           mqtt_pub_cb, m);
+    if (!w.err) {
+        e = mqtt_publish(m->client, m->topic_tele, p->payload, (u16_t)sink.len,
+                         APP_MQTT_QOS, APP_MQTT_RETAIN, cb, arg);
+    }
+    pbuf_free(p);
     cyw43_arch_lwip_end();
 
-    if (e != ERR_OK) return false;
+    return e;
+}
 
-    if (APP_MQTT_QOS > 0) {
-        TickType_t t0 = xTaskGetTickCount();
-        while (!m->pub_done) {
-            if ((xTaskGetTickCount() - t0) > pdMS_TO_TICKS(APP_MQTT_ACK_TIMEOUT_MS)) {
-                return false;
-            }
-            vTaskDelay(pdMS_TO_TICKS(5));
-        }
-        if (m->pub_err == ERR_OK) {
-            m->last_sent_seq = seq;
-            return true;
-        }
-        return false;
+bool mqtt_app_queue_telemetry(mqtt_app_t *m, const sensor_frame_t *fr)
+{
+    mqtt_outbox_t *o = &m->out;
+
+    if (fr->seq == o->last_seq) return false;
+    o->last_seq = fr->seq;
+
+    outbox_retire(m);
+
+    if (o->count == APP_MQTT_INFLIGHT_LEN) {
+        o->lost++;
+        // a da frente aguardando PUBACK (conexão viva) ainda pode ser confirmada: perde a nova
+        if (m->connected && outbox_at(o, 0)->state == MQTT_OUT_SENT) return false;
+        o->head = (o->head + 1u) % APP_MQTT_INFLIGHT_LEN;
+        o->count--;
     }
 
-    m->last_sent_seq = seq;
+    mqtt_out_entry_t *e = outbox_at(o, o->count);
+    e->frame   = *fr;
+    e->sent_at = 0;
+    e->sends   = 0;
+    e->state   = MQTT_OUT_QUEUED;
+    o->count++;
     return true;
 }
 
-bool mqtt_app_take_cmd(mqtt_app_t *m, char *topic_out, size_t topic_sz, char *payload_out, size_t payload_sz)
+bool mqtt_app_flush_telemetry(mqtt_app_t *m)
 {
-    if (!m->cmd_ready) return false;
+    mqtt_outbox_t *o = &m->out;
+
+    g_task = xTaskGetCurrentTaskHandle();
+    outbox_retire(m);
+
+    if (!m->client || !m->connected) return true;
+
+    TickType_t now = xTaskGetTickCount();
+
+    for (uint32_t i = 0; i < o->count; i++) {
+        mqtt_out_entry_t *e = outbox_at(o, i);
 
-    if (topic_out && topic_sz) {
-        snprintf(topic_out, topic_sz, "%s", m->cmd_topic);
+        if (e->state == MQTT_OUT_FAILED) return false;
+        if (e->state == MQTT_OUT_SENT) {
+            if ((now - e->sent_at) > pdMS_TO_TICKS(APP_MQTT_ACK_TIMEOUT_MS)) return false;
+            continue;
+        }
+        if (e->state != MQTT_OUT_QUEUED) continue;
+
+        // estado antes do publish: com QoS 0 o callback pode vir antes do retorno
+        e->state   = MQTT_OUT_SENT;
+        e->sent_at = now;
+
+        err_t r = publish_telemetry(m, &e->frame, mqtt_out_cb, e);
+        if (r == ERR_MEM) {
+            // ring de saída/requisições do lwIP cheios: o próximo PUBACK acorda a task
+            e->state = MQTT_OUT_QUEUED;
+            break;
+        }
+        if (r != ERR_OK) {
+            e->state = MQTT_OUT_QUEUED;
+            LOG_W("MQTT: publish seq=%lu err=%d", (unsigned long)e->frame.seq, (int)r);
+            return false;
+        }
+
+        if (e->sends < UINT8_MAX) e->sends++;
+        if (e->sends > 1u) o->resent++;
     }
-    if (payload_out && payload_sz) {
-        snprintf(payload_out, payload_sz, "%s", m->cmd_buf);
+    return true;
+}
+
+void mqtt_app_drop(mqtt_app_t *m)
+{
+    if (m->client) {
+        cyw43_arch_lwip_begin();
+        mqtt_disconnect(m->client);
+        cyw43_arch_lwip_end();
     }
 
-    m->cmd_ready = false;
-    return true;
+    m->connected      = false;
+    m->connecting     = false;
+    m->need_subscribe = false;
+}
+
+bool mqtt_app_take_cmd(mqtt_app_t *m, matrix_cmd_t *out)
+{
+    matrix_cmd_t tmp;
+    return cmd_ring_pop(&m->cmd_ring, out ? out : &tmp);
 }
-        
\ No newline at end of file
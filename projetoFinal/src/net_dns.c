@@ -1,8 +1,10 @@
 #include "net_dns.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "pico/cyw43_arch.h"
+#include "pico/platform.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -10,60 +12,242 @@
 #include "lwip/dns.h"
 #include "lwip/err.h"
 
+#include "app_config.h"
+
 #ifndef LWIP_DNS
 #error "lwipopts.h nao esta sendo usado (LWIP_DNS indefinido)."
 #endif
 #if LWIP_DNS != 1
 #error "LWIP_DNS precisa ser 1."
 #endif
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES <= NET_DNS_NOTIFY_INDEX
+#error "configTASK_NOTIFICATION_ARRAY_ENTRIES precisa cobrir NET_DNS_NOTIFY_INDEX."
+#endif
+
+/**
+ * @brief Entrada do cache; também é o contexto da consulta em andamento.
+ *
+ * Acessada pelas tasks (entre cyw43_arch_lwip_begin/end) e pelo callback do lwIP
+ * (contexto do lwIP), então o lock do lwIP serializa tudo.
+ */
+typedef struct {
+    char       host[APP_DNS_HOST_MAX];
+    ip_addr_t  ip;
+    TickType_t resolved_at;
+    TickType_t failed_at;
+    TickType_t used_at;        // LRU
+    bool       valid;          // ip utilizável (válido ou vencido)
+    bool       expired;        // net_dns_expire(): vencido antes do TTL
+    bool       failed;         // última consulta falhou (cache negativo)
+    bool       pending;        // consulta no lwIP; arg do callback = esta entrada
+    TaskHandle_t waiters[APP_DNS_WAITERS];
+} dns_entry_t;
+
+static dns_entry_t g_cache[APP_DNS_CACHE_LEN];
+
+static TickType_t dns_now(void)
+{
+    return __get_current_exception() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+}
 
-// Estado de resolução (callbacks do lwIP não podem usar FreeRTOS diretamente)
-static volatile bool g_dns_done = false;
-static volatile err_t g_dns_err = ERR_VAL;
-static ip_addr_t g_dns_ip;
+/**
+ * @brief Acorda as tasks que esperavam por esta entrada.
+ *
+ * Com pico_cyw43_arch_lwip_threadsafe_background o callback roda em IRQ; em
+ * contexto de task (resposta síncrona) usa a API normal.
+ */
+static void dns_wake(dns_entry_t *e)
+{
+    BaseType_t hpw = pdFALSE;
+    bool isr = __get_current_exception() != 0;
+
+    for (uint32_t i = 0; i < APP_DNS_WAITERS; i++) {
+        TaskHandle_t t = e->waiters[i];
+        if (!t) continue;
+        e->waiters[i] = NULL;
+        if (isr) vTaskNotifyGiveIndexedFromISR(t, NET_DNS_NOTIFY_INDEX, &hpw);
+        else     xTaskNotifyGiveIndexed(t, NET_DNS_NOTIFY_INDEX);
+    }
+    if (isr) portYIELD_FROM_ISR(hpw);
+}
+
+static void dns_store(dns_entry_t *e, const ip_addr_t *ip)
+{
+    e->ip = *ip;
+    e->resolved_at = dns_now();
+    e->valid = true;
+    e->expired = false;
+    e->failed = false;
+}
 
 /**
  * @brief Callback do lwIP chamado quando DNS completa.
  */
 static void dns_found_cb(const char *name, const ip_addr_t *ipaddr, void *arg)
 {
-    (void)name; (void)arg;
+    (void)name;
+    dns_entry_t *e = (dns_entry_t*)arg;
 
+    e->pending = false;
     if (ipaddr) {
-        g_dns_ip  = *ipaddr;
-        g_dns_err = ERR_OK;
+        dns_store(e, ipaddr);
     } else {
-        g_dns_err = ERR_VAL;
+        // falha: o endereço antigo (se houver) continua sendo servido
+        e->failed = true;
+        e->failed_at = dns_now();
     }
-    g_dns_done = true;
+    dns_wake(e);
 }
 
-bool net_dns_resolve_host_to_ip(const char *host, ip_addr_t *out, uint32_t timeout_ms)
+// ---- as funções abaixo exigem o lock do lwIP ----
+
+static dns_entry_t *dns_find(const char *host)
 {
-    g_dns_done = false;
-    g_dns_err  = ERR_INPROGRESS;
+    for (uint32_t i = 0; i < APP_DNS_CACHE_LEN; i++) {
+        if (g_cache[i].host[0] && strcmp(g_cache[i].host, host) == 0) return &g_cache[i];
+    }
+    return NULL;
+}
 
-    cyw43_arch_lwip_begin();
-    err_t e = dns_gethostbyname(host, &g_dns_ip, dns_found_cb, NULL);
-    cyw43_arch_lwip_end();
+/**
+ * @brief Entrada nova para o host: livre ou a menos usada sem consulta pendente.
+ */
+static dns_entry_t *dns_alloc(const char *host)
+{
+    if (strlen(host) >= APP_DNS_HOST_MAX) return NULL;
 
-    if (e == ERR_OK) { // cache
-        *out = g_dns_ip;
-        return true;
+    dns_entry_t *victim = NULL;
+    for (uint32_t i = 0; i < APP_DNS_CACHE_LEN; i++) {
+        dns_entry_t *e = &g_cache[i];
+        if (!e->host[0]) { victim = e; break; }
+        if (e->pending) continue;
+        if (!victim || (TickType_t)(e->used_at - victim->used_at) > (TickType_t)(portMAX_DELAY / 2u)) {
+            victim = e;   // used_at mais antigo (comparação com wrap)
+        }
     }
-    if (e != ERR_INPROGRESS) {
-        return false;
+    if (!victim) return NULL;
+
+    memset(victim, 0, sizeof(*victim));
+    snprintf(victim->host, sizeof(victim->host), "%s", host);
+    return victim;
+}
+
+static void dns_add_waiter(dns_entry_t *e, TaskHandle_t t)
+{
+    for (uint32_t i = 0; i < APP_DNS_WAITERS; i++) {
+        if (e->waiters[i] == t) return;
+    }
+    for (uint32_t i = 0; i < APP_DNS_WAITERS; i++) {
+        if (!e->waiters[i]) { e->waiters[i] = t; return; }
     }
+    // sem vaga: a task não é notificada, mas volta a consultar no timeout
+}
 
-    TickType_t t0 = xTaskGetTickCount();
-    while (!g_dns_done) {
-        if ((xTaskGetTickCount() - t0) > pdMS_TO_TICKS(timeout_ms)) return false;
-        vTaskDelay(pdMS_TO_TICKS(10));
+static void dns_remove_waiter(dns_entry_t *e, TaskHandle_t t)
+{
+    for (uint32_t i = 0; i < APP_DNS_WAITERS; i++) {
+        if (e->waiters[i] == t) e->waiters[i] = NULL;
     }
+}
 
-    if (g_dns_err == ERR_OK) {
-        *out = g_dns_ip;
-        return true;
+/**
+ * @brief Dispara a consulta no lwIP (se ainda não houver uma).
+ */
+static void dns_start(dns_entry_t *e)
+{
+    if (e->pending) return;
+
+    ip_addr_t ip;
+    err_t err = dns_gethostbyname(e->host, &ip, dns_found_cb, e);
+    if (err == ERR_OK) {
+        dns_store(e, &ip);           // cache interno do lwIP (ainda dentro do TTL real)
+    } else if (err == ERR_INPROGRESS) {
+        e->pending = true;
+    } else {
+        e->failed = true;
+        e->failed_at = dns_now();
+    }
+}
+
+static net_dns_result_t dns_lookup_locked(const char *host, ip_addr_t *out)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    dns_entry_t *e = dns_find(host);
+    if (!e) e = dns_alloc(host);
+    if (!e) return NET_DNS_FAIL;
+    e->used_at = now;
+
+    if (e->valid) {
+        TickType_t age = now - e->resolved_at;
+        if (!e->expired && age < pdMS_TO_TICKS(APP_DNS_TTL_MS)) {
+            *out = e->ip;
+            return NET_DNS_HIT;
+        }
+        if (age < pdMS_TO_TICKS(APP_DNS_STALE_MAX_MS)) {
+            // serve o antigo já; a resposta nova substitui quando chegar
+            *out = e->ip;
+            if (!e->failed || (now - e->failed_at) >= pdMS_TO_TICKS(APP_DNS_NEG_TTL_MS)) dns_start(e);
+            return NET_DNS_STALE;
+        }
+        e->valid = false;            // velho demais para servir
+    }
+
+    if (!e->pending) {
+        if (e->failed && (now - e->failed_at) < pdMS_TO_TICKS(APP_DNS_NEG_TTL_MS)) return NET_DNS_FAIL;
+        dns_start(e);
+        if (e->valid) {
+            *out = e->ip;
+            return NET_DNS_HIT;
+        }
+        if (!e->pending) return NET_DNS_FAIL;
     }
+
+    dns_add_waiter(e, xTaskGetCurrentTaskHandle());
+    return NET_DNS_PENDING;
+}
+
+// ---- API ----
+
+net_dns_result_t net_dns_lookup(const char *host, ip_addr_t *out)
+{
+    cyw43_arch_lwip_begin();
+    net_dns_result_t r = dns_lookup_locked(host, out);
+    cyw43_arch_lwip_end();
+    return r;
+}
+
+void net_dns_expire(const char *host)
+{
+    cyw43_arch_lwip_begin();
+    dns_entry_t *e = dns_find(host);
+    if (e) e->expired = true;
+    cyw43_arch_lwip_end();
+}
+
+bool net_dns_resolve_host_to_ip(const char *host, ip_addr_t *out, uint32_t timeout_ms)
+{
+    const TickType_t t0 = xTaskGetTickCount();
+    const TickType_t limit = pdMS_TO_TICKS(timeout_ms);
+
+    for (;;) {
+        net_dns_result_t r = net_dns_lookup(host, out);
+        if (r == NET_DNS_HIT || r == NET_DNS_STALE) return true;
+        if (r == NET_DNS_FAIL) return false;
+
+        TickType_t waited = xTaskGetTickCount() - t0;
+        if (waited >= limit) break;
+
+        // acorda no fim da consulta; índice próprio, não consome os avisos do índice 0
+        ulTaskNotifyTakeIndexed(NET_DNS_NOTIFY_INDEX, pdTRUE, limit - waited);
+    }
+
+    // timeout: a consulta segue em segundo plano e alimenta o cache
+    cyw43_arch_lwip_begin();
+    dns_entry_t *e = dns_find(host);
+    if (e) dns_remove_waiter(e, xTaskGetCurrentTaskHandle());
+    cyw43_arch_lwip_end();
+    // descarta um aviso que chegou entre o timeout e a remoção (não antecipa a próxima espera)
+    (void)ulTaskNotifyTakeIndexed(NET_DNS_NOTIFY_INDEX, pdTRUE, 0);
     return false;
 }
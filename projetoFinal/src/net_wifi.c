@@ -1,36 +1,274 @@
 #include "net_wifi.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
+#include "pico/platform.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "lwip/dhcp.h"
+#include "lwip/dns.h"
+#include "lwip/netif.h"
 
 #include "app_config.h"
+#include "app_log.h"
+#include "net_wifi_store.h"
+
+#ifndef CYW43_IOCTL_GET_CHANNEL
+#define CYW43_IOCTL_GET_CHANNEL (0x3a)
+#endif
+
+static volatile net_wifi_state_t g_state = NET_WIFI_INIT;
+static net_wifi_event_fn g_event_fn;
+static void *g_event_arg;
+static TaskHandle_t g_task;
+static net_wifi_stats_t g_stats;
+
+// tentativa atual
+static bool g_fast;              // caminho rápido (BSSID/canal guardados)
+static bool g_skip_fast;         // rápido falhou: próxima tentativa com varredura
+static bool g_addr_set;          // endereço fixo já aplicado nesta associação
+static net_wifi_store_t g_rec;   // registro da flash (válido se g_have_rec)
+static bool g_have_rec;
+
+void net_wifi_set_event_callback(net_wifi_event_fn fn, void *arg)
+{
+    g_event_fn  = fn;
+    g_event_arg = arg;
+}
+
+net_wifi_state_t net_wifi_state(void)
+{
+    return g_state;
+}
+
+void net_wifi_get_stats(net_wifi_stats_t *out)
+{
+    *out = g_stats;
+}
+
+static void wifi_event(net_wifi_event_t ev)
+{
+    if (g_event_fn) g_event_fn(ev, g_event_arg);
+}
 
 /**
- * @brief Inicializa e conecta ao Wi-Fi usando SSID/SENHA de app_config.h.
+ * @brief Status da netif (contexto do lwIP, IRQ): acorda a task do link na hora.
+ *
+ * A task também confere o link a cada APP_WIFI_POLL_MS; o aviso só encurta a espera.
  */
-bool net_wifi_init_and_connect(void)
+static void wifi_netif_status_cb(struct netif *netif)
+{
+    (void)netif;
+    if (!g_task) return;
+
+    if (__get_current_exception()) {
+        BaseType_t hpw = pdFALSE;
+        vTaskNotifyGiveFromISR(g_task, &hpw);
+        portYIELD_FROM_ISR(hpw);
+    } else {
+        xTaskNotifyGive(g_task);
+    }
+}
+
+/**
+ * @brief Inicia o cyw43 e o lwIP (uma vez).
+ */
+static bool wifi_init(void)
 {
     if (cyw43_arch_init()) {
-        printf("Wi-Fi init failed\n");
+        LOG_E("Wi-Fi: cyw43 init failed");
         return false;
     }
-
     cyw43_arch_enable_sta_mode();
 
-    printf("Connecting to Wi-Fi...\n");
-    if (cyw43_arch_wifi_connect_timeout_ms(
-            APP_WIFI_SSID,
-            APP_WIFI_PASSWORD,
-            CYW43_AUTH_WPA2_AES_PSK,
-            30000)) {
-        printf("failed to connect.\n");
-        return false;
+    cyw43_arch_lwip_begin();
+    netif_set_status_callback(&cyw43_state.netif[CYW43_ITF_STA], wifi_netif_status_cb);
+    cyw43_arch_lwip_end();
+    return true;
+}
+
+static bool wifi_join_start(void)
+{
+    int e;
+    g_addr_set = false;
+    g_fast = APP_WIFI_FAST_JOIN && g_have_rec && !g_skip_fast;
+
+    if (g_fast) {
+        // sem varredura: vai direto ao AP e canal da última associação
+        LOG_I("Wi-Fi: fast rejoin %s (ch %u)...", APP_WIFI_SSID, (unsigned)g_rec.channel);
+        e = cyw43_wifi_join(&cyw43_state, strlen(APP_WIFI_SSID), (const uint8_t*)APP_WIFI_SSID,
+                            strlen(APP_WIFI_PASSWORD), (const uint8_t*)APP_WIFI_PASSWORD,
+                            CYW43_AUTH_WPA2_AES_PSK, g_rec.bssid,
+                            g_rec.channel ? g_rec.channel : CYW43_CHANNEL_NONE);
+    } else {
+        LOG_I("Wi-Fi: connecting to %s...", APP_WIFI_SSID);
+        e = cyw43_arch_wifi_connect_async(APP_WIFI_SSID, APP_WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
     }
+    if (e) LOG_W("Wi-Fi: join err=%d", e);
+    return e == 0;
+}
 
-    printf("Connected.\n");
-    uint8_t *ip_address = (uint8_t*)&(cyw43_state.netif[0].ip_addr.addr);
-    printf("IP address %d.%d.%d.%d\n", ip_address[0], ip_address[1], ip_address[2], ip_address[3]);
+/**
+ * @brief Endereço sem DHCP: configuração fixa ou último lease (quando habilitado).
+ * @return true se há endereço fixo para aplicar em out_*.
+ */
+static bool wifi_fixed_addr(ip4_addr_t *ip, ip4_addr_t *mask, ip4_addr_t *gw, ip4_addr_t *dns)
+{
+#if APP_WIFI_STATIC_IP
+    return ip4addr_aton(APP_WIFI_IP, ip) && ip4addr_aton(APP_WIFI_NETMASK, mask) &&
+           ip4addr_aton(APP_WIFI_GATEWAY, gw) && ip4addr_aton(APP_WIFI_DNS, dns);
+#elif APP_WIFI_PIN_LEASE
+    if (!g_have_rec || !g_rec.has_lease) return false;
+    ip4_addr_set_u32(ip, g_rec.ip);
+    ip4_addr_set_u32(mask, g_rec.mask);
+    ip4_addr_set_u32(gw, g_rec.gw);
+    ip4_addr_set_u32(dns, g_rec.dns);
     return true;
+#else
+    (void)ip; (void)mask; (void)gw; (void)dns;
+    return false;
+#endif
+}
+
+/**
+ * @brief Associado e sem IP: troca o DHCP (iniciado pelo cyw43) pelo endereço fixo.
+ */
+static void wifi_apply_fixed_addr(void)
+{
+    ip4_addr_t ip, mask, gw, dns;
+    g_addr_set = true;
+    if (!wifi_fixed_addr(&ip, &mask, &gw, &dns)) return;
+
+    struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+    cyw43_arch_lwip_begin();
+    dhcp_stop(n);
+    netif_set_addr(n, &ip, &mask, &gw);
+    dns_setserver(0, &dns);
+    cyw43_arch_lwip_end();
+    LOG_I("Wi-Fi: fixed IP %s (no DHCP)", ip4addr_ntoa(&ip));
+}
+
+/**
+ * @brief Guarda BSSID, canal e endereço da associação atual (só grava se mudou).
+ */
+static void wifi_store_update(void)
+{
+    net_wifi_store_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.ssid_hash = net_wifi_store_hash(APP_WIFI_SSID);
+
+    if (cyw43_wifi_get_bssid(&cyw43_state, rec.bssid) != 0) return;
+
+    uint32_t ch[3] = {0};   // channel_info_t: hw, target, scan
+    if (cyw43_ioctl(&cyw43_state, CYW43_IOCTL_GET_CHANNEL, sizeof(ch), (uint8_t*)ch, CYW43_ITF_STA) == 0 &&
+        ch[0] > 0 && ch[0] < 256) {
+        rec.channel = (uint8_t)ch[0];
+    }
+
+    struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+    cyw43_arch_lwip_begin();
+    rec.ip   = ip4_addr_get_u32(netif_ip4_addr(n));
+    rec.mask = ip4_addr_get_u32(netif_ip4_netmask(n));
+    rec.gw   = ip4_addr_get_u32(netif_ip4_gw(n));
+    rec.dns  = ip4_addr_get_u32(ip_2_ip4(dns_getserver(0)));
+    cyw43_arch_lwip_end();
+    rec.has_lease = (rec.ip != 0);
+
+    if (g_have_rec && memcmp(&rec, &g_rec, sizeof(rec)) == 0) return;
+    if (net_wifi_store_save(&rec)) {
+        g_rec = rec;
+        g_have_rec = true;
+    }
+}
+
+void vTaskWifi(void *pvParameters)
+{
+    (void)pvParameters;
+    g_task = xTaskGetCurrentTaskHandle();
+    g_have_rec = net_wifi_store_load(APP_WIFI_SSID, &g_rec);
+
+    TickType_t t_state = xTaskGetTickCount();   // entrada no estado atual
+
+    for (;;)
+    {
+        TickType_t wait = pdMS_TO_TICKS(APP_WIFI_POLL_MS);
+        TickType_t now = xTaskGetTickCount();
+
+        switch (g_state) {
+        case NET_WIFI_INIT:
+            if (!wifi_init()) {
+                wait = pdMS_TO_TICKS(APP_WIFI_RETRY_MS);
+                break;
+            }
+            g_state = wifi_join_start() ? NET_WIFI_JOINING : NET_WIFI_BACKOFF;
+            t_state = now;
+            break;
+
+        case NET_WIFI_JOINING: {
+            int st = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+            if (st == CYW43_LINK_NOIP && !g_addr_set) {
+                wifi_apply_fixed_addr();
+                st = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+            }
+
+            const TickType_t limit = pdMS_TO_TICKS(g_fast ? APP_WIFI_FAST_TIMEOUT_MS : APP_WIFI_JOIN_TIMEOUT_MS);
+            if (st == CYW43_LINK_UP) {
+                uint32_t dt_ms = pdTICKS_TO_MS(now - t_state);
+                g_stats.joins++;
+                g_stats.last_join_ms = dt_ms;
+                if (g_fast) { g_stats.fast_joins++; g_stats.fast_ip_ms = dt_ms; }
+                else        { g_stats.full_ip_ms = dt_ms; }
+                if (!g_stats.boot_up_ms) g_stats.boot_up_ms = to_ms_since_boot(get_absolute_time());
+
+                LOG_I("Wi-Fi: up (%s), IP %s (%lu ms; boot->IP %lu ms)", g_fast ? "fast" : "scan",
+                      ipaddr_ntoa(&cyw43_state.netif[CYW43_ITF_STA].ip_addr),
+                      (unsigned long)dt_ms, (unsigned long)g_stats.boot_up_ms);
+                g_skip_fast = false;
+                wifi_store_update();
+                g_state = NET_WIFI_UP;
+                t_state = now;
+                wifi_event(NET_WIFI_EV_UP);
+            } else if (g_fast && (st == CYW43_LINK_FAIL || st == CYW43_LINK_NONET || (now - t_state) > limit)) {
+                // AP mudou de canal/BSSID (ou sumiu): varredura completa já, sem esperar o backoff
+                LOG_W("Wi-Fi: fast rejoin failed (status=%d), full scan", st);
+                g_stats.fast_fails++;
+                g_skip_fast = true;
+                cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+                g_state = wifi_join_start() ? NET_WIFI_JOINING : NET_WIFI_BACKOFF;
+                t_state = now;
+            } else if (st == CYW43_LINK_FAIL || st == CYW43_LINK_NONET || st == CYW43_LINK_BADAUTH ||
+                       (now - t_state) > limit) {
+                LOG_W("Wi-Fi: join failed (status=%d), retry in %u ms", st, (unsigned)APP_WIFI_RETRY_MS);
+                g_stats.fails++;
+                g_state = NET_WIFI_BACKOFF;
+                t_state = now;
+            }
+            break;
+        }
+
+        case NET_WIFI_UP:
+            if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP) {
+                LOG_W("Wi-Fi: link down");
+                g_stats.drops++;
+                g_state = wifi_join_start() ? NET_WIFI_JOINING : NET_WIFI_BACKOFF;
+                t_state = now;
+                wifi_event(NET_WIFI_EV_DOWN);
+            }
+            break;
+
+        case NET_WIFI_BACKOFF:
+            if ((now - t_state) >= pdMS_TO_TICKS(APP_WIFI_RETRY_MS)) {
+                g_state = wifi_join_start() ? NET_WIFI_JOINING : NET_WIFI_BACKOFF;
+                t_state = now;
+            }
+            break;
+        }
+
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
 }
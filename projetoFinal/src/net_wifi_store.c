@@ -0,0 +1,99 @@
+#include "net_wifi_store.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+#include "app_config.h"
+#include "app_log.h"
+
+#define STORE_MAGIC    0x57464931u   // "WFI1"
+#define STORE_OFFSET   (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
+/**
+ * @brief Imagem na flash: cabeçalho + registro + verificação (uma página).
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t len;
+    net_wifi_store_t rec;
+    uint32_t check;          // FNV-1a de magic..rec
+} store_image_t;
+
+_Static_assert(sizeof(store_image_t) <= FLASH_PAGE_SIZE, "store_image_t cabe em uma página");
+
+static uint32_t fnv1a(const void *data, size_t len, uint32_t h)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint32_t net_wifi_store_hash(const char *s)
+{
+    return fnv1a(s, strlen(s), 2166136261u);
+}
+
+static uint32_t image_check(const store_image_t *img)
+{
+    return fnv1a(img, offsetof(store_image_t, check), 2166136261u);
+}
+
+static const store_image_t *store_flash(void)
+{
+    return (const store_image_t*)(XIP_BASE + STORE_OFFSET);
+}
+
+bool net_wifi_store_load(const char *ssid, net_wifi_store_t *out)
+{
+    store_image_t img;
+    memcpy(&img, store_flash(), sizeof(img));
+
+    if (img.magic != STORE_MAGIC || img.len != sizeof(img.rec) || img.check != image_check(&img)) {
+        return false;
+    }
+    if (img.rec.ssid_hash != net_wifi_store_hash(ssid)) return false;
+
+    *out = img.rec;
+    return true;
+}
+
+/**
+ * @brief Executada por flash_safe_execute (IRQs desligadas, outro core parado).
+ */
+static void store_write(void *param)
+{
+    const uint8_t *page = (const uint8_t*)param;
+
+    flash_range_erase(STORE_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(STORE_OFFSET, page, FLASH_PAGE_SIZE);
+}
+
+bool net_wifi_store_save(const net_wifi_store_t *rec)
+{
+    static uint8_t page[FLASH_PAGE_SIZE];
+
+    store_image_t img;
+    memset(&img, 0, sizeof(img));
+    img.magic = STORE_MAGIC;
+    img.len   = sizeof(img.rec);
+    img.rec   = *rec;
+    img.check = image_check(&img);
+
+    if (memcmp(store_flash(), &img, sizeof(img)) == 0) return true;   // sem desgaste à toa
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &img, sizeof(img));
+
+    int r = flash_safe_execute(store_write, page, APP_WIFI_STORE_TIMEOUT_MS);
+    if (r != PICO_OK) {
+        LOG_W("Wi-Fi store: write failed (%d)", r);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+#include "oled_trend.h"
+
+#include <stdio.h>
+
+#include "ssd1306.h"
+
+// Área do gráfico: páginas 2..7 (y 16..63)
+#define PLOT_PAGE0  2u
+#define PLOT_PAGE1  7u
+#define PLOT_Y0     (PLOT_PAGE0 * 8u)
+#define PLOT_H      ((PLOT_PAGE1 - PLOT_PAGE0 + 1u) * 8u)
+
+static const char *const k_names[HIST_FIELDS] = { "Lux", "Temp", "Umid", "Perc" };
+
+static hist_field_t g_field = HIST_LUX;
+static int32_t g_lo = 0, g_hi = 0;   // escala do gráfico desenhado
+static uint8_t g_prev_y = 0;
+
+static ssd1306_field_t g_f_now, g_f_range;
+
+// buffer de redesenho: largura da tela, não do histórico
+static int32_t g_samples[SSD1306_WIDTH];
+
+static uint8_t value_to_y(int32_t v)
+{
+    if (g_hi <= g_lo) return (uint8_t)(PLOT_Y0 + PLOT_H / 2u);
+    int32_t span = g_hi - g_lo;
+    int32_t off = ((v - g_lo) * (int32_t)(PLOT_H - 1u) + span / 2) / span;
+    if (off < 0) off = 0;
+    if (off > (int32_t)(PLOT_H - 1u)) off = (int32_t)(PLOT_H - 1u);
+    return (uint8_t)(PLOT_Y0 + (PLOT_H - 1u) - (uint32_t)off);
+}
+
+static void draw_text(void)
+{
+    char line[SSD1306_FIELD_MAX_CHARS + 1];
+    double sc = (double)history_scale(g_field);
+
+    snprintf(line, sizeof(line), "%s: %.1f", k_names[g_field], (double)history_latest(g_field) / sc);
+    ssd1306_field_set(&g_f_now, line);
+
+    snprintf(line, sizeof(line), "min %.1f max %.1f", (double)g_lo / sc, (double)g_hi / sc);
+    ssd1306_field_set(&g_f_range, line);
+}
+
+static void redraw_plot(void)
+{
+    if (!history_minmax(g_field, &g_lo, &g_hi)) {
+        g_lo = g_hi = 0;
+    }
+    ssd1306_clear_pages(PLOT_PAGE0, PLOT_PAGE1);
+
+    uint16_t n = history_read_recent(g_field, g_samples, SSD1306_WIDTH);
+    uint8_t x = (uint8_t)(SSD1306_WIDTH - n);
+    for (uint16_t i = 0; i < n; i++, x++) {
+        uint8_t y = value_to_y(g_samples[i]);
+        ssd1306_draw_vline(x, (i == 0) ? y : g_prev_y, y);
+        g_prev_y = y;
+    }
+}
+
+void oled_trend_enter(hist_field_t f)
+{
+    g_field = (f < HIST_FIELDS) ? f : HIST_LUX;
+
+    ssd1306_clear();
+    ssd1306_field_init(&g_f_now,   0, 0, SSD1306_FIELD_MAX_CHARS);
+    ssd1306_field_init(&g_f_range, 0, 8, SSD1306_FIELD_MAX_CHARS);
+
+    redraw_plot();
+    draw_text();
+}
+
+void oled_trend_update(void)
+{
+    if (history_count() == 0) return;
+
+    int32_t lo, hi;
+    history_minmax(g_field, &lo, &hi);
+
+    if (lo != g_lo || hi != g_hi) {
+        // escala mudou: redesenho completo (custo limitado à largura da tela)
+        redraw_plot();
+    } else {
+        ssd1306_scroll_left(PLOT_PAGE0, PLOT_PAGE1);
+        uint8_t y = value_to_y(history_latest(g_field));
+        ssd1306_draw_vline(SSD1306_WIDTH - 1u, g_prev_y, y);
+        g_prev_y = y;
+    }
+    draw_text();
+}
@@ -11,11 +11,15 @@
 
 #include "app_config.h"
 #include "app_ctx.h"
-#include "net_wifi.h"
+#include "app_log.h"
+#include "app_trace.h"
 #include "mqtt_app.h"
 #include "matrix_control.h"
 #include "app_tasks.h"
+#include "history.h"
+#include "net_wifi.h"
 #include "serial_rpc.h"
+#include "usb_cdc.h"
 
 /**
  * @brief Inicializa I2C0 (sensores BH1750 e AHT10).
@@ -40,21 +44,34 @@ static void app_queues_init(app_ctx_t *ctx)
     ctx->q_hum   = xQueueCreate(1, sizeof(float));
     ctx->q_frame = xQueueCreate(1, sizeof(sensor_frame_t));
 
+    // exceção: FIFO de amostras (não overwrite), consumida pelo SerialRPC
+    ctx->q_lux_samples = xQueueCreate(APP_LUX_SAMPLES_LEN, sizeof(lux_sample_t));
+    ctx->q_tele        = xQueueCreate(APP_MQTT_FRAME_QUEUE_LEN, sizeof(sensor_frame_t));
+
     configASSERT(ctx->q_lux && ctx->q_perc && ctx->q_temp && ctx->q_hum && ctx->q_frame);
+    configASSERT(ctx->q_lux_samples && ctx->q_tele);
+}
+
+/**
+ * @brief Eventos do link (task do Wi-Fi): link no ar acorda o MQTT para agendar a conexão.
+ */
+static void app_on_link(net_wifi_event_t ev, void *arg)
+{
+    app_ctx_t *ctx = (app_ctx_t*)arg;
+    if (ev == NET_WIFI_EV_UP && ctx->task_mqtt) xTaskNotifyGive(ctx->task_mqtt);
 }
 
 /**
  * @brief main - ponto de entrada.
+ *
+ * Nada aqui espera pela rede: o Wi-Fi sobe depois, na vTaskWifi.
  */
 int main(void)
 {
     stdio_init_all();
-    sleep_ms(1500);
-
-    // Wi-Fi
-    if (!net_wifi_init_and_connect()) {
-        return -1;
-    }
+    usb_cdc_init();     // CDC 0 = SerialRPC, CDC 1 = log (stdio)
+    app_log_init();
+    app_trace_init();
 
     // contexto
     static app_ctx_t ctx;
@@ -73,20 +90,31 @@ int main(void)
     // controle de brilho / comandos
     matrix_control_init();
 
-    // MQTT init (gera device_id e tópicos)
+    // histórico (display grava, SerialRPC lê no dump)
+    history_init();
+
+    // MQTT init (gera device_id e tópicos; o cliente lwIP é criado ao conectar)
     mqtt_app_init(&ctx.mqtt, NULL);
     snprintf(ctx.device_id, sizeof(ctx.device_id), "%s", ctx.mqtt.device_id);
 
+    net_wifi_set_event_callback(app_on_link, &ctx);
+
     // tasks
+    xTaskCreate(vTaskUsb,          "Usb",         1024, NULL, 3, NULL);
+    xTaskCreate(vTaskLogDrain,     "LogDrain",    1024, NULL, 1, NULL);
     xTaskCreate(vTaskLuminos,      "Luminos",     4096, &ctx, 1, NULL);
     xTaskCreate(vTaskTempUmidade,  "TempUmidade", 4096, &ctx, 1, NULL);
     xTaskCreate(vTaskDisplay,      "Display",     4096, &ctx, 2, NULL);
 
+    // cyw43/lwIP iniciados nesta task: fica no core 0, onde as IRQs do cyw43 são registradas
+    BaseType_t okw = xTaskCreateAffinitySet(vTaskWifi, "Wifi", 2048, NULL, 2, (1u << 0), NULL);
+    configASSERT(okw == pdPASS);
+
     BaseType_t ok = xTaskCreate(vTaskMqtt, "Mqtt", 8192, &ctx, 2, &ctx.task_mqtt);
     configASSERT(ok == pdPASS);
     configASSERT(ctx.task_mqtt != NULL);
 
-    BaseType_t ok2 = xTaskCreate(vTaskSerialRpc, "SerialRPC", 4096, &ctx, 2, NULL);
+    BaseType_t ok2 = xTaskCreate(vTaskSerialRpc, "SerialRPC", 4096, &ctx, 2, &ctx.task_serial);
     configASSERT(ok2 == pdPASS);
 
     vTaskStartScheduler();
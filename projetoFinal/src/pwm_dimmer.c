@@ -0,0 +1,136 @@
+#include "pwm_dimmer.h"
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+
+#include "app_config.h"
+#include "app_log.h"
+
+/**
+ * @brief Estado de um canal PWM.
+ */
+typedef struct {
+    uint slice;
+    uint chan;
+} pwm_dimmer_ch_t;
+
+static pwm_dimmer_ch_t g_ch[APP_PWM_CHANNEL_COUNT];
+static uint8_t g_ch_count = 0;
+static uint    g_irq_slice = 0;
+
+// Tabela percent -> nível (calculada uma vez, fora da IRQ)
+static uint16_t g_lut[101];
+
+// Buffer duplo: a task grava em g_buf[g_front ^ 1] e publica o índice em g_publish;
+// a IRQ copia para os registradores e só então libera a publicação (-1).
+static uint16_t g_stage[APP_PWM_CHANNEL_COUNT];
+static uint16_t g_buf[2][APP_PWM_CHANNEL_COUNT];
+static volatile int8_t  g_publish = -1;
+static volatile uint8_t g_front = 0;
+
+#if APP_PWM_ENABLE
+/**
+ * @brief IRQ de wrap: aplica o buffer publicado (registrador CC é latched no próximo wrap).
+ */
+static void pwm_dimmer_wrap_isr(void)
+{
+    pwm_clear_irq(g_irq_slice);
+
+    int8_t idx = g_publish;
+    if (idx >= 0) {
+        const uint16_t *lv = g_buf[idx];
+        for (uint8_t i = 0; i < g_ch_count; i++) {
+            pwm_set_chan_level(g_ch[i].slice, g_ch[i].chan, lv[i]);
+        }
+        g_front = (uint8_t)idx;
+        __dmb();
+        g_publish = -1;
+    }
+
+    // nada pendente: não precisa acordar a cada período. Um commit do outro core entre a
+    // leitura acima e o desligamento já religou a IRQ; desliga e confere de novo para não
+    // deixar uma publicação parada com a IRQ desligada (o commit só religa depois de publicar)
+    pwm_set_irq_enabled(g_irq_slice, false);
+    __dmb();
+    if (g_publish >= 0) {
+        pwm_set_irq_enabled(g_irq_slice, true);
+    }
+}
+#endif
+
+uint8_t pwm_dimmer_init(void)
+{
+#if APP_PWM_ENABLE
+    static const uint8_t pins[] = APP_PWM_CHANNEL_PINS;
+    _Static_assert(sizeof(pins) / sizeof(pins[0]) == APP_PWM_CHANNEL_COUNT, "APP_PWM_CHANNEL_PINS");
+    _Static_assert(APP_PWM_CHANNEL_COUNT <= APP_LUM_CHANNEL_COUNT, "APP_PWM_CHANNEL_COUNT");
+
+    for (uint8_t p = 0; p <= 100; p++) {
+        g_lut[p] = pwm_dimmer_duty_from_percent(p);
+    }
+
+    float div = (float)clock_get_hz(clk_sys) / ((float)APP_PWM_FREQ_HZ * (float)(PWM_DIMMER_TOP + 1u));
+    if (div < 1.0f) div = 1.0f;
+    if (div > 255.9375f) div = 255.9375f;
+
+    uint32_t slice_mask = 0;
+    for (uint8_t i = 0; i < APP_PWM_CHANNEL_COUNT; i++) {
+        g_ch[i].slice = pwm_gpio_to_slice_num(pins[i]);
+        g_ch[i].chan  = pwm_gpio_to_channel(pins[i]);
+
+        if (!(slice_mask & (1u << g_ch[i].slice))) {
+            pwm_config c = pwm_get_default_config();
+            pwm_config_set_wrap(&c, PWM_DIMMER_TOP);
+            pwm_config_set_clkdiv(&c, div);
+            pwm_init(g_ch[i].slice, &c, false);
+            slice_mask |= 1u << g_ch[i].slice;
+        }
+        pwm_set_chan_level(g_ch[i].slice, g_ch[i].chan, 0);
+        gpio_set_function(pins[i], GPIO_FUNC_PWM);
+#if APP_PWM_INVERT
+        pwm_set_output_polarity(g_ch[i].slice, g_ch[i].chan == PWM_CHAN_A, g_ch[i].chan == PWM_CHAN_B);
+#endif
+    }
+    g_ch_count = APP_PWM_CHANNEL_COUNT;
+    g_irq_slice = g_ch[0].slice;
+
+    pwm_clear_irq(g_irq_slice);
+    irq_set_exclusive_handler(PWM_IRQ_WRAP, pwm_dimmer_wrap_isr);
+    irq_set_enabled(PWM_IRQ_WRAP, true);
+
+    // inicia todos os slices em fase
+    pwm_set_mask_enabled(slice_mask);
+
+    LOG_I("PWM: %u canal(is), %.1f Hz, 16 bits", g_ch_count,
+           (double)((float)clock_get_hz(clk_sys) / (div * (float)(PWM_DIMMER_TOP + 1u))));
+#endif
+    return g_ch_count;
+}
+
+void pwm_dimmer_set_channel_percent(uint8_t ch, uint8_t percent_0_100)
+{
+    if (ch >= g_ch_count) return;
+    if (percent_0_100 > 100) percent_0_100 = 100;
+    g_stage[ch] = g_lut[percent_0_100];
+}
+
+bool pwm_dimmer_commit(void)
+{
+    if (g_ch_count == 0) return false;
+    if (g_publish >= 0) return false;
+
+    uint8_t back = (uint8_t)(g_front ^ 1u);
+    for (uint8_t i = 0; i < g_ch_count; i++) {
+        g_buf[back][i] = g_stage[i];
+    }
+    __dmb();
+    g_publish = (int8_t)back;
+
+    pwm_set_irq_enabled(g_irq_slice, true);
+    return true;
+}
@@ -0,0 +1,17 @@
+#include "pwm_dimmer.h"
+
+uint16_t pwm_dimmer_duty_from_percent(uint8_t percent_0_100)
+{
+    if (percent_0_100 >= 100) return (uint16_t)PWM_DIMMER_LEVEL_MAX;
+    if (percent_0_100 == 0) return 0;
+
+    // CIE 1931: L* (0..100) -> luminância relativa Y (0..1)
+    float L = (float)percent_0_100;
+    float Y = (L <= 8.0f) ? (L / 903.3f)
+                          : ((L + 16.0f) / 116.0f) * ((L + 16.0f) / 116.0f) * ((L + 16.0f) / 116.0f);
+
+    uint32_t lv = (uint32_t)(Y * (float)PWM_DIMMER_LEVEL_MAX + 0.5f);
+    if (lv < 1u) lv = 1u;   // nunca apaga um canal que deveria estar aceso
+    if (lv > PWM_DIMMER_TOP) lv = PWM_DIMMER_TOP;
+    return (uint16_t)lv;
+}
@@ -7,173 +7,1007 @@
 
 #include "app_config.h"
 #include "app_ctx.h"
+#include "app_log.h"
+#include "app_trace.h"
+#include "dispatch.h"
+#include "history.h"
 #include "json_simple.h"
+#include "json_writer.h"
 #include "matrix_control.h"
+#include "net_wifi.h"
+#include "serial_bin.h"
+#include "telemetry_json.h"
+#include "usb_cdc.h"
+
+/**
+ * @brief Assinatura de telemetria do modo JSON (op "subscribe").
+ */
+typedef struct {
+    bool     active;
+    uint16_t fields;     // TELE_F_*; 0 = sem frames (ex.: só amostras brutas)
+    uint32_t period_ms;  // frames: no máximo um por período, e só quando o seq muda
+    uint16_t decimate;   // envia 1 de cada N (frames e amostras, contados à parte)
+    bool     raw;        // cada leitura de lux do vTaskLuminos (q_lux_samples)
+    uint32_t frame_n;
+    uint32_t raw_n;
+} serial_sub_t;
+
+/** Sem "subscribe": todos os campos no período padrão (comportamento original). */
+static const serial_sub_t k_sub_default = {
+    .active = true, .fields = TELE_F_ALL, .period_ms = APP_SERIAL_TELE_PERIOD_MS, .decimate = 1
+};
+
+/**
+ * @brief Transferência do histórico em andamento (op "dump").
+ *
+ * Controle de fluxo por créditos: cada bloco enviado consome um; sem crédito a task
+ * para de enviar até "dump_credit". Assim o host nunca fica com mais que `credit`
+ * blocos pendentes e o timeout de escrita da CDC não descarta dados do dump.
+ */
+typedef struct {
+    bool     active;
+    char     id[24];     // "id" do pedido já em JSON (o pedido sai da fila antes do fim)
+    uint8_t  id_len;
+    uint32_t next;       // próximo índice absoluto (offset de retomada)
+    uint32_t end;        // índice final (exclusivo), fixado no início
+    uint32_t from_ms;
+    uint32_t to_ms;
+    uint32_t credit;
+    uint32_t sent;       // quadros enviados
+    uint32_t lost;       // quadros sobrescritos no anel antes de serem enviados
+} serial_dump_t;
+
+/**
+ * @brief Estado de uma sessão SerialRPC.
+ */
+typedef struct {
+    app_ctx_t *ctx;
+    bool authed;
+    bool binary;     // quadros COBS (serial_bin.h) em vez de linhas JSON
+    serial_sub_t sub;
+    serial_dump_t dump;
+
+    // "id" do pedido em tratamento, já em JSON (aponta para a linha; NULL = sem id)
+    const char *id;
+    size_t      id_len;
+} rpc_session_t;
+
+/**
+ * @brief Resposta JSON montada inteira antes de sair: uma escrita por linha.
+ *
+ * A CDC do RPC é exclusiva desta task (printf/log vão para a CDC de log); o buffer
+ * só agrupa os pedaços do escritor JSON em uma escrita. Se passar do buffer, o
+ * excedente sai em escritas seguintes.
+ */
+typedef struct {
+    char   buf[APP_SERIAL_TX_MAX];
+    size_t len;
+} serial_tx_t;
+
+static serial_tx_t g_tx;
+
+static void serial_tx_flush(void)
+{
+    if (g_tx.len) {
+        usb_rpc_write(g_tx.buf, g_tx.len);
+        g_tx.len = 0;
+    }
+    usb_rpc_flush();
+}
+
+static size_t serial_tx_sink(void *arg, const char *data, size_t len)
+{
+    (void)arg;
+    size_t done = 0;
+
+    while (done < len) {
+        if (g_tx.len == sizeof(g_tx.buf)) {
+            usb_rpc_write(g_tx.buf, g_tx.len);
+            g_tx.len = 0;
+        }
+        size_t n = sizeof(g_tx.buf) - g_tx.len;
+        if (n > len - done) n = len - done;
+        memcpy(g_tx.buf + g_tx.len, data + done, n);
+        g_tx.len += n;
+        done += n;
+    }
+    return len;
+}
+
+/**
+ * @brief Abre uma resposta: {"op":"<op>"[,"id":<id do pedido>]...
+ */
+static void serial_reply_begin(json_writer_t *w, const rpc_session_t *s, const char *op)
+{
+    json_w_init(w, serial_tx_sink, NULL);
+    json_w_begin(w);
+    json_w_str(w, "op", op);
+    if (s && s->id) json_w_member_raw(w, "id", s->id, s->id_len);
+}
+
+static void serial_reply_end(json_writer_t *w)
+{
+    json_w_end(w);
+    json_w_raw(w, "\n", 1);
+    serial_tx_flush();
+}
 
 /**
  * @brief Envia hello no protocolo SerialRPC.
  */
-static void serial_send_hello(const app_ctx_t *ctx, bool authed)
+static void serial_send_hello(const rpc_session_t *s)
 {
-    printf("{\"op\":\"hello\",\"device\":\"%s\",\"fw\":\"pico-serial-v1\",\"need_auth\":%s}\n",
-           ctx->device_id,
-           authed ? "false" : "true");
+    json_writer_t w;
+    serial_reply_begin(&w, s, "hello");
+    json_w_str(&w, "device", s->ctx->device_id);
+    json_w_str(&w, "fw", "pico-serial-v1");
+    json_w_bool(&w, "need_auth", !s->authed);
+    json_w_bool(&w, "bin", true);
+    json_w_uint(&w, "pipeline", APP_SERIAL_PIPELINE_DEPTH);
+    serial_reply_end(&w);
 }
 
 /**
  * @brief Envia resposta de autenticação.
  */
-static void serial_send_auth(bool ok)
+static void serial_send_auth(const rpc_session_t *s, bool ok)
 {
-    printf("{\"op\":\"auth\",\"ok\":%s}\n", ok ? "true" : "false");
+    json_writer_t w;
+    serial_reply_begin(&w, s, "auth");
+    json_w_bool(&w, "ok", ok);
+    serial_reply_end(&w);
 }
 
 /**
  * @brief Envia erro no protocolo SerialRPC.
  */
-static void serial_send_err(const char *msg)
+static void serial_send_err(const rpc_session_t *s, const char *msg)
 {
-    printf("{\"op\":\"err\",\"msg\":\"%s\"}\n", msg ? msg : "");
+    json_writer_t w;
+    serial_reply_begin(&w, s, "err");
+    json_w_str(&w, "msg", msg);
+    serial_reply_end(&w);
 }
 
 /**
  * @brief Envia ack no protocolo SerialRPC.
  */
-static void serial_send_ack(const char *msg)
+static void serial_send_ack(const rpc_session_t *s, const char *msg)
+{
+    json_writer_t w;
+    serial_reply_begin(&w, s, "ack");
+    json_w_bool(&w, "ok", true);
+    json_w_str(&w, "msg", msg);
+    serial_reply_end(&w);
+}
+
+/**
+ * @brief Recepção: fila limitada de pedidos (pipelining) + métricas de latência/acordadas.
+ *
+ * As unidades são montadas direto no slot da fila (sem cópia). Com a fila cheia a task
+ * para de ler: os bytes ficam no FIFO do USB e o próprio CDC segura o host, sem perda.
+ */
+typedef struct {
+    char     slot[APP_SERIAL_PIPELINE_DEPTH][APP_SERIAL_LINE_MAX];
+    uint16_t slot_len[APP_SERIAL_PIPELINE_DEPTH];  // 0 = linha longa demais (texto)
+    uint8_t  head;            // slot em montagem (head % N); contadores livres, N potência de 2
+    uint8_t  tail;            // próximo pedido a tratar
+    size_t   idx;
+    bool     overflow;        // unidade atual passou do limite: descarta até o delimitador
+
+    TaskHandle_t task;        // acordada pelo callback de RX do stdio
+    volatile uint32_t rx_event_us;  // instante do 1º aviso de RX ainda não drenado
+    volatile bool     rx_pending;
+
+    uint32_t wakeups;
+    uint32_t bytes;
+    uint32_t lines;
+    uint32_t lat_sum_us;
+    uint32_t lat_max_us;
+    uint32_t t0_ms;
+    uint32_t bin_bad;         // quadros binários com COBS/CRC inválido (ou texto intercalado)
+    uint32_t q_full;          // vezes que a fila encheu (host segurado pelo USB)
+    uint8_t  q_max;           // maior ocupação observada
+} serial_rx_t;
+
+_Static_assert((APP_SERIAL_PIPELINE_DEPTH & (APP_SERIAL_PIPELINE_DEPTH - 1u)) == 0u &&
+               APP_SERIAL_PIPELINE_DEPTH <= 128u, "APP_SERIAL_PIPELINE_DEPTH: potência de 2 <= 128");
+
+static serial_rx_t g_rx;
+
+/**
+ * @brief Callback da CDC do RPC (contexto da vTaskUsb): há bytes para ler.
+ */
+static void serial_rx_available_cb(void *param)
+{
+    serial_rx_t *rx = (serial_rx_t*)param;
+
+    if (!rx->rx_pending) {
+        rx->rx_event_us = time_us_32();
+        rx->rx_pending  = true;
+    }
+    xTaskNotifyGive(rx->task);
+}
+
+/**
+ * @brief Drena o stdio para a fila até acabar os bytes disponíveis ou a fila encher.
+ *
+ * Modo texto: unidade = linha terminada em '\n' ('\r' ignorado, termina em '\0').
+ * Modo binário: unidade = bytes entre delimitadores 0x00 (quadro COBS ainda codificado).
+ * @return true se parou por fila cheia (ainda pode haver bytes no USB).
+ */
+static bool serial_rx_fill(bool binary)
+{
+    serial_rx_t *rx = &g_rx;
+    const int delim = binary ? 0x00 : '\n';
+
+    while ((uint8_t)(rx->head - rx->tail) < APP_SERIAL_PIPELINE_DEPTH) {
+        int ch = usb_rpc_getc();
+        if (ch < 0) {
+            rx->rx_pending = false;
+            return false;
+        }
+        rx->bytes++;
+
+        if (!binary && ch == '\r') continue;
+
+        const uint8_t i = rx->head % APP_SERIAL_PIPELINE_DEPTH;
+        char *buf = rx->slot[i];
+
+        if (ch == delim) {
+            bool dropped = rx->overflow;
+            size_t n = rx->idx;
+            buf[n] = '\0';
+            rx->idx = 0;
+            rx->overflow = false;
+
+            if (dropped) {
+                if (binary) { rx->bin_bad++; continue; }
+                n = 0;                   // vira "line too long" na ordem em que chegou
+                buf[0] = '\0';
+            } else if (n == 0) {
+                continue;                // linha vazia / 0x00 inicial de cada quadro
+            }
+
+            rx->slot_len[i] = (uint16_t)n;
+            rx->head++;
+            rx->lines++;
+
+            uint8_t used = (uint8_t)(rx->head - rx->tail);
+            if (used > rx->q_max) rx->q_max = used;
+            continue;
+        }
+
+        if (rx->idx + 1 < APP_SERIAL_LINE_MAX) {
+            buf[rx->idx++] = (char)ch;
+        } else {
+            rx->overflow = true;
+        }
+    }
+
+    rx->q_full++;
+    return true;
+}
+
+/**
+ * @brief Retira o próximo pedido da fila (conteúdo válido até o próximo serial_rx_fill).
+ */
+static bool serial_rx_take(char **out, size_t *out_len)
+{
+    serial_rx_t *rx = &g_rx;
+    if (rx->tail == rx->head) return false;
+
+    const uint8_t i = rx->tail % APP_SERIAL_PIPELINE_DEPTH;
+    rx->tail++;
+    *out = rx->slot[i];
+    *out_len = rx->slot_len[i];
+    return true;
+}
+
+/**
+ * @brief Descarta pedidos lidos com o delimitador antigo (troca de modo no meio da fila).
+ */
+static void serial_rx_discard(void)
+{
+    g_rx.tail = g_rx.head;
+    g_rx.idx = 0;
+    g_rx.overflow = false;
+}
+
+/**
+ * @brief Registra a latência RX -> fim do tratamento de uma linha.
+ */
+static void serial_rx_note_latency(serial_rx_t *rx)
+{
+    uint32_t lat = time_us_32() - rx->rx_event_us;
+    rx->lat_sum_us += lat;
+    if (lat > rx->lat_max_us) rx->lat_max_us = lat;
+}
+
+/**
+ * @brief Liga a fila de amostras brutas só quando alguém vai consumi-la.
+ */
+static void serial_sub_update_raw(rpc_session_t *s)
+{
+    bool on = s->authed && !s->binary && s->sub.active && s->sub.raw;
+    if (s->ctx->lux_samples_on == on) return;
+
+    s->ctx->lux_samples_on = on;
+    if (!on) xQueueReset(s->ctx->q_lux_samples);
+}
+
+typedef void (*rpc_handler_t)(rpc_session_t *s, const json_doc_t *doc);
+
+static void rpc_op_hello(rpc_session_t *s, const json_doc_t *doc)
+{
+    (void)doc;
+    serial_send_hello(s);
+}
+
+static void rpc_op_logout(rpc_session_t *s, const json_doc_t *doc)
+{
+    (void)doc;
+    s->authed = false;
+    serial_sub_update_raw(s);
+    serial_send_ack(s, "logout ok");
+    serial_send_hello(s);
+}
+
+static void rpc_op_auth(rpc_session_t *s, const json_doc_t *doc)
+{
+    char pass[64] = {0};
+    bool got = json_doc_get_string(doc, "password", pass, sizeof(pass)) ||
+               json_doc_get_string(doc, "pass", pass, sizeof(pass));
+
+    if (!got) {
+        serial_send_auth(s, false);
+    } else {
+        bool ok = (strcmp(pass, APP_SERIAL_ACCESS_PASSWORD) == 0);
+        s->authed = ok;
+        serial_sub_update_raw(s);
+        serial_send_auth(s, ok);
+        if (ok) serial_send_ack(s, "auth ok");
+    }
+}
+
+static void rpc_op_cmd(rpc_session_t *s, const json_doc_t *doc)
+{
+    if (!s->authed) {
+        serial_send_err(s, "not authenticated");
+    } else {
+        // reaproveita o mesmo documento para o parser de comandos
+        matrix_control_apply_cmd_doc(doc);
+        serial_send_ack(s, "cmd applied");
+    }
+}
+
+static void rpc_op_stats(rpc_session_t *s, const json_doc_t *doc)
+{
+    (void)doc;
+
+    const serial_rx_t *rx = &g_rx;
+    uint32_t up_ms = pdTICKS_TO_MS(xTaskGetTickCount()) - rx->t0_ms;
+
+    json_writer_t w;
+    serial_reply_begin(&w, s, "stats");
+    json_w_uint(&w, "uptime_ms", up_ms);
+    json_w_uint(&w, "wakeups", rx->wakeups);
+    json_w_fixed(&w, "wakeups_s", up_ms ? (float)rx->wakeups * 1000.0f / (float)up_ms : 0.0f, 2);
+    json_w_uint(&w, "rx_bytes", rx->bytes);
+    json_w_uint(&w, "rx_lines", rx->lines);
+    json_w_uint(&w, "lat_avg_us", rx->lines ? rx->lat_sum_us / rx->lines : 0u);
+    json_w_uint(&w, "lat_max_us", rx->lat_max_us);
+    json_w_uint(&w, "bin_bad", rx->bin_bad);
+    json_w_uint(&w, "q_max", rx->q_max);
+    json_w_uint(&w, "q_full", rx->q_full);
+    json_w_uint(&w, "lux_drop", s->ctx->lux_samples_drop);
+
+    app_log_stats_t ls;
+    app_log_get_stats(&ls);
+    json_w_uint(&w, "log_written", ls.written);
+    json_w_uint(&w, "log_drop", ls.dropped);
+    json_w_uint(&w, "log_max_us", ls.lat_max_us);
+    json_w_uint(&w, "trace_drop", app_trace_dropped());
+
+    usb_cdc_stats_t us;
+    usb_cdc_get_stats(&us);
+    json_w_uint(&w, "usb_rpc_drop", us.rpc_tx_drop);
+    json_w_uint(&w, "usb_log_drop", us.log_tx_drop);
+
+    net_wifi_stats_t ws;
+    net_wifi_get_stats(&ws);
+    json_w_uint(&w, "boot_led_ms", s->ctx->boot_led_ms);
+    json_w_uint(&w, "wifi_state", (uint32_t)net_wifi_state());
+    json_w_uint(&w, "wifi_up_ms", ws.boot_up_ms);
+    json_w_uint(&w, "wifi_join_ms", ws.last_join_ms);
+    json_w_uint(&w, "wifi_joins", ws.joins);
+    json_w_uint(&w, "wifi_fails", ws.fails);
+    json_w_uint(&w, "wifi_drops", ws.drops);
+    json_w_uint(&w, "wifi_fast_joins", ws.fast_joins);
+    json_w_uint(&w, "wifi_fast_fails", ws.fast_fails);
+    json_w_uint(&w, "wifi_fast_ip_ms", ws.fast_ip_ms);
+    json_w_uint(&w, "wifi_full_ip_ms", ws.full_ip_ms);
+
+    const mqtt_outbox_t *mo = &s->ctx->mqtt.out;
+    json_w_uint(&w, "mqtt_inflight", mo->count);
+    json_w_uint(&w, "mqtt_acked", mo->acked);
+    json_w_uint(&w, "mqtt_resent", mo->resent);
+    json_w_uint(&w, "mqtt_lost", mo->lost);
+    json_w_uint(&w, "mqtt_qdrop", s->ctx->tele_drop);
+    serial_reply_end(&w);
+}
+
+/**
+ * @brief Troca entre linhas JSON e quadros binários.
+ *
+ * A CDC do RPC não passa pelo stdio (sem tradução "\n" -> "\r\n"), então os quadros
+ * saem intactos. O que já estava na fila foi lido com o delimitador do modo anterior e
+ * é descartado; o host deve esperar o ack da troca antes de mandar o próximo pedido.
+ */
+static void serial_set_binary(rpc_session_t *s, bool binary)
+{
+    s->binary = binary;
+    s->dump.active = false;
+    serial_rx_discard();
+    serial_sub_update_raw(s);
+}
+
+static void rpc_op_binary(rpc_session_t *s, const json_doc_t *doc)
+{
+    (void)doc;
+    serial_send_ack(s, "binary");
+    serial_set_binary(s, true);
+}
+
+/**
+ * @brief {"op":"subscribe","fields":["lux",...],"period_ms":100,"decimate":1,"raw":false}
+ *
+ * Substitui a assinatura atual; campos omitidos voltam ao padrão. Responde com a
+ * configuração efetiva (período/decimação limitados).
+ */
+static void rpc_op_subscribe(rpc_session_t *s, const json_doc_t *doc)
+{
+    if (!s->authed) {
+        serial_send_err(s, "not authenticated");
+        return;
+    }
+
+    serial_sub_t sub = k_sub_default;
+
+    int v = json_doc_find(doc, "fields");
+    if (v >= 0) {
+        if (doc->toks[v].type != JSON_TOK_ARRAY) {
+            serial_send_err(s, "bad fields");
+            return;
+        }
+        sub.fields = 0;
+        for (int i = v + 1; i < doc->count && doc->toks[i].parent >= v; i++) {
+            const json_tok_t *t = &doc->toks[i];
+            if (t->parent != v) continue;
+
+            uint16_t f = (t->type == JSON_TOK_STRING)
+                       ? telemetry_json_field(doc->json + t->start, (size_t)(t->end - t->start))
+                       : 0;
+            if (!f) {
+                serial_send_err(s, "unknown field");
+                return;
+            }
+            sub.fields |= f;
+        }
+    }
+
+    int n;
+    if (json_doc_get_int(doc, "period_ms", &n)) {
+        sub.period_ms = (n < (int)APP_SERIAL_SUB_MIN_PERIOD_MS) ? APP_SERIAL_SUB_MIN_PERIOD_MS : (uint32_t)n;
+    }
+    if (json_doc_get_int(doc, "decimate", &n)) {
+        sub.decimate = (n < 1) ? 1u : (n > 1000) ? 1000u : (uint16_t)n;
+    }
+    (void)json_doc_get_bool(doc, "raw", &sub.raw);
+
+    s->sub = sub;
+    serial_sub_update_raw(s);
+
+    json_writer_t w;
+    serial_reply_begin(&w, s, "subscribe");
+    json_w_bool(&w, "ok", true);
+    telemetry_json_write_field_names(&w, "fields", sub.fields);
+    json_w_uint(&w, "period_ms", sub.period_ms);
+    json_w_uint(&w, "decimate", sub.decimate);
+    json_w_bool(&w, "raw", sub.raw);
+    serial_reply_end(&w);
+}
+
+static void rpc_op_unsubscribe(rpc_session_t *s, const json_doc_t *doc)
+{
+    (void)doc;
+    s->sub.active = false;
+    serial_sub_update_raw(s);
+    serial_send_ack(s, "unsubscribed");
+}
+
+// ------------------------------------------------------------
+// Dump do histórico
+// ------------------------------------------------------------
+static hist_sample_t g_dump_buf[APP_SERIAL_DUMP_CHUNK];
+
+static void serial_dump_begin(json_writer_t *w, const serial_dump_t *d, const char *op)
+{
+    json_w_init(w, serial_tx_sink, NULL);
+    json_w_begin(w);
+    json_w_str(w, "op", op);
+    if (d->id_len) json_w_member_raw(w, "id", d->id, d->id_len);
+}
+
+static void serial_dump_finish(rpc_session_t *s)
+{
+    serial_dump_t *d = &s->dump;
+
+    json_writer_t w;
+    serial_dump_begin(&w, d, "dump_end");
+    json_w_uint(&w, "next", d->next);
+    json_w_uint(&w, "sent", d->sent);
+    json_w_uint(&w, "lost", d->lost);
+    serial_reply_end(&w);
+    d->active = false;
+}
+
+/**
+ * @brief Envia um bloco do dump (colunas: t0 + dt em ms e valores quantizados).
+ *
+ * {"op":"dump_chunk","id":..,"off":<índice do 1º>,"next":<retomada>,"n":k,"t0":..,
+ *  "dt":[..],"lux":[..],"temp":[..],"hum":[..],"perc":[..]}
+ * Quadros fora de [from_ms, to_ms] são pulados sem consumir crédito.
+ */
+static void serial_dump_step(rpc_session_t *s)
 {
-    printf("{\"op\":\"ack\",\"ok\":true,\"msg\":\"%s\"}\n", msg ? msg : "");
+    static const char *const k_cols[HIST_FIELDS] = { "lux", "temp", "hum", "perc" };
+    serial_dump_t *d = &s->dump;
+
+    uint32_t want = d->end - d->next;
+    if (want > APP_SERIAL_DUMP_CHUNK) want = APP_SERIAL_DUMP_CHUNK;
+    uint16_t n = history_read_span(d->next, g_dump_buf, (uint16_t)want);
+    if (n == 0 || g_dump_buf[0].idx >= d->end) {
+        serial_dump_finish(s);
+        return;
+    }
+    if (g_dump_buf[0].idx > d->next) d->lost += g_dump_buf[0].idx - d->next;
+
+    // recorta a janela de tempo (os instantes são crescentes)
+    uint16_t a = 0, b = 0;
+    while (a < n && g_dump_buf[a].t_ms < d->from_ms) a++;
+    for (b = a; b < n && g_dump_buf[b].idx < d->end && g_dump_buf[b].t_ms <= d->to_ms; b++) { }
+    if (b < n && g_dump_buf[b].t_ms > d->to_ms) d->end = g_dump_buf[b].idx;   // passou do fim
+    d->next = g_dump_buf[n - 1u].idx + 1u;
+    if (b < n && g_dump_buf[b].idx >= d->end) d->next = d->end;
+
+    if (b > a) {
+        json_writer_t w;
+        serial_dump_begin(&w, d, "dump_chunk");
+        json_w_uint(&w, "off", g_dump_buf[a].idx);
+        json_w_uint(&w, "next", d->next);
+        json_w_uint(&w, "n", (uint32_t)(b - a));
+        json_w_uint(&w, "t0", g_dump_buf[a].t_ms);
+
+        json_w_begin_arr(&w, "dt");
+        for (uint16_t i = a; i < b; i++) {
+            json_w_uint(&w, NULL, (i == a) ? 0u : g_dump_buf[i].t_ms - g_dump_buf[i - 1u].t_ms);
+        }
+        json_w_end_arr(&w);
+
+        for (int f = 0; f < HIST_FIELDS; f++) {
+            json_w_begin_arr(&w, k_cols[f]);
+            for (uint16_t i = a; i < b; i++) json_w_int(&w, NULL, g_dump_buf[i].v[f]);
+            json_w_end_arr(&w);
+        }
+        serial_reply_end(&w);
+
+        d->sent += (uint32_t)(b - a);
+        d->credit--;
+    }
+
+    if (d->next >= d->end) serial_dump_finish(s);
 }
 
 /**
- * @brief Lê uma linha (não-bloqueante) do stdio via getchar_timeout_us.
+ * @brief {"op":"dump","from_ms":0,"to_ms":..,"offset":N,"credit":8}
  *
- * Observação: considera linhas terminadas com '\n'. Ignora '\r'.
+ * Responde {"op":"dump","first","end","chunk","fields","scale"} e depois os blocos
+ * "dump_chunk" (um por volta do loop, sem dormir) até "dump_end". Para retomar uma
+ * transferência interrompida, repetir o pedido com "offset" = último "next" recebido.
  */
-static bool serial_read_line(char *out, size_t out_sz)
+static void rpc_op_dump(rpc_session_t *s, const json_doc_t *doc)
+{
+    if (!s->authed) {
+        serial_send_err(s, "not authenticated");
+        return;
+    }
+    if (s->dump.active) {
+        serial_send_err(s, "dump active");
+        return;
+    }
+
+    serial_dump_t d = { .active = true, .to_ms = UINT32_MAX, .credit = APP_SERIAL_DUMP_CREDIT };
+    // o id vai em todos os blocos: um id que não cabe é recusado, não cortado nem omitido
+    if (s->id && s->id_len > sizeof(d.id)) {
+        serial_send_err(s, "id too long");
+        return;
+    }
+    if (s->id) {
+        memcpy(d.id, s->id, s->id_len);
+        d.id_len = (uint8_t)s->id_len;
+    }
+
+    int n;
+    uint32_t first;
+    history_span(&first, &d.end);
+    d.next = first;
+    if (json_doc_get_int(doc, "offset", &n) && n > 0 && (uint32_t)n > first) d.next = (uint32_t)n;
+    if (json_doc_get_int(doc, "from_ms", &n) && n > 0) d.from_ms = (uint32_t)n;
+    if (json_doc_get_int(doc, "to_ms", &n) && n >= 0) d.to_ms = (uint32_t)n;
+    if (json_doc_get_int(doc, "credit", &n) && n > 0) d.credit = (uint32_t)n;
+
+    json_writer_t w;
+    serial_reply_begin(&w, s, "dump");
+    json_w_bool(&w, "ok", true);
+    json_w_uint(&w, "first", first);
+    json_w_uint(&w, "end", d.end);
+    json_w_uint(&w, "chunk", APP_SERIAL_DUMP_CHUNK);
+    json_w_begin_arr(&w, "scale");
+    for (int f = 0; f < HIST_FIELDS; f++) json_w_int(&w, NULL, history_scale((hist_field_t)f));
+    json_w_end_arr(&w);
+    serial_reply_end(&w);
+
+    s->dump = d;
+    if (d.next >= d.end) serial_dump_finish(s);
+}
+
+/**
+ * @brief {"op":"dump_credit","n":4}: libera mais blocos do dump em andamento.
+ */
+static void rpc_op_dump_credit(rpc_session_t *s, const json_doc_t *doc)
+{
+    int n;
+    if (!s->dump.active) return;        // dump já terminou: crédito atrasado, sem resposta
+    if (json_doc_get_int(doc, "n", &n) && n > 0) s->dump.credit += (uint32_t)n;
+}
+
+static void rpc_op_dump_stop(rpc_session_t *s, const json_doc_t *doc)
 {
-    static char buf[256];
-    static size_t idx = 0;
+    (void)doc;
+    if (s->dump.active) serial_dump_finish(s);
+    else                serial_send_ack(s, "no dump");
+}
+
+/**
+ * @brief Tabela de ops: nome -> handler (resolvida por hash perfeito).
+ *
+ * Para um op novo: acrescentar o handler e a linha abaixo.
+ */
+#define SERIAL_RPC_OPS(X)                   \
+    X("hello",       rpc_op_hello)          \
+    X("logout",      rpc_op_logout)         \
+    X("auth",        rpc_op_auth)           \
+    X("cmd",         rpc_op_cmd)            \
+    X("stats",       rpc_op_stats)          \
+    X("binary",      rpc_op_binary)         \
+    X("subscribe",   rpc_op_subscribe)      \
+    X("unsubscribe", rpc_op_unsubscribe)    \
+    X("dump",        rpc_op_dump)           \
+    X("dump_credit", rpc_op_dump_credit)    \
+    X("dump_stop",   rpc_op_dump_stop)
 
-    int ch = getchar_timeout_us(0);
-    if (ch == PICO_ERROR_TIMEOUT) return false;
+#define RPC_OP_NAME(name, fn)    name,
+#define RPC_OP_HANDLER(name, fn) fn,
 
-    if (ch == '\r') return false;
+static const char *const k_op_names[] = { SERIAL_RPC_OPS(RPC_OP_NAME) };
+static const rpc_handler_t k_op_handlers[] = { SERIAL_RPC_OPS(RPC_OP_HANDLER) };
+static dispatch_table_t g_ops;
+
+/**
+ * @brief Guarda o "id" opcional do pedido (string ou número) para ecoar nas respostas.
+ */
+static void rpc_take_id(rpc_session_t *s, const json_doc_t *doc)
+{
+    s->id = NULL;
+    s->id_len = 0;
 
-    if (ch == '\n') {
-        buf[idx] = '\0';
-        snprintf(out, out_sz, "%s", buf);
-        idx = 0;
-        return true;
+    int v = json_doc_find(doc, "id");
+    if (v < 0) return;
+
+    const json_tok_t *t = &doc->toks[v];
+    if (t->type == JSON_TOK_STRING) {
+        // token de string não inclui as aspas; ecoa com elas
+        s->id = doc->json + t->start - 1;
+        s->id_len = (size_t)(t->end - t->start) + 2u;
+    } else if (t->type == JSON_TOK_PRIMITIVE) {
+        s->id = doc->json + t->start;
+        s->id_len = (size_t)(t->end - t->start);
     }
+}
+
+/**
+ * @brief Resolve e executa o op da linha; false se a linha não tem "op" string.
+ */
+static bool rpc_dispatch(rpc_session_t *s, const json_doc_t *doc)
+{
+    int v = json_doc_find(doc, "op");
+    if (v < 0 || doc->toks[v].type != JSON_TOK_STRING) return false;
 
-    if (idx + 1 < sizeof(buf)) {
-        buf[idx++] = (char)ch;
+    const json_tok_t *t = &doc->toks[v];
+    int op = dispatch_lookup(&g_ops, doc->json + t->start, (size_t)(t->end - t->start));
+    if (op < 0) {
+        serial_send_err(s, "unknown op");
+    } else {
+        k_op_handlers[op](s, doc);
     }
-    return false;
+    return true;
+}
+
+/**
+ * @brief Trata uma linha JSON da fila.
+ */
+static void rpc_handle_line(rpc_session_t *s, char *line, size_t line_len)
+{
+    s->id = NULL;
+    s->id_len = 0;
+
+    if (line_len == 0) {
+        serial_send_err(s, "line too long");
+        return;
+    }
+
+    json_tok_t toks[JSON_MAX_TOKENS_DEFAULT];
+    json_doc_t doc;
+    bool parsed = (json_parse(&doc, line, line_len, toks, JSON_MAX_TOKENS_DEFAULT) > 0);
+    if (parsed) rpc_take_id(s, &doc);
+
+    if (!parsed || !rpc_dispatch(s, &doc)) {
+        // opcional: se não tem "op", trata como comando implícito (quando autenticado)
+        if (s->authed && parsed &&
+            (json_doc_find(&doc, "mode") >= 0 ||
+             json_doc_find(&doc, "brightness") >= 0 ||
+             json_doc_find(&doc, "percent") >= 0)) {
+            matrix_control_apply_cmd_doc(&doc);
+            serial_send_ack(s, "cmd applied (implicit)");
+        } else {
+            serial_send_err(s, "bad json");
+        }
+    }
+    s->id = NULL;
+}
+
+/**
+ * @brief Telemetria JSON (mesmo esquema do MQTT) quando há frame novo: só os campos assinados.
+ */
+static void serial_send_telemetry(rpc_session_t *s, uint32_t *last_seq)
+{
+    sensor_frame_t fr;
+    if (xQueuePeek(s->ctx->q_frame, &fr, 0) != pdPASS || fr.seq == *last_seq) return;
+    *last_seq = fr.seq;
+
+    if ((s->sub.frame_n++ % s->sub.decimate) != 0) return;
+
+    json_writer_t w;
+    json_w_init(&w, serial_tx_sink, NULL);
+    telemetry_json_write_fields(&w, "telemetry", s->ctx->device_id, &fr, s->sub.fields);
+    json_w_raw(&w, "\n", 1);
+    serial_tx_flush();
+}
+
+/**
+ * @brief Amostras brutas de lux: {"op":"lux","t_ms":...,"lux":...}, uma linha por leitura.
+ */
+static void serial_send_lux_samples(rpc_session_t *s)
+{
+    lux_sample_t smp;
+    while (xQueueReceive(s->ctx->q_lux_samples, &smp, 0) == pdPASS) {
+        if ((s->sub.raw_n++ % s->sub.decimate) != 0) continue;
+
+        json_writer_t w;
+        json_w_init(&w, serial_tx_sink, NULL);
+        json_w_begin(&w);
+        json_w_str(&w, "op", "lux");
+        json_w_uint(&w, "t_ms", smp.t_ms);
+        json_w_fixed(&w, "lux", smp.lux, 2);
+        json_w_end(&w);
+        json_w_raw(&w, "\n", 1);
+        serial_tx_flush();
+    }
+}
+
+// ------------------------------------------------------------
+// Modo binário
+// ------------------------------------------------------------
+/** Flags aceitas em SERIAL_BIN_T_CMD (F_MODE_BAD é só do parser de texto). */
+#define BIN_CMD_FLAGS (MATRIX_CMD_F_MODE | MATRIX_CMD_F_PERCENT | MATRIX_CMD_F_CHANNEL)
+
+/**
+ * @brief Envia um quadro em uma única escrita (não se mistura com printf de outras tasks).
+ */
+static void bin_send(uint8_t type, const uint8_t *payload, size_t len)
+{
+    static uint8_t wire[SERIAL_BIN_WIRE_MAX];
+
+    size_t n = serial_bin_frame(type, payload, len, wire);
+    if (n == 0) return;
+    usb_rpc_write(wire, n);
+    usb_rpc_flush();
+}
+
+static void bin_send_ack(uint8_t req_type, serial_bin_status_t st)
+{
+    uint8_t p[2] = { req_type, (uint8_t)st };
+    bin_send(SERIAL_BIN_T_ACK, p, sizeof(p));
+}
+
+/**
+ * @brief Trata um quadro recebido (ainda codificado em COBS).
+ */
+static void bin_handle_frame(rpc_session_t *s, uint8_t *buf, size_t len)
+{
+    uint8_t type;
+    const uint8_t *pl;
+    size_t plen;
+
+    if (!serial_bin_unframe(buf, len, &type, &pl, &plen)) {
+        g_rx.bin_bad++;
+        return;
+    }
+
+    switch (type) {
+    case SERIAL_BIN_T_PING:
+        bin_send_ack(type, SERIAL_BIN_OK);
+        break;
+
+    case SERIAL_BIN_T_AUTH: {
+        size_t n = strlen(APP_SERIAL_ACCESS_PASSWORD);
+        s->authed = (plen == n && memcmp(pl, APP_SERIAL_ACCESS_PASSWORD, n) == 0);
+        bin_send_ack(type, s->authed ? SERIAL_BIN_OK : SERIAL_BIN_E_AUTH);
+        break;
+    }
+
+    case SERIAL_BIN_T_CMD: {
+        if (!s->authed) { bin_send_ack(type, SERIAL_BIN_E_AUTH); break; }
+        if (plen != SERIAL_BIN_CMD_LEN) { bin_send_ack(type, SERIAL_BIN_E_LEN); break; }
+
+        serial_bin_cmd_t bc;
+        serial_bin_get_cmd(pl, &bc);
+        // campos vêm direto do fio: modo e flags fora do conhecido recusam o comando
+        if (bc.mode > MATRIX_MODE_MANUAL || (bc.flags & (uint8_t)~BIN_CMD_FLAGS) != 0) {
+            bin_send_ack(type, SERIAL_BIN_E_ARG);
+            break;
+        }
+        matrix_cmd_t cmd = {
+            .flags = bc.flags, .mode = bc.mode, .channel = bc.channel, .percent = bc.percent
+        };
+        matrix_control_apply_cmd(&cmd);
+        bin_send_ack(type, SERIAL_BIN_OK);
+        break;
+    }
+
+    case SERIAL_BIN_T_TEXT:
+        bin_send_ack(type, SERIAL_BIN_OK);
+        serial_set_binary(s, false);
+        serial_send_hello(s);
+        break;
+
+    default:
+        bin_send_ack(type, SERIAL_BIN_E_TYPE);
+        break;
+    }
+}
+
+/**
+ * @brief Telemetria compacta: amostra de lux a cada período + frame quando muda o seq.
+ */
+static void bin_send_telemetry(const app_ctx_t *ctx, uint32_t *last_seq)
+{
+    float lux;
+    if (xQueuePeek(ctx->q_lux, &lux, 0) == pdPASS) {
+        uint8_t p[8];
+        uint32_t t_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+        int32_t lx = (int32_t)(lux * 100.0f);
+        for (int i = 0; i < 4; i++) { p[i] = (uint8_t)(t_ms >> (8 * i)); p[4 + i] = (uint8_t)((uint32_t)lx >> (8 * i)); }
+        bin_send(SERIAL_BIN_T_LUX, p, sizeof(p));
+    }
+
+    sensor_frame_t fr;
+    if (xQueuePeek(ctx->q_frame, &fr, 0) != pdPASS || fr.seq == *last_seq) return;
+    *last_seq = fr.seq;
+
+    serial_bin_tele_t t = {
+        .seq          = fr.seq,
+        .t_ms         = pdTICKS_TO_MS(fr.tick),
+        .lux_x100     = (int32_t)(fr.lux * 100.0f),
+        .lux_perc_x10 = (uint16_t)(fr.luxPercLum * 10.0f),
+        .temp_x100    = (int16_t)(fr.temp * 100.0f),
+        .hum_x100     = (uint16_t)(fr.hum * 100.0f),
+        .mode         = (uint8_t)matrix_control_get_mode(),
+        .target       = matrix_control_get_target_percent(),
+        .current      = matrix_control_get_current_percent(),
+    };
+    uint8_t p[SERIAL_BIN_TELE_LEN];
+    serial_bin_put_tele(p, &t);
+    bin_send(SERIAL_BIN_T_TELEMETRY, p, sizeof(p));
 }
 
 void vTaskSerialRpc(void *pvParameters)
 {
-    app_ctx_t *ctx = (app_ctx_t*)pvParameters;
+    rpc_session_t sess = {
+        .ctx = (app_ctx_t*)pvParameters, .authed = false, .binary = false, .sub = k_sub_default
+    };
+    app_ctx_t *ctx = sess.ctx;
 
-    bool authed = false;
     uint32_t last_seq = 0;
     TickType_t last_tele = 0;
 
-    printf("{\"op\":\"info\",\"msg\":\"SerialRPC up\"}\n");
-    serial_send_hello(ctx, authed);
+    (void)dispatch_build(&g_ops, k_op_names, (uint8_t)(sizeof(k_op_names) / sizeof(k_op_names[0])));
+
+    // RX por evento: o callback do stdio acorda a task; sem polling
+    g_rx.task  = xTaskGetCurrentTaskHandle();
+    g_rx.t0_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+    usb_rpc_set_rx_callback(serial_rx_available_cb, &g_rx);
+
+    LOG_I("SerialRPC up (CDC 0)");
+    serial_send_hello(&sess);
 
-    char line[256];
+    char *line;
+    size_t line_len;
 
     for (;;)
     {
-        // 1) RX: processa linhas JSON do PC
-        if (serial_read_line(line, sizeof(line))) {
-
-            if (line[0] == '\0') { vTaskDelay(pdMS_TO_TICKS(5)); continue; }
-
-            char op[16] = {0};
-            if (json_get_string(line, "op", op, sizeof(op))) {
-
-                if (strcmp(op, "hello") == 0) {
-                    serial_send_hello(ctx, authed);
-                }
-                else if (strcmp(op, "logout") == 0) {
-                    authed = false;
-                    serial_send_ack("logout ok");
-                    serial_send_hello(ctx, authed);
-                }
-                else if (strcmp(op, "auth") == 0) {
-                    char pass[64] = {0};
-                    bool got = json_get_string(line, "password", pass, sizeof(pass)) ||
-                               json_get_string(line, "pass", pass, sizeof(pass));
-
-                    if (!got) {
-                        serial_send_auth(false);
-                    } else {
-                        bool ok = (strcmp(pass, APP_SERIAL_ACCESS_PASSWORD) == 0);
-                        authed = ok;
-                        serial_send_auth(ok);
-                        if (ok) serial_send_ack("auth ok");
-                    }
-                }
-                else if (strcmp(op, "cmd") == 0) {
-                    if (!authed) {
-                        serial_send_err("not authenticated");
-                    } else {
-                        // reaproveita o mesmo payload para o parser de comandos
-                        matrix_control_apply_cmd_payload(line);
-                        serial_send_ack("cmd applied");
-                    }
-                }
-                else {
-                    serial_send_err("unknown op");
-                }
-            } else {
-                // opcional: se não tem "op", trata como comando implícito (quando autenticado)
-                if (authed && (strstr(line, "\"mode\"") || strstr(line, "\"brightness\"") || strstr(line, "\"percent\""))) {
-                    matrix_control_apply_cmd_payload(line);
-                    serial_send_ack("cmd applied (implicit)");
-                } else {
-                    serial_send_err("bad json");
-                }
-            }
+        // 0) host abriu a porta: sessão nova (sem auth, modo texto) + hello
+        if (usb_rpc_take_connect()) {
+            sess.authed = false;
+            sess.sub = k_sub_default;
+            serial_set_binary(&sess, false);   // também encerra um dump em andamento
+            serial_send_hello(&sess);
+        }
+
+        // 1) RX: enche a fila com o que já chegou e trata os pedidos em ordem
+        bool more = serial_rx_fill(sess.binary);
+
+        while (serial_rx_take(&line, &line_len)) {
+            if (sess.binary) bin_handle_frame(&sess, (uint8_t*)line, line_len);
+            else             rpc_handle_line(&sess, line, line_len);
+            serial_rx_note_latency(&g_rx);
         }
 
-        // 2) TX: telemetria (somente se autenticado)
-        if (authed) {
+        // 2) TX: telemetria (somente se autenticado) conforme a assinatura
+        const TickType_t period = pdMS_TO_TICKS(sess.binary ? APP_SERIAL_BIN_TELE_PERIOD_MS
+                                                            : sess.sub.period_ms);
+        const bool tele_on = sess.authed &&
+                             (sess.binary || (sess.sub.active && sess.sub.fields != 0));
+        if (tele_on) {
             TickType_t now = xTaskGetTickCount();
 
-            if ((now - last_tele) >= pdMS_TO_TICKS(APP_SERIAL_TELE_PERIOD_MS)) {
+            if ((now - last_tele) >= period) {
                 last_tele = now;
 
-                sensor_frame_t fr;
-                if (xQueuePeek(ctx->q_frame, &fr, 0) == pdPASS) {
-                    if (fr.seq != last_seq) {
-                        last_seq = fr.seq;
-
-                        const char *mstr = (matrix_control_get_mode() == MATRIX_MODE_AUTO) ? "auto" : "manual";
-
-                        printf("{\"op\":\"telemetry\",\"device\":\"%s\","
-                               "\"lux\":%.2f,\"luxPercLum\":%.1f,"
-                               "\"temp\":%.2f,\"hum\":%.2f,"
-                               "\"seq\":%lu,\"t_ms\":%lu,"
-                               "\"mode\":\"%s\",\"target\":%u,\"current\":%u}\n",
-                               ctx->device_id,
-                               (double)fr.lux,
-                               (double)fr.luxPercLum,
-                               (double)fr.temp,
-                               (double)fr.hum,
-                               (unsigned long)fr.seq,
-                               (unsigned long)pdTICKS_TO_MS(fr.tick),
-                               mstr,
-                               (unsigned)matrix_control_get_target_percent(),
-                               (unsigned)matrix_control_get_current_percent());
-                    }
-                }
+                if (sess.binary) bin_send_telemetry(ctx, &last_seq);
+                else             serial_send_telemetry(&sess, &last_seq);
             }
         }
+        if (ctx->lux_samples_on) serial_send_lux_samples(&sess);
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // 2b) dump: um bloco por volta, intercalado com RX (créditos) e telemetria
+        if (sess.dump.active && sess.dump.credit > 0) {
+            serial_dump_step(&sess);
+            if (sess.dump.active && sess.dump.credit > 0) more = true;
+        }
+
+        // fila encheu ou dump com crédito: não dorme, volta a ler
+        if (more) continue;
+
+        // 3) dorme até chegar RX, amostra de lux (notificação do vTaskLuminos)
+        //    ou vencer a próxima telemetria
+        TickType_t wait = pdMS_TO_TICKS(APP_SERIAL_IDLE_WAKE_MS);
+        if (tele_on) {
+            TickType_t since = xTaskGetTickCount() - last_tele;
+            wait = (since >= period) ? 1 : (period - since);
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+        g_rx.wakeups++;
     }
 }
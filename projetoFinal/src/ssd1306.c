@@ -1,78 +1,391 @@
 
 #include "ssd1306.h"
 #include "hardware/gpio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #include "pico/stdlib.h"
 #include <string.h>
 #include "font6x8.h"
 
-static uint8_t buffer[SSD1306_WIDTH * SSD1306_HEIGHT / 8];
+#define SSD1306_PAGES (SSD1306_HEIGHT / 8)
+
+// Palavras no formato de IC_DATA_CMD (byte de dados + bit STOP), escritas pelo DMA em 16 bits
+#define WORD_STOP     ((uint16_t)I2C_IC_DATA_CMD_STOP_BITS)
+#define CTRL_CMD      0x00u   // Co=0, D/C=0: segue fluxo de comandos
+#define CTRL_DATA     0x40u   // Co=0, D/C=1: segue fluxo de dados
+
+#define SSD1306_SHOW_TIMEOUT_US 100000u
+
+// Trechos por página: colunas iguais ao painel no meio de uma página só viram uma nova
+// janela (0x21/0x22, ~10 bytes a mais) se a lacuna for maior que RUN_GAP colunas
+#define SSD1306_MAX_RUNS  4u
+#define SSD1306_RUN_GAP   10u
+
+// Framebuffer em palavras de 16 bits: o DMA lê direto daqui para o FIFO do I2C (sem cópia).
+// Só o byte baixo é usado pelo desenho.
+static uint16_t buffer[SSD1306_WIDTH * SSD1306_HEIGHT / 8];
 static i2c_inst_t *ssd_i2c;
 
-static void ssd1306_command(uint8_t cmd) {
-    uint8_t buf[2] = {0x00, cmd};
-    i2c_write_blocking(ssd_i2c, SSD1306_I2C_ADDR, buf, 2, false);
+// Cópia do que já está no painel: permite descartar bytes reescritos com o mesmo valor
+// (ex.: clear + redraw do mesmo rótulo a cada quadro).
+static uint8_t shadow[SSD1306_WIDTH * SSD1306_HEIGHT / 8];
+static bool shadow_valid = false;
+
+// Faixa de colunas suja por página (x0 > x1 = página limpa)
+static uint8_t dirty_x0[SSD1306_PAGES];
+static uint8_t dirty_x1[SSD1306_PAGES];
+
+static ssd1306_stats_t last_stats;
+
+// -------------------------
+// DMA scatter-gather: um canal de controle carrega (count, addr) no canal de dados,
+// que escreve em IC_DATA_CMD. Cada trecho sujo de uma página vira 4 blocos:
+//   [0x00 0x21 x0 x1 0x22 p p|STOP] [0x40] [x0..x1-1] [x1|STOP]
+// -------------------------
+typedef struct {
+    uint32_t count;
+    const volatile void *addr;
+} dma_cb_t;
+
+static int dma_data = -1;
+static int dma_ctrl = -1;
+static dma_cb_t cb_list[SSD1306_PAGES * SSD1306_MAX_RUNS * 4 + 1];
+static uint16_t cmd_words[SSD1306_PAGES * SSD1306_MAX_RUNS][7];
+static uint16_t last_word[SSD1306_PAGES * SSD1306_MAX_RUNS];
+static uint16_t data_hdr = CTRL_DATA;
+
+static volatile bool busy = false;
+static uint32_t t_start;
+static ssd1306_done_cb_t done_cb;
+static void *done_arg;
+
+static inline void mark_dirty(uint8_t page, uint8_t x0, uint8_t x1) {
+    if (x0 < dirty_x0[page]) dirty_x0[page] = x0;
+    if (x1 > dirty_x1[page]) dirty_x1[page] = x1;
 }
 
-static void ssd1306_data(uint8_t *data, size_t len) {
-    uint8_t buf[len + 1];
-    buf[0] = 0x40;
-    memcpy(&buf[1], data, len);
-    i2c_write_blocking(ssd_i2c, SSD1306_I2C_ADDR, buf, len + 1, false);
+static inline void mark_clean(uint8_t page) {
+    dirty_x0[page] = SSD1306_WIDTH;
+    dirty_x1[page] = 0;
+}
+
+// Envia uma sequência de comandos em uma única transação (cmds[0] deve ser CTRL_CMD).
+static void ssd1306_commands(const uint8_t *cmds, size_t len) {
+    i2c_write_blocking(ssd_i2c, SSD1306_I2C_ADDR, cmds, len, false);
+    last_stats.bytes += len + 1; // endereço + controle + comandos
+}
+
+static void ssd1306_dma_isr(void) {
+    if (!dma_channel_get_irq1_status((uint)dma_data)) return;
+    dma_channel_acknowledge_irq1((uint)dma_data);
+
+    last_stats.us = time_us_32() - t_start;
+    busy = false;
+    if (done_cb) done_cb(done_arg);
+}
+
+static void ssd1306_dma_init(void) {
+    dma_data = dma_claim_unused_channel(true);
+    dma_ctrl = dma_claim_unused_channel(true);
+
+    dma_channel_config c = dma_channel_get_default_config((uint)dma_data);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(ssd_i2c, true));
+    channel_config_set_chain_to(&c, (uint)dma_ctrl);
+    channel_config_set_irq_quiet(&c, true); // IRQ só no bloco nulo (fim da lista)
+    dma_channel_configure((uint)dma_data, &c, &i2c_get_hw(ssd_i2c)->data_cmd, NULL, 0, false);
+
+    dma_channel_config k = dma_channel_get_default_config((uint)dma_ctrl);
+    channel_config_set_transfer_data_size(&k, DMA_SIZE_32);
+    channel_config_set_read_increment(&k, true);
+    channel_config_set_write_increment(&k, true);
+    channel_config_set_ring(&k, true, 3); // 2 palavras: al3_transfer_count, al3_read_addr_trig
+    dma_channel_configure((uint)dma_ctrl, &k, &dma_hw->ch[dma_data].al3_transfer_count, cb_list, 2, false);
+
+    dma_channel_set_irq1_enabled((uint)dma_data, true);
+    irq_add_shared_handler(DMA_IRQ_1, ssd1306_dma_isr, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
 }
 
 void ssd1306_init(i2c_inst_t *i2c) {
     ssd_i2c = i2c;
 
-    ssd1306_command(0xAE);
-    ssd1306_command(0xA8); ssd1306_command(0x3F);
-    ssd1306_command(0xD3); ssd1306_command(0x00);
-    ssd1306_command(0x40);
-    ssd1306_command(0xA1);
-    ssd1306_command(0xC8);
-    ssd1306_command(0xDA); ssd1306_command(0x12);
-    ssd1306_command(0x81); ssd1306_command(0x7F);
-    ssd1306_command(0xA4);
-    ssd1306_command(0xA6);
-    ssd1306_command(0xD5); ssd1306_command(0x80);
-    ssd1306_command(0x8D); ssd1306_command(0x14);
-    ssd1306_command(0xAF);
+    static const uint8_t init_seq[] = {
+        CTRL_CMD,
+        0xAE,
+        0xA8, 0x3F,
+        0xD3, 0x00,
+        0x40,
+        0xA1,
+        0xC8,
+        0xDA, 0x12,
+        0x81, 0x7F,
+        0xA4,
+        0xA6,
+        0xD5, 0x80,
+        0x8D, 0x14,
+        0x20, 0x00, // endereçamento horizontal (janelas 0x21/0x22)
+        0xAF,
+    };
+    // também deixa IC_TAR apontando para o display, usado depois pelo DMA
+    ssd1306_commands(init_seq, sizeof(init_seq));
+
+    if (dma_data < 0) ssd1306_dma_init();
 
+    shadow_valid = false;
     ssd1306_clear();
     ssd1306_show();
 }
 
 void ssd1306_clear(void) {
     memset(buffer, 0, sizeof(buffer));
+    for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+        mark_dirty(page, 0, SSD1306_WIDTH - 1);
+    }
+}
+
+void ssd1306_set_done_callback(ssd1306_done_cb_t cb, void *arg) {
+    done_cb = cb;
+    done_arg = arg;
+}
+
+bool ssd1306_busy(void) {
+    return busy;
+}
+
+/**
+ * @brief Acrescenta à lista do DMA a janela x0..x1 da página e copia para a sombra.
+ */
+static size_t queue_run(size_t n, uint8_t run, uint8_t page, uint8_t x0, uint8_t x1) {
+    const uint16_t *row = &buffer[SSD1306_WIDTH * page];
+    uint8_t *sh = &shadow[SSD1306_WIDTH * page];
+
+    uint16_t *cw = cmd_words[run];
+    cw[0] = CTRL_CMD;
+    cw[1] = 0x21; cw[2] = x0;   cw[3] = x1;                  // colunas
+    cw[4] = 0x22; cw[5] = page; cw[6] = (uint16_t)(page | WORD_STOP); // página
+    cb_list[n++] = (dma_cb_t){ 7, cw };
+
+    cb_list[n++] = (dma_cb_t){ 1, &data_hdr };
+    if (x1 > x0) {
+        cb_list[n++] = (dma_cb_t){ (uint32_t)(x1 - x0), &row[x0] };
+    }
+    last_word[run] = (uint16_t)(row[x1] | WORD_STOP);
+    cb_list[n++] = (dma_cb_t){ 1, &last_word[run] };
+
+    for (uint8_t x = x0; x <= x1; x++) sh[x] = (uint8_t)row[x];
+    return n;
+}
+
+bool ssd1306_show_start(void) {
+    if (busy) return false;
+
+    uint32_t bytes = 0;
+    uint8_t pages = 0;
+    uint8_t runs = 0;
+    size_t n = 0;
+
+    for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+        uint8_t x0 = dirty_x0[page];
+        uint8_t x1 = dirty_x1[page];
+        mark_clean(page);
+        if (x0 > x1) continue;
+
+        // descarta bordas que não mudaram em relação ao painel
+        const uint16_t *row = &buffer[SSD1306_WIDTH * page];
+        const uint8_t *sh = &shadow[SSD1306_WIDTH * page];
+        if (shadow_valid) {
+            while (x0 <= x1 && (uint8_t)row[x0] == sh[x0]) x0++;
+            while (x1 > x0 && (uint8_t)row[x1] == sh[x1]) x1--;
+            if (x0 > x1) continue;
+        }
+
+        // divide em trechos nas lacunas longas de colunas iguais ao painel
+        // (ex.: gráfico deslocado: só as colunas em que a curva muda de altura)
+        uint8_t page_runs = 0;
+        uint16_t x = x0;
+        while (x <= x1) {
+            uint8_t a = (uint8_t)x, b = (uint8_t)x;
+            uint8_t same = 0;
+            for (x = a + 1u; x <= x1; x++) {
+                if (!shadow_valid || (uint8_t)row[x] != sh[x]) {
+                    b = (uint8_t)x;
+                    same = 0;
+                } else if (++same > SSD1306_RUN_GAP && page_runs + 1u < SSD1306_MAX_RUNS) {
+                    break;
+                }
+            }
+
+            n = queue_run(n, runs++, page, a, b);
+            page_runs++;
+            bytes += 8 + 1 + (uint32_t)(b - a + 1) + 1; // 2 transações: endereço + payload
+
+            while (x <= x1 && (uint8_t)row[x] == sh[x]) x++;
+        }
+        pages++;
+    }
+    shadow_valid = true;
+
+    last_stats.bytes = bytes;
+    last_stats.pages = pages;
+    if (n == 0) {
+        last_stats.us = 0;
+        return false;
+    }
+
+    cb_list[n] = (dma_cb_t){ 0, NULL }; // bloco nulo: encerra e gera IRQ
+
+    busy = true;
+    t_start = time_us_32();
+    dma_channel_set_read_addr((uint)dma_ctrl, cb_list, true);
+    return true;
+}
+
+void ssd1306_show_abort(void) {
+    // abortar pode gerar a IRQ de fim mesmo assim (RP2040-E13): desliga a IRQ do canal
+    // durante o abort e descarta o pendente, para não chegar um "done" atrasado no
+    // meio do próximo quadro
+    dma_channel_set_irq1_enabled((uint)dma_data, false);
+    dma_channel_abort((uint)dma_ctrl);
+    dma_channel_abort((uint)dma_data);
+    dma_channel_acknowledge_irq1((uint)dma_data);
+    dma_channel_set_irq1_enabled((uint)dma_data, true);
+
+    // o canal de controle pode ter parado no meio do par (count, addr): volta o anel de
+    // escrita para al3_transfer_count, senão o próximo bloco cai no registrador errado
+    dma_channel_set_write_addr((uint)dma_ctrl, &dma_hw->ch[dma_data].al3_transfer_count, false);
+    dma_channel_set_trans_count((uint)dma_ctrl, 2, false);
+
+    (void)i2c_get_hw(ssd_i2c)->clr_tx_abrt;
+    busy = false;
+    shadow_valid = false; // estado do painel desconhecido: próximo quadro envia tudo
+    for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+        mark_dirty(page, 0, SSD1306_WIDTH - 1);
+    }
 }
 
 void ssd1306_show(void) {
-    for (uint8_t page = 0; page < 8; page++) {
-        ssd1306_command(0xB0 + page);
-        ssd1306_command(0x00);
-        ssd1306_command(0x10);
-        ssd1306_data(&buffer[SSD1306_WIDTH * page], SSD1306_WIDTH);
+    if (!ssd1306_show_start()) return;
+    uint32_t t0 = time_us_32();
+    while (busy) {
+        // NACK (display ausente) aborta o I2C sem gerar a IRQ de fim
+        if ((time_us_32() - t0) > SSD1306_SHOW_TIMEOUT_US) {
+            ssd1306_show_abort();
+            return;
+        }
+        tight_loop_contents();
     }
 }
 
+void ssd1306_get_stats(ssd1306_stats_t *out) {
+    if (out) *out = last_stats;
+}
+
 void ssd1306_draw_pixel(uint8_t x, uint8_t y, bool color) {
     if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) return;
+    uint16_t *b = &buffer[x + (y / 8) * SSD1306_WIDTH];
+    uint16_t old = *b;
     if (color)
-        buffer[x + (y / 8) * SSD1306_WIDTH] |= (1 << (y % 8));
+        *b |= (1 << (y % 8));
     else
-        buffer[x + (y / 8) * SSD1306_WIDTH] &= ~(1 << (y % 8));
+        *b &= ~(1 << (y % 8));
+    if (*b != old) mark_dirty(y / 8, x, x);
 }
 
-void ssd1306_draw_string(uint8_t x, uint8_t y, const char *text) {
-    while (*text) {
-        char c = *text++;
-        if (c < 32 || c > 126) c = '?';
-        for (uint8_t i = 0; i < 5; i++) {
-            uint8_t line = font6x8[(c - 32) * 5 + i];
-            for (uint8_t j = 0; j < 8; j++) {
-                bool pixel = line & (1 << j);
-                ssd1306_draw_pixel(x + i, y + j, pixel);
+void ssd1306_clear_pages(uint8_t page0, uint8_t page1) {
+    if (page1 >= SSD1306_PAGES) page1 = SSD1306_PAGES - 1;
+    for (uint8_t page = page0; page <= page1; page++) {
+        memset(&buffer[page * SSD1306_WIDTH], 0, SSD1306_WIDTH * sizeof(buffer[0]));
+        mark_dirty(page, 0, SSD1306_WIDTH - 1);
+    }
+}
+
+void ssd1306_scroll_left(uint8_t page0, uint8_t page1) {
+    if (page1 >= SSD1306_PAGES) page1 = SSD1306_PAGES - 1;
+    for (uint8_t page = page0; page <= page1; page++) {
+        uint16_t *row = &buffer[page * SSD1306_WIDTH];
+        // só as colunas que mudam de valor ficam sujas (trechos planos/vazios não saem)
+        for (uint8_t x = 0; x < SSD1306_WIDTH - 1; x++) {
+            if (row[x] != row[x + 1]) {
+                row[x] = row[x + 1];
+                mark_dirty(page, x, x);
             }
         }
+        if (row[SSD1306_WIDTH - 1]) {
+            row[SSD1306_WIDTH - 1] = 0;
+            mark_dirty(page, SSD1306_WIDTH - 1, SSD1306_WIDTH - 1);
+        }
+    }
+}
+
+void ssd1306_draw_vline(uint8_t x, uint8_t y0, uint8_t y1) {
+    if (y0 > y1) { uint8_t t = y0; y0 = y1; y1 = t; }
+    for (uint8_t y = y0; y <= y1; y++) {
+        ssd1306_draw_pixel(x, y, true);
+    }
+}
+
+// Escreve 8 linhas de uma coluna a partir de y (sobrescreve, como o desenho por pixel).
+// y % 8 == 0: 1 byte; caso contrário, parte baixa na página y/8 e alta na seguinte.
+static inline void blit_column(uint8_t x, uint8_t y, uint8_t bits) {
+    uint8_t page = y / 8;
+    uint8_t s = y % 8;
+    uint16_t *b = &buffer[x + page * SSD1306_WIDTH];
+
+    uint16_t lo_mask = (uint16_t)(0xFFu << s) & 0xFFu;
+    uint16_t v = (uint16_t)((*b & ~lo_mask) | (((uint16_t)bits << s) & lo_mask));
+    if (v != *b) { *b = v; mark_dirty(page, x, x); }
+
+    if (s == 0 || page + 1 >= SSD1306_PAGES) return;
+
+    b += SSD1306_WIDTH;
+    uint16_t hi_mask = (uint16_t)(0xFFu >> (8 - s));
+    v = (uint16_t)((*b & ~hi_mask) | ((bits >> (8 - s)) & hi_mask));
+    if (v != *b) { *b = v; mark_dirty(page + 1, x, x); }
+}
+
+static inline void draw_char(uint8_t x, uint8_t y, char c) {
+    if (c < 32 || c > 126) c = '?';
+    const uint8_t *glyph = &font6x8[(c - 32) * 5];
+    for (uint8_t i = 0; i < 5 && x + i < SSD1306_WIDTH; i++) {
+        blit_column(x + i, y, glyph[i]);
+    }
+}
+
+void ssd1306_draw_string(uint8_t x, uint8_t y, const char *text) {
+    if (y >= SSD1306_HEIGHT) return;
+    while (*text && x < SSD1306_WIDTH) {
+        draw_char(x, y, *text++);
+        if (x > SSD1306_WIDTH - 6) break;
         x += 6;
     }
 }
+
+// -------------------------
+// Camada de texto retida: só redesenha caracteres que mudaram
+// -------------------------
+void ssd1306_field_init(ssd1306_field_t *f, uint8_t x, uint8_t y, uint8_t width_chars) {
+    if (width_chars > SSD1306_FIELD_MAX_CHARS) width_chars = SSD1306_FIELD_MAX_CHARS;
+    f->x = x;
+    f->y = y;
+    f->width = width_chars;
+    f->valid = false;
+    memset(f->text, ' ', sizeof(f->text));
+}
+
+void ssd1306_field_set(ssd1306_field_t *f, const char *text) {
+    // completa com espaços para apagar sobras de um texto anterior mais longo
+    for (uint8_t i = 0; i < f->width; i++) {
+        char c = *text ? *text++ : ' ';
+        if (f->valid && f->text[i] == c) continue;
+        f->text[i] = c;
+        draw_char((uint8_t)(f->x + i * 6), f->y, c);
+    }
+    f->valid = true;
+}
+
+void ssd1306_field_invalidate(ssd1306_field_t *f) {
+    f->valid = false;
+}
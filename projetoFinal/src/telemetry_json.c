@@ -0,0 +1,56 @@
+#include "telemetry_json.h"
+
+#include <string.h>
+
+#include "matrix_control.h"
+
+/** Nomes na ordem dos bits TELE_F_*. */
+static const char *const k_field_names[] = {
+    "device", "lux", "luxPercLum", "temp", "hum", "seq", "t_ms", "mode", "target", "current"
+};
+
+void telemetry_json_write(json_writer_t *w, const char *op, const char *device_id, const sensor_frame_t *fr)
+{
+    telemetry_json_write_fields(w, op, device_id, fr, TELE_F_ALL);
+}
+
+void telemetry_json_write_fields(json_writer_t *w, const char *op, const char *device_id,
+                                 const sensor_frame_t *fr, uint16_t fields)
+{
+    json_w_begin(w);
+    if (op) json_w_str(w, "op", op);
+    if (fields & TELE_F_DEVICE) json_w_str(w, "device", device_id);
+
+    if (fields & TELE_F_LUX)      json_w_fixed(w, "lux",        fr->lux,        2);
+    if (fields & TELE_F_LUX_PERC) json_w_fixed(w, "luxPercLum", fr->luxPercLum, 1);
+    if (fields & TELE_F_TEMP)     json_w_fixed(w, "temp",       fr->temp,       2);
+    if (fields & TELE_F_HUM)      json_w_fixed(w, "hum",        fr->hum,        2);
+
+    if (fields & TELE_F_SEQ)  json_w_uint(w, "seq",  fr->seq);
+    if (fields & TELE_F_T_MS) json_w_uint(w, "t_ms", (uint32_t)pdTICKS_TO_MS(fr->tick));
+
+    // estado da luminária do próprio frame (não o atual): o texto depende só de fr
+    if (fields & TELE_F_MODE)    json_w_str(w, "mode", (fr->mode == MATRIX_MODE_AUTO) ? "auto" : "manual");
+    if (fields & TELE_F_TARGET)  json_w_uint(w, "target",  fr->target);
+    if (fields & TELE_F_CURRENT) json_w_uint(w, "current", fr->current);
+    json_w_end(w);
+}
+
+uint16_t telemetry_json_field(const char *name, size_t len)
+{
+    for (size_t i = 0; i < sizeof(k_field_names) / sizeof(k_field_names[0]); i++) {
+        if (strlen(k_field_names[i]) == len && memcmp(k_field_names[i], name, len) == 0) {
+            return (uint16_t)(1u << i);
+        }
+    }
+    return 0;
+}
+
+void telemetry_json_write_field_names(json_writer_t *w, const char *key, uint16_t fields)
+{
+    json_w_begin_arr(w, key);
+    for (size_t i = 0; i < sizeof(k_field_names) / sizeof(k_field_names[0]); i++) {
+        if (fields & (1u << i)) json_w_str(w, NULL, k_field_names[i]);
+    }
+    json_w_end_arr(w);
+}
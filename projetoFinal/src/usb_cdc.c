@@ -0,0 +1,147 @@
+#include "usb_cdc.h"
+
+#include "pico/stdlib.h"
+#include "pico/stdio/driver.h"
+#include "pico/bootrom.h"
+
+#include "tusb.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "app_config.h"
+
+#define ITF_RPC 0u
+#define ITF_LOG 1u
+
+static void (*g_rx_cb)(void *param);
+static void *g_rx_param;
+static volatile bool g_rpc_connect;
+static volatile uint32_t g_rpc_tx_drop;
+static volatile uint32_t g_log_tx_drop;
+
+// ------------------------------------------------------------
+// Callbacks do TinyUSB (contexto da vTaskUsb)
+// ------------------------------------------------------------
+void tud_cdc_rx_cb(uint8_t itf)
+{
+    if (itf == ITF_RPC && g_rx_cb) g_rx_cb(g_rx_param);
+}
+
+void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts)
+{
+    (void)rts;
+    if (itf == ITF_RPC && dtr) {
+        g_rpc_connect = true;
+        if (g_rx_cb) g_rx_cb(g_rx_param);
+    }
+}
+
+void tud_cdc_line_coding_cb(uint8_t itf, cdc_line_coding_t const *coding)
+{
+    // "1200 baud touch" (como o pico_stdio_usb): reinicia no bootloader USB
+    if (itf == ITF_RPC && coding->bit_rate == 1200u) {
+        reset_usb_boot(0, 0);
+    }
+}
+
+// ------------------------------------------------------------
+// Canal de log: driver de stdio (nunca bloqueia)
+// ------------------------------------------------------------
+static void log_out_chars(const char *buf, int len)
+{
+    if (len <= 0) return;
+
+    if (!tud_cdc_n_connected(ITF_LOG)) {
+        g_log_tx_drop += (uint32_t)len;
+        return;
+    }
+
+    uint32_t n = tud_cdc_n_write(ITF_LOG, buf, (uint32_t)len);
+    if (n < (uint32_t)len) g_log_tx_drop += (uint32_t)len - n;
+    tud_cdc_n_write_flush(ITF_LOG);
+}
+
+static void log_out_flush(void)
+{
+    tud_cdc_n_write_flush(ITF_LOG);
+}
+
+static stdio_driver_t g_log_driver = {
+    .out_chars = log_out_chars,
+    .out_flush = log_out_flush,
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+    .crlf_enabled = PICO_STDIO_DEFAULT_CRLF,
+#endif
+};
+
+// ------------------------------------------------------------
+// API
+// ------------------------------------------------------------
+void usb_cdc_init(void)
+{
+    tusb_init();
+    stdio_set_driver_enabled(&g_log_driver, true);
+}
+
+void vTaskUsb(void *pvParameters)
+{
+    (void)pvParameters;
+    for (;;) {
+        tud_task();   // bloqueia na fila de eventos do TinyUSB
+    }
+}
+
+void usb_rpc_set_rx_callback(void (*fn)(void *param), void *param)
+{
+    g_rx_param = param;
+    g_rx_cb = fn;
+}
+
+int usb_rpc_getc(void)
+{
+    uint8_t c;
+    if (!tud_cdc_n_available(ITF_RPC) || tud_cdc_n_read(ITF_RPC, &c, 1) != 1) return -1;
+    return c;
+}
+
+size_t usb_rpc_write(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    size_t done = 0;
+    TickType_t t0 = xTaskGetTickCount();
+
+    while (done < len) {
+        if (!tud_cdc_n_connected(ITF_RPC)) break;
+
+        uint32_t n = tud_cdc_n_write(ITF_RPC, p + done, (uint32_t)(len - done));
+        done += n;
+        if (done == len) break;
+
+        // FIFO cheia: manda o que tem e espera o host drenar
+        tud_cdc_n_write_flush(ITF_RPC);
+        if ((xTaskGetTickCount() - t0) >= pdMS_TO_TICKS(APP_USB_RPC_TX_TIMEOUT_MS)) break;
+        vTaskDelay(1);
+    }
+
+    if (done < len) g_rpc_tx_drop += (uint32_t)(len - done);
+    return done;
+}
+
+void usb_rpc_flush(void)
+{
+    tud_cdc_n_write_flush(ITF_RPC);
+}
+
+bool usb_rpc_take_connect(void)
+{
+    if (!g_rpc_connect) return false;
+    g_rpc_connect = false;
+    return true;
+}
+
+void usb_cdc_get_stats(usb_cdc_stats_t *out)
+{
+    out->rpc_tx_drop = g_rpc_tx_drop;
+    out->log_tx_drop = g_log_tx_drop;
+}
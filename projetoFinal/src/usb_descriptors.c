@@ -0,0 +1,110 @@
+#include <string.h>
+
+#include "pico/unique_id.h"
+
+#include "tusb.h"
+
+#include "app_config.h"
+
+// Descritores do dispositivo composto: CDC 0 = SerialRPC, CDC 1 = Log (com IAD).
+enum {
+    ITF_NUM_CDC_RPC = 0,
+    ITF_NUM_CDC_RPC_DATA,
+    ITF_NUM_CDC_LOG,
+    ITF_NUM_CDC_LOG_DATA,
+    ITF_NUM_TOTAL
+};
+
+#define EPNUM_CDC_RPC_NOTIF  0x81
+#define EPNUM_CDC_RPC_OUT    0x02
+#define EPNUM_CDC_RPC_IN     0x82
+#define EPNUM_CDC_LOG_NOTIF  0x83
+#define EPNUM_CDC_LOG_OUT    0x04
+#define EPNUM_CDC_LOG_IN     0x84
+
+#define CONFIG_TOTAL_LEN     (TUD_CONFIG_DESC_LEN + 2 * TUD_CDC_DESC_LEN)
+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_CDC_RPC,
+    STRID_CDC_LOG
+};
+
+static const tusb_desc_device_t k_desc_device = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+    // composto com IAD (uma associação por CDC)
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor           = APP_USB_VID,
+    .idProduct          = APP_USB_PID,
+    .bcdDevice          = APP_USB_BCD_DEVICE,
+    .iManufacturer      = STRID_MANUFACTURER,
+    .iProduct           = STRID_PRODUCT,
+    .iSerialNumber      = STRID_SERIAL,
+    .bNumConfigurations = 1
+};
+
+static const uint8_t k_desc_config[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_RPC, STRID_CDC_RPC, EPNUM_CDC_RPC_NOTIF, 8,
+                       EPNUM_CDC_RPC_OUT, EPNUM_CDC_RPC_IN, CFG_TUD_CDC_EP_BUFSIZE),
+
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_LOG, STRID_CDC_LOG, EPNUM_CDC_LOG_NOTIF, 8,
+                       EPNUM_CDC_LOG_OUT, EPNUM_CDC_LOG_IN, CFG_TUD_CDC_EP_BUFSIZE),
+};
+
+static const char *const k_strings[] = {
+    [STRID_MANUFACTURER] = "BitDogLab",
+    [STRID_PRODUCT]      = "projetoFinal",
+    [STRID_SERIAL]       = NULL,           // id único da placa
+    [STRID_CDC_RPC]      = "SerialRPC",
+    [STRID_CDC_LOG]      = "Log",
+};
+
+const uint8_t *tud_descriptor_device_cb(void)
+{
+    return (const uint8_t*)&k_desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index)
+{
+    (void)index;
+    return k_desc_config;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+    (void)langid;
+    static uint16_t desc[32 + 1];
+    size_t n;
+
+    if (index == STRID_LANGID) {
+        desc[1] = 0x0409;   // inglês (EUA)
+        n = 1;
+    } else {
+        if (index >= sizeof(k_strings) / sizeof(k_strings[0])) return NULL;
+
+        char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+        const char *s = k_strings[index];
+        if (index == STRID_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            s = serial;
+        }
+        if (!s) return NULL;
+
+        n = strlen(s);
+        if (n > 32) n = 32;
+        for (size_t i = 0; i < n; i++) desc[1 + i] = (uint8_t)s[i];
+    }
+
+    desc[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2u * n + 2u));
+    return desc;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file backoff_sim.cpp
+ * @brief Simula a reconexão de uma frota após reinício do broker (mesmo backoff.c do firmware).
+ *
+ * Uso: backoff_sim [nós] [aceites/s] [janela_ms] [saida.csv]
+ *      padrão: 10000 nós, broker aceita 500 conexões/s, janela 10000 ms
+ *
+ * Modelo: em t=0 o broker reinicia e todos os nós perdem a sessão juntos. O broker
+ * aceita no máximo `aceites/s` (balde de fichas, rajada de 0,1 s); tentativas além
+ * disso falham e o nó só percebe após kFailMs (timeout de connect).
+ * Políticas comparadas:
+ *  - fixed:   o laço antigo (tentativa imediata e depois a cada 3 s, fase do laço de 200 ms);
+ *  - backoff: backoff_t com janela + exponencial com full jitter, semente = id aleatório
+ *             de 8 bytes por nó (como pico_get_unique_board_id).
+ *
+ * CSV (um ponto a cada 100 ms): t_s, tentativas/s, aceites/s e conectados de cada
+ * política; resumo (pico, tempo até 50/99/100%, tentativas totais) em stderr.
+ *
+ * Compilação (a partir de projetoFinal/tools):
+ *   gcc -O2 -c -I../include ../src/backoff.c -o backoff.o
+ *   g++ -std=c++17 -O2 -I../include backoff_sim.cpp backoff.o -o backoff_sim
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "backoff.h"
+
+namespace {
+
+constexpr uint32_t kFailMs    = 1000;     ///< tentativa recusada: nó percebe após o timeout
+constexpr uint32_t kFixedMs   = 3000;     ///< intervalo fixo do laço antigo
+constexpr uint32_t kLoopMs    = 200;      ///< granularidade do laço da vTaskMqtt
+constexpr uint32_t kBucketMs  = 100;      ///< resolução do CSV
+constexpr uint32_t kHorizonMs = 600000;   ///< desiste após 10 min simulados
+
+struct Curve {
+    std::vector<uint32_t> attempts, ok;   ///< por intervalo de kBucketMs
+    uint32_t total_attempts = 0;
+    uint32_t t50 = 0, t99 = 0, t100 = 0;
+    uint32_t peak = 0;                    ///< maior número de tentativas em um intervalo
+};
+
+/**
+ * @brief Simulação por eventos: fila de (instante, nó) em ordem de tempo.
+ */
+Curve simulate(uint32_t nodes, double accept_per_s, const std::function<uint32_t(uint32_t)> &first,
+               const std::function<uint32_t(uint32_t)> &after_fail)
+{
+    using Ev = std::pair<uint32_t, uint32_t>;   // (t_ms, nó)
+    std::priority_queue<Ev, std::vector<Ev>, std::greater<Ev>> q;
+    for (uint32_t n = 0; n < nodes; n++) q.push({first(n), n});
+
+    Curve c;
+    c.attempts.assign(kHorizonMs / kBucketMs + 1, 0);
+    c.ok.assign(kHorizonMs / kBucketMs + 1, 0);
+
+    const double burst = std::max(1.0, accept_per_s * 0.1);
+    double tokens = burst;
+    uint32_t t_last = 0, connected = 0;
+
+    while (!q.empty()) {
+        auto [t, n] = q.top();
+        q.pop();
+        if (t > kHorizonMs) break;
+
+        tokens = std::min(burst, tokens + accept_per_s * (t - t_last) / 1000.0);
+        t_last = t;
+
+        uint32_t b = t / kBucketMs;
+        c.attempts[b]++;
+        c.total_attempts++;
+
+        if (tokens >= 1.0) {
+            tokens -= 1.0;
+            c.ok[b]++;
+            connected++;
+            if (!c.t50  && connected * 2 >= nodes)     c.t50 = t;
+            if (!c.t99  && connected * 100 >= nodes * 99u) c.t99 = t;
+            if (connected == nodes) c.t100 = t;
+        } else {
+            q.push({t + kFailMs + after_fail(n), n});
+        }
+    }
+    for (uint32_t a : c.attempts) c.peak = std::max(c.peak, a);
+    return c;
+}
+
+void summary(const char *name, const Curve &c, uint32_t nodes)
+{
+    char t100[16] = "nao";
+    if (c.t100) std::snprintf(t100, sizeof(t100), "%.1fs", c.t100 / 1000.0);
+
+    std::fprintf(stderr, "%-8s pico=%u tent/%ums (%.0f/s) tentativas=%u (%.2f por no) "
+                         "50%%=%.1fs 99%%=%.1fs 100%%=%s\n",
+                 name, c.peak, kBucketMs, c.peak * 1000.0 / kBucketMs, c.total_attempts,
+                 static_cast<double>(c.total_attempts) / nodes, c.t50 / 1000.0, c.t99 / 1000.0, t100);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const uint32_t nodes  = (argc > 1) ? static_cast<uint32_t>(std::atoi(argv[1])) : 10000u;
+    const double   accept = (argc > 2) ? std::atof(argv[2]) : 500.0;
+    const uint32_t window = (argc > 3) ? static_cast<uint32_t>(std::atoi(argv[3])) : 10000u;
+    const char    *out    = (argc > 4) ? argv[4] : nullptr;
+
+    std::mt19937 rng(12345);
+
+    // --- política antiga: imediato e a cada 3 s (fase aleatória do laço de 200 ms) ---
+    std::vector<uint32_t> phase(nodes);
+    for (auto &p : phase) p = rng() % kLoopMs;
+    Curve fixed = simulate(nodes, accept,
+                           [&](uint32_t n) { return phase[n]; },
+                           [&](uint32_t)   { return kFixedMs - kFailMs; });
+
+    // --- backoff.c: uma instância por nó, semeada por um "id de placa" aleatório ---
+    std::vector<backoff_t> bo(nodes);
+    for (auto &b : bo) {
+        uint8_t id[8];
+        for (auto &x : id) x = static_cast<uint8_t>(rng());
+        backoff_init(&b, 1000u, 60000u, window, backoff_seed(id, sizeof(id)));
+    }
+    Curve jit = simulate(nodes, accept,
+                         [&](uint32_t n) { return backoff_next_ms(&bo[n]); },
+                         [&](uint32_t n) { return backoff_next_ms(&bo[n]); });
+
+    std::fprintf(stderr, "nos=%u broker=%.0f conexoes/s janela=%ums\n", nodes, accept, window);
+    summary("fixed", fixed, nodes);
+    summary("backoff", jit, nodes);
+
+    FILE *f = out ? std::fopen(out, "w") : stdout;
+    if (!f) { std::perror(out); return 1; }
+    std::fprintf(f, "t_s,fixed_attempts_s,fixed_ok_s,fixed_connected,backoff_attempts_s,backoff_ok_s,backoff_connected\n");
+
+    uint32_t end = std::max(fixed.t100 ? fixed.t100 : kHorizonMs, jit.t100 ? jit.t100 : kHorizonMs);
+    uint32_t cf = 0, cj = 0;
+    const double k = 1000.0 / kBucketMs;
+    for (uint32_t b = 0; b * kBucketMs <= end && b < fixed.attempts.size(); b++) {
+        cf += fixed.ok[b];
+        cj += jit.ok[b];
+        std::fprintf(f, "%.1f,%.0f,%.0f,%u,%.0f,%.0f,%u\n", b * kBucketMs / 1000.0,
+                     fixed.attempts[b] * k, fixed.ok[b] * k, cf, jit.attempts[b] * k, jit.ok[b] * k, cj);
+    }
+    if (out) std::fclose(f);
+    return 0;
+}
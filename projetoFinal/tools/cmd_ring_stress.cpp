@@ -0,0 +1,216 @@
+/**
+ * @file cmd_ring_stress.cpp
+ * @brief Estresse no host da fila SPSC de comandos (src/cmd_ring.c) com dois threads.
+ *
+ * Uso: cmd_ring_stress [rodadas] [comandos/rodada] [semente]   (padrão: 2000, 2000, 1)
+ *
+ * Em cada rodada um thread produtor empurra uma lista aleatória de comandos (modo,
+ * percent geral, percent por canal, canal inválido, modo + percent) em rajadas, e o
+ * consumidor retira com pausas aleatórias, forçando a fila a encher e o overflow a
+ * fundir. Verifica:
+ *  - estado final do consumidor == aplicar a lista inteira em ordem (último valor vence);
+ *  - todo estado do consumidor fora de uma expansão de overflow é o estado de algum
+ *    prefixo da lista, em ordem crescente (nada reaplicado nem fora de ordem);
+ *  - pushed + coalesced == comandos empurrados.
+ * Antes, o caso fixo da revisão: fila cheia, {"percent":50} e {"mode":"auto"} no
+ * overflow tem de terminar em AUTO.
+ *
+ * Compilação (a partir de projetoFinal/tools; host/ substitui hardware/sync.h e i2c.h):
+ *   gcc -O2 -c -Ihost -I../include ../src/cmd_ring.c -o cmd_ring.o
+ *   g++ -std=c++17 -O2 -pthread -Ihost -I../include cmd_ring_stress.cpp cmd_ring.o -o cmd_ring_stress
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cmd_ring.h"
+
+namespace {
+
+struct State {
+    uint8_t mode = MATRIX_MODE_AUTO;
+    uint8_t pct[APP_LUM_CHANNEL_COUNT] = {};
+
+    bool operator==(const State &o) const
+    {
+        return mode == o.mode && std::memcmp(pct, o.pct, sizeof(pct)) == 0;
+    }
+};
+
+/**
+ * @brief Mesma semântica de matrix_control_apply_cmd() (canal inválido recusa tudo;
+ *        modo, percent, força MANUAL).
+ */
+void apply(State &s, const matrix_cmd_t &c)
+{
+    if ((c.flags & MATRIX_CMD_F_CHANNEL) && (c.channel < 0 || c.channel >= static_cast<int>(APP_LUM_CHANNEL_COUNT))) {
+        return;
+    }
+    if (c.flags & MATRIX_CMD_F_MODE) s.mode = c.mode;
+
+    if (c.flags & MATRIX_CMD_F_PERCENT) {
+        uint8_t p = (c.percent < 0) ? 0 : (c.percent > 100) ? 100 : static_cast<uint8_t>(c.percent);
+        if (c.flags & MATRIX_CMD_F_CHANNEL) {
+            s.pct[c.channel] = p;
+        } else {
+            for (auto &x : s.pct) x = p;
+        }
+        s.mode = MATRIX_MODE_MANUAL;
+    }
+}
+
+matrix_cmd_t random_cmd(std::mt19937 &rng)
+{
+    matrix_cmd_t c{};
+    switch (rng() % 5) {
+    case 0:
+        c.flags = MATRIX_CMD_F_MODE;
+        c.mode = (rng() & 1u) ? MATRIX_MODE_AUTO : MATRIX_MODE_MANUAL;
+        break;
+    case 1:
+        c.flags = MATRIX_CMD_F_PERCENT;
+        c.percent = static_cast<int32_t>(rng() % 140) - 20;   // inclui fora da faixa
+        break;
+    case 2:
+        c.flags = MATRIX_CMD_F_PERCENT | MATRIX_CMD_F_CHANNEL;
+        c.channel = static_cast<int16_t>(rng() % APP_LUM_CHANNEL_COUNT);
+        c.percent = static_cast<int32_t>(rng() % 101);
+        break;
+    case 3:
+        c.flags = MATRIX_CMD_F_MODE | MATRIX_CMD_F_PERCENT | MATRIX_CMD_F_CHANNEL;
+        c.mode = MATRIX_MODE_AUTO;
+        c.channel = static_cast<int16_t>(APP_LUM_CHANNEL_COUNT + rng() % 3);  // inválido: nada muda
+        c.percent = 77;
+        break;
+    default:
+        c.flags = MATRIX_CMD_F_MODE | MATRIX_CMD_F_PERCENT;
+        c.mode = MATRIX_MODE_AUTO;
+        c.percent = static_cast<int32_t>(rng() % 101);
+        break;
+    }
+    return c;
+}
+
+bool pend_empty(const cmd_ring_t &r)
+{
+    return r.pend.pct_mask == 0 && !r.pend.has_mode;
+}
+
+int fixed_case()
+{
+    cmd_ring_t r;
+    cmd_ring_init(&r);
+    State s;
+
+    matrix_cmd_t fill{};
+    fill.flags = MATRIX_CMD_F_MODE;
+    fill.mode = MATRIX_MODE_MANUAL;
+    for (uint32_t i = 0; i < APP_CMD_RING_LEN; i++) cmd_ring_push(&r, &fill);
+
+    matrix_cmd_t pct{};
+    pct.flags = MATRIX_CMD_F_PERCENT;
+    pct.percent = 50;
+    matrix_cmd_t aut{};
+    aut.flags = MATRIX_CMD_F_MODE;
+    aut.mode = MATRIX_MODE_AUTO;
+    bool in_ring = cmd_ring_push(&r, &pct) || cmd_ring_push(&r, &aut);
+
+    matrix_cmd_t c;
+    while (cmd_ring_pop(&r, &c)) apply(s, c);
+
+    bool ok = !in_ring && s.mode == MATRIX_MODE_AUTO && s.pct[0] == 50 && r.coalesced == 2;
+    std::printf("caso fixo (percent 50 -> mode auto no overflow): %s\n", ok ? "OK" : "FALHOU");
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const int rounds = (argc > 1) ? std::atoi(argv[1]) : 2000;
+    const int n      = (argc > 2) ? std::atoi(argv[2]) : 2000;
+    const unsigned seed = (argc > 3) ? static_cast<unsigned>(std::atoi(argv[3])) : 1u;
+
+    if (fixed_case()) return 1;
+
+    std::mt19937 rng(seed);
+    uint64_t total_pushed = 0, total_coalesced = 0, checks = 0;
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < rounds; round++) {
+        std::vector<matrix_cmd_t> cmds(n);
+        for (auto &c : cmds) c = random_cmd(rng);
+
+        // estado após cada prefixo (ref[k] = depois de k comandos)
+        std::vector<State> ref(n + 1);
+        for (int k = 0; k < n; k++) {
+            ref[k + 1] = ref[k];
+            apply(ref[k + 1], cmds[k]);
+        }
+
+        cmd_ring_t ring;
+        cmd_ring_init(&ring);
+        std::atomic<bool> done{false};
+        unsigned pseed = rng(), cseed = rng();
+
+        std::thread producer([&] {
+            std::mt19937 r(pseed);
+            for (int k = 0; k < n; k++) {
+                cmd_ring_push(&ring, &cmds[k]);
+                if (r() % 8 == 0) std::this_thread::yield();   // rajadas
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        std::mt19937 r(cseed);
+        State s;
+        int k = 0;   // menor prefixo ainda compatível
+        bool fail = false;
+        matrix_cmd_t c;
+
+        for (;;) {
+            bool finished = done.load(std::memory_order_acquire);
+            if (cmd_ring_pop(&ring, &c)) {
+                apply(s, c);
+                if (pend_empty(ring)) {
+                    while (k <= n && !(ref[k] == s)) k++;
+                    checks++;
+                    if (k > n) { fail = true; break; }
+                }
+                if (r() % 512 == 0) std::this_thread::sleep_for(std::chrono::microseconds(r() % 20));
+            } else if (!finished) {
+                std::this_thread::yield();
+            } else {
+                // produtor terminou: uma última volta esvazia reivindicação/overflow pendente
+                if (!cmd_ring_pop(&ring, &c)) break;
+                apply(s, c);
+                while (cmd_ring_pop(&ring, &c)) apply(s, c);
+                break;
+            }
+        }
+        producer.join();
+
+        if (fail || !(s == ref[n]) || ring.pushed + ring.coalesced != static_cast<uint32_t>(n)) {
+            std::printf("FALHA rodada %d: %s (pushed=%u coalesced=%u n=%d modo=%u/%u pct0=%u/%u)\n", round,
+                        fail ? "estado fora de ordem" : "estado final difere", ring.pushed, ring.coalesced, n,
+                        s.mode, ref[n].mode, s.pct[0], ref[n].pct[0]);
+            return 1;
+        }
+        total_pushed += ring.pushed;
+        total_coalesced += ring.coalesced;
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("OK: %d rodadas x %d comandos, %.0f cmd/s, fila=%llu fundidos=%llu (%.1f%%), %llu estados conferidos\n",
+                rounds, n, rounds * static_cast<double>(n) / secs, static_cast<unsigned long long>(total_pushed),
+                static_cast<unsigned long long>(total_coalesced),
+                100.0 * total_coalesced / (total_pushed + total_coalesced), static_cast<unsigned long long>(checks));
+    return 0;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file dispatch_bench.cpp
+ * @brief Benchmark no host do despacho de linhas do SerialRPC (dispatch.c + json_simple.c).
+ *
+ * Uso: dispatch_bench [linhas]      (padrão: 1000000)
+ *
+ * Primeiro confere as tabelas: cada nome de op/chave resolve para o próprio índice e
+ * prefixos, extensões, tokens com '\0' embutido e nomes desconhecidos dão -1. Depois despacha um fluxo de linhas
+ * típicas (ops variados, comandos com modo/percent/canal, op desconhecido) de dois jeitos:
+ *  - legacy: json_get_string("op") + cadeia de strcmp; no "cmd", uma varredura do texto
+ *    por chave (mode, matrixPercent, brightness, percent, channel), como antes;
+ *  - hash:   json_parse() uma vez, dispatch_lookup() no token "op" e uma passada pelos
+ *    membros com dispatch_lookup() por chave (caminho atual do firmware).
+ * Informa linhas/s, MB/s e a folga sobre a taxa de linha do USB CDC full-speed
+ * (~1 MB/s), e sai com 1 se os dois caminhos discordarem em alguma linha.
+ *
+ * As listas de nomes são cópias de SERIAL_RPC_OPS (serial_rpc.c) e k_key_names
+ * (matrix_control.c); mantenha-as na mesma ordem.
+ *
+ * Compilação (a partir de projetoFinal/tools):
+ *   gcc -O2 -c -I../include ../src/dispatch.c ../src/json_simple.c
+ *   g++ -std=c++17 -O2 -I../include dispatch_bench.cpp dispatch.o json_simple.o -o dispatch_bench
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dispatch.h"
+#include "json_simple.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const char *const kOps[] = { "hello", "logout", "auth", "cmd", "stats", "binary", "subscribe",
+                             "unsubscribe", "dump", "dump_credit", "dump_stop" };
+const char *const kKeys[] = { "mode", "matrixPercent", "brightness", "percent", "channel" };
+
+constexpr uint8_t kOpCount = sizeof(kOps) / sizeof(kOps[0]);
+constexpr uint8_t kKeyCount = sizeof(kKeys) / sizeof(kKeys[0]);
+
+dispatch_table_t g_ops;
+dispatch_table_t g_keys;
+int g_fail = 0;
+
+/** @brief Resultado do despacho de uma linha: op e campos de comando lidos. */
+struct Result {
+    int op = -1;            // índice em kOps, -1 desconhecido, -2 sem "op"
+    int mode = -1;          // 0 auto, 1 manual
+    int percent = -1;
+    int channel = -1;
+
+    bool operator==(const Result &o) const
+    {
+        return op == o.op && mode == o.mode && percent == o.percent && channel == o.channel;
+    }
+};
+
+void check(bool ok, const char *what, const char *name)
+{
+    if (!ok) {
+        std::printf("FALHA %s: \"%s\"\n", what, name);
+        g_fail++;
+    }
+}
+
+void check_table(const dispatch_table_t &t, const char *const *names, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        const char *n = names[i];
+        size_t len = std::strlen(n);
+        check(dispatch_lookup(&t, n, len) == i, "nome", n);
+        // prefixo só casa se for outro nome da lista ("dump" de "dump_credit")
+        int p = dispatch_lookup(&t, n, len - 1);
+        check(p < 0 || (std::strlen(names[p]) == len - 1 && std::strncmp(names[p], n, len - 1) == 0), "prefixo", n);
+
+        std::string ext = std::string(n) + "_";
+        check(dispatch_lookup(&t, ext.c_str(), ext.size()) < 0, "extensão", n);
+
+        // texto sem '\0' logo após o nome (token dentro da linha)
+        std::string in = std::string(n) + "\",";
+        check(dispatch_lookup(&t, in.c_str(), len) == i, "token sem terminador", n);
+
+        // '\0' embutido no token: nem o nome antes dele, nem leitura além do nome. Vários
+        // sufixos, para que alguns caiam na mesma posição do nome (senão a comparação não roda)
+        for (int k = 0; k < 4096; k++) {
+            std::string nul = std::string(n) + std::string(1, '\0') + static_cast<char>('a' + k % 26) +
+                              static_cast<char>('a' + (k / 26) % 26) + std::string(static_cast<size_t>(k / 676), 'x');
+            if (dispatch_lookup(&t, nul.data(), nul.size()) >= 0) {
+                check(false, "nul embutido", n);
+                break;
+            }
+        }
+        std::string cut = std::string(n, len - 1) + std::string(1, '\0');
+        check(dispatch_lookup(&t, cut.data(), cut.size()) < 0, "nul no lugar do último", n);
+    }
+    for (const char *n : { "", "x", "HELLO", "Mode", "dumpcredit", "percentage" }) {
+        check(dispatch_lookup(&t, n, std::strlen(n)) < 0, "desconhecido", n);
+    }
+}
+
+/** @brief Como vTaskSerialRpc antes do hash perfeito. */
+Result run_legacy(const char *line)
+{
+    Result r;
+    char op[16];
+    if (!json_get_string(line, "op", op, sizeof(op))) {
+        r.op = -2;
+        return r;
+    }
+    if (std::strcmp(op, "hello") == 0) r.op = 0;
+    else if (std::strcmp(op, "logout") == 0) r.op = 1;
+    else if (std::strcmp(op, "auth") == 0) r.op = 2;
+    else if (std::strcmp(op, "cmd") == 0) r.op = 3;
+    else if (std::strcmp(op, "stats") == 0) r.op = 4;
+    else if (std::strcmp(op, "binary") == 0) r.op = 5;
+    else if (std::strcmp(op, "subscribe") == 0) r.op = 6;
+    else if (std::strcmp(op, "unsubscribe") == 0) r.op = 7;
+    else if (std::strcmp(op, "dump") == 0) r.op = 8;
+    else if (std::strcmp(op, "dump_credit") == 0) r.op = 9;
+    else if (std::strcmp(op, "dump_stop") == 0) r.op = 10;
+
+    if (r.op == 3) {
+        char mode[8];
+        int v;
+        if (json_get_string(line, "mode", mode, sizeof(mode))) {
+            if (std::strcmp(mode, "auto") == 0) r.mode = 0;
+            else if (std::strcmp(mode, "manual") == 0) r.mode = 1;
+        }
+        if (json_get_int(line, "matrixPercent", &v)) r.percent = v;
+        else if (json_get_int(line, "brightness", &v)) r.percent = v;
+        else if (json_get_int(line, "percent", &v)) r.percent = v;
+        if (json_get_int(line, "channel", &v)) r.channel = v;
+    }
+    return r;
+}
+
+/** @brief Caminho atual: um parse, um lookup de op, uma passada pelas chaves. */
+Result run_hash(const char *line, size_t len)
+{
+    Result r;
+    json_tok_t toks[JSON_MAX_TOKENS_DEFAULT];
+    json_doc_t doc;
+    if (json_parse(&doc, line, len, toks, JSON_MAX_TOKENS_DEFAULT) <= 0) {
+        r.op = -2;
+        return r;
+    }
+
+    int v = json_doc_find(&doc, "op");
+    if (v < 0 || doc.toks[v].type != JSON_TOK_STRING) {
+        r.op = -2;
+        return r;
+    }
+    const json_tok_t &t = doc.toks[v];
+    r.op = dispatch_lookup(&g_ops, line + t.start, static_cast<size_t>(t.end - t.start));
+    if (r.op != 3) return r;
+
+    int rank = 0;
+    const char *k;
+    size_t klen;
+    int it = 0;
+    while ((v = json_doc_next_member(&doc, &it, &k, &klen)) >= 0) {
+        int key = dispatch_lookup(&g_keys, k, klen);
+        if (key < 0) continue;
+
+        int iv;
+        if (key == 0) {
+            const json_tok_t &m = doc.toks[v];
+            size_t ml = static_cast<size_t>(m.end - m.start);
+            if (ml == 4 && std::memcmp(line + m.start, "auto", 4) == 0) r.mode = 0;
+            else if (ml == 6 && std::memcmp(line + m.start, "manual", 6) == 0) r.mode = 1;
+        } else if (key <= 3) {
+            // precedência: matrixPercent (3) > brightness (2) > percent (1)
+            int kr = 4 - key;
+            if (kr >= rank && json_doc_tok_int(&doc, v, &iv)) {
+                r.percent = iv;
+                rank = kr;
+            }
+        } else if (json_doc_tok_int(&doc, v, &iv)) {
+            r.channel = iv;
+        }
+    }
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const long n = (argc > 1) ? std::atol(argv[1]) : 1000000L;
+
+    if (!dispatch_build(&g_ops, kOps, kOpCount) || !dispatch_build(&g_keys, kKeys, kKeyCount)) {
+        std::printf("FALHA: dispatch_build sem semente\n");
+        return 1;
+    }
+    check_table(g_ops, kOps, kOpCount);
+    check_table(g_keys, kKeys, kKeyCount);
+    std::printf("tabelas: ops %u nomes/%u posições (semente %u), chaves %u/%u (semente %u), %d falha(s)\n",
+                kOpCount, g_ops.mask + 1u, static_cast<unsigned>(g_ops.seed), kKeyCount, g_keys.mask + 1u,
+                static_cast<unsigned>(g_keys.seed), g_fail);
+    if (g_fail) return 1;
+
+    const std::vector<std::string> lines = {
+        "{\"op\":\"hello\"}",
+        "{\"op\":\"auth\",\"pass\":\"1234\",\"id\":1}",
+        "{\"op\":\"stats\",\"id\":2}",
+        "{\"op\":\"cmd\",\"id\":3,\"mode\":\"manual\",\"percent\":40}",
+        "{\"op\":\"cmd\",\"id\":\"a7\",\"matrixPercent\":60,\"brightness\":30,\"channel\":0}",
+        "{\"op\":\"cmd\",\"mode\":\"auto\"}",
+        "{\"op\":\"subscribe\",\"fields\":[\"lux\",\"temp\",\"hum\"],\"rate_ms\":200}",
+        "{\"op\":\"dump\",\"id\":\"d1\",\"from\":0,\"count\":512,\"credit\":8}",
+        "{\"op\":\"dump_credit\",\"id\":\"d1\",\"n\":4}",
+        "{\"op\":\"dump_stop\",\"id\":\"d1\"}",
+        "{\"op\":\"unsubscribe\"}",
+        "{\"op\":\"reboot\",\"id\":9}",
+    };
+
+    size_t bytes = 0;
+    for (const auto &l : lines) {
+        bytes += l.size() + 1u;   // '\n'
+        Result a = run_legacy(l.c_str());
+        Result b = run_hash(l.c_str(), l.size());
+        if (!(a == b)) {
+            std::printf("FALHA linha %s: legacy op=%d mode=%d pct=%d ch=%d / hash op=%d mode=%d pct=%d ch=%d\n",
+                        l.c_str(), a.op, a.mode, a.percent, a.channel, b.op, b.mode, b.percent, b.channel);
+            g_fail++;
+        }
+    }
+    if (g_fail) return 1;
+
+    volatile int sink = 0;
+    const size_t nl = lines.size();
+
+    auto t0 = Clock::now();
+    for (long i = 0; i < n; i++) sink = sink + run_legacy(lines[i % nl].c_str()).op;
+    double tl = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    t0 = Clock::now();
+    for (long i = 0; i < n; i++) {
+        const std::string &l = lines[i % nl];
+        sink = sink + run_hash(l.c_str(), l.size()).op;
+    }
+    double th = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    const double mb = static_cast<double>(bytes) * n / nl / 1e6;
+    std::printf("%-7s %10s %9s %9s %14s\n", "caminho", "linhas/s", "ns/linha", "MB/s", "x USB FS 1MB/s");
+    std::printf("%-7s %10.0f %9.0f %9.1f %14.1f\n", "legacy", n / tl, tl * 1e9 / n, mb / tl, mb / tl);
+    std::printf("%-7s %10.0f %9.0f %9.1f %14.1f\n", "hash", n / th, th * 1e9 / n, mb / th, mb / th);
+    std::printf("OK: %zu tipos de linha conferidos, %ld linhas por caminho\n", nl, n);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+/**
+ * @file dma.h
+ * @brief Substituto no host (tools/): registradores e chamadas de DMA usados pelo ssd1306.c.
+ *
+ * As funções são implementadas pela ferramenta, que executa a lista de blocos do canal
+ * de controle quando ele é disparado.
+ */
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+typedef struct {
+    volatile uint32_t al3_transfer_count;
+    volatile uint32_t al3_read_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    dma_channel_hw_t ch[12];
+} dma_hw_t;
+
+extern dma_hw_t host_dma_hw;
+#define dma_hw (&host_dma_hw)
+
+int  dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to);
+void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet);
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq1_status(uint channel);
+void dma_channel_acknowledge_irq1(uint channel);
+void dma_channel_abort(uint channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_DMA_H
@@ -0,0 +1,11 @@
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+/**
+ * @file gpio.h
+ * @brief Substituto no host (tools/): vazio, só para os includes do driver.
+ */
+
+#include "pico/types.h"
+
+#endif // HOST_HARDWARE_GPIO_H
@@ -0,0 +1,33 @@
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+/**
+ * @file i2c.h
+ * @brief Substituto no host (tools/): tipos e chamadas de I2C usados por app_config.h e
+ *        ssd1306.c; as funções são implementadas pela ferramenta que precisar delas.
+ */
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200u
+
+typedef struct i2c_inst i2c_inst_t;
+
+typedef struct {
+    volatile uint32_t data_cmd;
+    volatile uint32_t clr_tx_abrt;
+} i2c_hw_t;
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c);
+uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx);
+int  i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_I2C_H
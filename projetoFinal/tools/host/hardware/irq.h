@@ -0,0 +1,27 @@
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+/**
+ * @file irq.h
+ * @brief Substituto no host (tools/): a ferramenta guarda o handler e o chama.
+ */
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DMA_IRQ_1 12u
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80u
+
+typedef void (*irq_handler_t)(void);
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_set_enabled(uint num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_IRQ_H
@@ -0,0 +1,14 @@
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+/**
+ * @file sync.h
+ * @brief Substituto no host (tools/): __dmb() vira barreira completa do compilador/CPU.
+ */
+
+static inline void __dmb(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif // HOST_HARDWARE_SYNC_H
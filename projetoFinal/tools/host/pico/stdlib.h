@@ -0,0 +1,23 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+/**
+ * @file stdlib.h
+ * @brief Substituto no host (tools/): relógio em us fornecido pela ferramenta.
+ */
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t time_us_32(void);
+
+static inline void tight_loop_contents(void) {}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PICO_STDLIB_H
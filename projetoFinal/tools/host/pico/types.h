@@ -0,0 +1,15 @@
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+
+/**
+ * @file types.h
+ * @brief Substituto no host (tools/): tipos básicos do SDK.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#endif // HOST_PICO_TYPES_H
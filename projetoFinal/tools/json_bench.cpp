@@ -0,0 +1,163 @@
+/**
+ * @file json_bench.cpp
+ * @brief Compara o tokenizador json_simple com a implementação antiga (strstr por chave).
+ *
+ * Uso: json_bench [mensagens]      (padrão: 200000 por caso)
+ *
+ * Para cada payload típico, busca as chaves que o firmware lê de um comando
+ * (op, id, mode, percent, matrixPercent, brightness):
+ *  - legacy: json_get_*() antigo, um strstr no texto inteiro por chave (cópia abaixo);
+ *  - parse1: json_parse() uma vez + json_doc_get_*() sobre os tokens.
+ * Informa ns/mensagem, MB/s e se os resultados conferem (o legacy confunde um valor
+ * string igual ao nome da chave com a chave: divergência esperada no último caso).
+ *
+ * Compilação (a partir de projetoFinal/tools):
+ *   gcc -O2 -c -I../include ../src/json_simple.c -o json_simple.o
+ *   g++ -std=c++17 -O2 -I../include json_bench.cpp json_simple.o -o json_bench
+ */
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "json_simple.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace legacy {
+
+// implementação anterior de src/json_simple.c (referência do benchmark)
+const char *find_key(const char *json, const char *key)
+{
+    static char pat[64];
+    std::snprintf(pat, sizeof(pat), "\"%s\"", key);
+    return std::strstr(json, pat);
+}
+
+bool get_string(const char *json, const char *key, char *out, size_t outsz)
+{
+    const char *p = find_key(json, key);
+    if (!p) return false;
+    p = std::strchr(p, ':');
+    if (!p) return false;
+    p++;
+    while (*p && std::isspace(static_cast<unsigned char>(*p))) p++;
+    if (*p != '"') return false;
+    p++;
+    size_t i = 0;
+    while (*p && *p != '"' && i + 1 < outsz) out[i++] = *p++;
+    out[i] = '\0';
+    return i > 0;
+}
+
+bool get_int(const char *json, const char *key, int *out)
+{
+    const char *p = find_key(json, key);
+    if (!p) return false;
+    p = std::strchr(p, ':');
+    if (!p) return false;
+    p++;
+    while (*p && (std::isspace(static_cast<unsigned char>(*p)) || *p == '"')) p++;
+    int sign = 1;
+    if (*p == '-') { sign = -1; p++; }
+    if (!std::isdigit(static_cast<unsigned char>(*p))) return false;
+    int v = 0;
+    while (*p && std::isdigit(static_cast<unsigned char>(*p))) v = v * 10 + (*p++ - '0');
+    *out = v * sign;
+    return true;
+}
+
+} // namespace legacy
+
+namespace {
+
+struct Result {
+    char op[16], mode[16];
+    int id, percent, matrix, bright;
+    bool has[6];
+
+    bool operator==(const Result &o) const
+    {
+        for (int i = 0; i < 6; i++) if (has[i] != o.has[i]) return false;
+        return (!has[0] || std::strcmp(op, o.op) == 0) && (!has[1] || std::strcmp(mode, o.mode) == 0) &&
+               (!has[2] || id == o.id) && (!has[3] || percent == o.percent) &&
+               (!has[4] || matrix == o.matrix) && (!has[5] || bright == o.bright);
+    }
+};
+
+Result run_legacy(const char *js)
+{
+    Result r{};
+    r.has[0] = legacy::get_string(js, "op", r.op, sizeof(r.op));
+    r.has[1] = legacy::get_string(js, "mode", r.mode, sizeof(r.mode));
+    r.has[2] = legacy::get_int(js, "id", &r.id);
+    r.has[3] = legacy::get_int(js, "percent", &r.percent);
+    r.has[4] = legacy::get_int(js, "matrixPercent", &r.matrix);
+    r.has[5] = legacy::get_int(js, "brightness", &r.bright);
+    return r;
+}
+
+Result run_parse1(const char *js, size_t len)
+{
+    Result r{};
+    json_tok_t toks[JSON_MAX_TOKENS_DEFAULT];
+    json_doc_t doc;
+    if (json_parse(&doc, js, len, toks, JSON_MAX_TOKENS_DEFAULT) < 0) return r;
+    r.has[0] = json_doc_get_string(&doc, "op", r.op, sizeof(r.op));
+    r.has[1] = json_doc_get_string(&doc, "mode", r.mode, sizeof(r.mode));
+    r.has[2] = json_doc_get_int(&doc, "id", &r.id);
+    r.has[3] = json_doc_get_int(&doc, "percent", &r.percent);
+    r.has[4] = json_doc_get_int(&doc, "matrixPercent", &r.matrix);
+    r.has[5] = json_doc_get_int(&doc, "brightness", &r.bright);
+    return r;
+}
+
+template <typename F>
+double time_ns(long n, F &&f)
+{
+    auto t0 = Clock::now();
+    for (long i = 0; i < n; i++) f();
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+}
+
+volatile int g_sink;
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const long n = (argc > 1) ? std::atol(argv[1]) : 200000L;
+
+    const std::string pad(200, 'x');
+    const struct {
+        const char *name;
+        std::string js;
+    } cases[] = {
+        { "cmd_curto", "{\"mode\":\"manual\",\"percent\":75}" },
+        { "cmd_rpc",   "{\"op\":\"cmd\",\"id\":42,\"mode\":\"manual\",\"matrixPercent\":60,\"brightness\":30}" },
+        { "so_op",     "{\"op\":\"stats\",\"id\":7}" },
+        { "telemetria", "{\"device\":\"E6614103E7452D2F\",\"lux\":123.4,\"luxPercLum\":42.0,\"temp\":24.5,"
+                        "\"hum\":55.1,\"seq\":1234,\"t_ms\":987654,\"mode\":\"auto\",\"target\":40,\"current\":38}" },
+        { "chave_em_valor", "{\"note\":\"" + pad + "\",\"op\":\"percent\",\"brightness\":5}" },
+    };
+
+    std::printf("%-16s %6s %12s %12s %8s %s\n", "caso", "bytes", "legacy ns", "parse1 ns", "ganho", "resultado");
+    for (const auto &c : cases) {
+        const char *js = c.js.c_str();
+        const size_t len = c.js.size();
+
+        Result a = run_legacy(js);
+        Result b = run_parse1(js, len);
+
+        double tl = time_ns(n, [&] { g_sink = run_legacy(js).percent; });
+        double tp = time_ns(n, [&] { g_sink = run_parse1(js, len).percent; });
+
+        std::printf("%-16s %6zu %9.0f ns %9.0f ns %7.2fx %s  (%.0f / %.0f MB/s)\n", c.name, len, tl, tp, tl / tp,
+                    (a == b) ? "iguais" : "DIVERGEM (legacy casou o valor \"percent\")",
+                    len * 1e3 / tl, len * 1e3 / tp);
+    }
+    return 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file json_fuzz.cpp
+ * @brief Fuzz do tokenizador json_simple (json_parse + buscas) no host.
+ *
+ * Uso: json_fuzz [iterações] [semente]      (padrão: 1000000, 1)
+ *
+ * Sem libFuzzer: casos fixos (aceita/rejeita) e depois mutação aleatória de um corpus
+ * com os comandos do projeto (troca/insere/apaga bytes, duplica trechos, trunca).
+ * Cada entrada é copiada para um buffer do tamanho exato, sem '\0', para o ASan pegar
+ * leitura além de len. Resultados aceitos passam pela verificação da árvore de tokens
+ * (limites, pais, alternância chave/valor) e pelas buscas json_doc_*.
+ *
+ * Inteiros: json_doc_get_int() é conferido contra uma referência em int64_t (saturação
+ * em ±INT_MAX) com números longos, INT_MAX±1 e strings numéricas. O acumulador do
+ * parser é int, 32 bits como no RP2040, então o UBSan acusa qualquer estouro aqui.
+ *
+ * Com libFuzzer (clang) o mesmo alvo é usado por LLVMFuzzerTestOneInput:
+ *   clang -g -O1 -fsanitize=fuzzer,address -DJSON_FUZZ_LIBFUZZER -I../include \
+ *         -x c ../src/json_simple.c -x c++ json_fuzz.cpp -o json_fuzz
+ *
+ * Compilação (a partir de projetoFinal/tools):
+ *   gcc -g -O1 -fsanitize=address,undefined -c -I../include ../src/json_simple.c -o json_simple.o
+ *   g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I../include json_fuzz.cpp json_simple.o -o json_fuzz
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "json_simple.h"
+
+namespace {
+
+constexpr int kMaxToks = 64;
+
+[[noreturn]] void die(const char *why, const uint8_t *data, size_t len)
+{
+    std::fprintf(stderr, "FALHA: %s\nentrada (%zu bytes): ", why, len);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if (c >= 32 && c < 127) std::fputc(c, stderr);
+        else std::fprintf(stderr, "\\x%02x", c);
+    }
+    std::fputc('\n', stderr);
+    std::abort();
+}
+
+/**
+ * @brief Invariantes de um documento aceito.
+ */
+void check_doc(const json_doc_t &doc, const uint8_t *data, size_t len)
+{
+    for (int i = 0; i < doc.count; i++) {
+        const json_tok_t &t = doc.toks[i];
+        if (t.type > JSON_TOK_PRIMITIVE) die("tipo invalido", data, len);
+        if (t.start > t.end || t.end > len) die("token fora do texto", data, len);
+        if (i == 0 ? t.parent != -1 : (t.parent < 0 || t.parent >= i)) die("pai invalido", data, len);
+
+        if (t.parent >= 0) {
+            const json_tok_t &p = doc.toks[t.parent];
+            if (p.type == JSON_TOK_PRIMITIVE) die("primitivo com filho", data, len);
+            if (p.type == JSON_TOK_OBJECT && t.type != JSON_TOK_STRING) die("membro sem chave", data, len);
+            if (p.type == JSON_TOK_STRING && (p.parent < 0 || doc.toks[p.parent].type != JSON_TOK_OBJECT)) {
+                die("valor pendurado em string que não é chave", data, len);
+            }
+        }
+        // chave de objeto tem exatamente um valor
+        if (t.type == JSON_TOK_STRING && t.parent >= 0 && doc.toks[t.parent].type == JSON_TOK_OBJECT &&
+            t.size != 1) {
+            die("chave sem valor", data, len);
+        }
+        if ((t.type == JSON_TOK_OBJECT || t.type == JSON_TOK_ARRAY) &&
+            (t.end <= t.start || data[t.start] != (t.type == JSON_TOK_OBJECT ? '{' : '[') ||
+             data[t.end - 1] != (t.type == JSON_TOK_OBJECT ? '}' : ']'))) {
+            die("container sem delimitadores", data, len);
+        }
+    }
+
+    // buscas: nada pode ler fora dos tokens nem estourar o buffer de saída
+    static const char *const keys[] = { "op", "mode", "percent", "matrixPercent", "brightness",
+                                        "id", "pass", "a", "" };
+    for (const char *k : keys) {
+        char out[8];
+        int iv;
+        bool bv;
+        (void)json_doc_get_string(&doc, k, out, sizeof(out));
+        if (std::strlen(out) >= sizeof(out)) die("string sem terminador", data, len);
+        (void)json_doc_get_int(&doc, k, &iv);
+        (void)json_doc_get_bool(&doc, k, &bv);
+        (void)json_doc_string_eq(&doc, k, "manual");
+    }
+    int it = 0;
+    const char *k;
+    size_t kl;
+    int n = 0;
+    while (json_doc_next_member(&doc, &it, &k, &kl) >= 0) {
+        if (k < doc.json || k + kl > doc.json + len) die("chave fora do texto", data, len);
+        if (++n > doc.count) die("iteração não termina", data, len);
+    }
+}
+
+int run_one(const uint8_t *data, size_t len)
+{
+    // cópia exata: sem '\0' no fim, o ASan acusa qualquer leitura além de len
+    std::vector<char> buf(data, data + len);
+    json_tok_t toks[kMaxToks];
+    json_doc_t doc;
+
+    int r = json_parse(&doc, buf.data(), buf.size(), toks, kMaxToks);
+    if (r > 0) {
+        if (r != doc.count || r > kMaxToks) die("contagem inconsistente", data, len);
+        check_doc(doc, data, len);
+    } else if (r != JSON_ERR_NOMEM && r != JSON_ERR_INVAL && r != JSON_ERR_PART) {
+        die("código de erro desconhecido", data, len);
+    }
+    return r;
+}
+
+struct Case {
+    const char *json;
+    bool ok;
+};
+
+const Case kCases[] = {
+    { "{\"op\":\"cmd\",\"mode\":\"manual\",\"percent\":75}", true },
+    { "{\"a\":{\"b\":[1,2,{\"c\":null}]},\"d\":true}", true },
+    { "[]", true },
+    { "{}", true },
+    { "[[1],[2]]", true },
+    { "  {\"a\" : \"x,y}\" }  ", true },
+    { "{\"a\":1,}", false },
+    { "{,}", false },
+    { "[,1]", false },
+    { "[1,]", false },
+    { "[1,,2]", false },
+    { "{\"a\":1,,\"b\":2}", false },
+    { "{\"a\" 1}", false },
+    { "{\"a\",\"b\":1}", false },
+    { "{\"a\":1 \"b\":2}", false },
+    { "[1 2]", false },
+    { "{\"a\":}", false },
+    { "{\"a\":1}}", false },
+    { "{\"a\":1", false },
+    { "\"abc", false },
+    { ",", false },
+};
+
+void run_cases()
+{
+    int bad = 0;
+    for (const Case &c : kCases) {
+        int r = run_one(reinterpret_cast<const uint8_t *>(c.json), std::strlen(c.json));
+        if ((r > 0) != c.ok) {
+            std::printf("FALHA caso %-36s -> %d (esperado %s)\n", c.json, r, c.ok ? "aceitar" : "rejeitar");
+            bad++;
+        }
+    }
+    std::printf("casos fixos: %zu, %d falha(s)\n", sizeof(kCases) / sizeof(kCases[0]), bad);
+    if (bad) std::exit(1);
+}
+
+/** @brief Referência em 64 bits: dígitos iniciais, saturados em ±INT_MAX. */
+int ref_int(const std::string &num)
+{
+    size_t i = 0;
+    bool neg = false;
+    if (i < num.size() && num[i] == '-') { neg = true; i++; }
+    int64_t acc = 0;
+    for (; i < num.size() && num[i] >= '0' && num[i] <= '9'; i++) {
+        acc = acc * 10 + (num[i] - '0');
+        if (acc > INT32_MAX) acc = INT32_MAX;
+    }
+    return static_cast<int>(neg ? -acc : acc);
+}
+
+void check_int(const std::string &num, bool quoted, int &bad)
+{
+    std::string s = quoted ? "{\"percent\":\"" + num + "\"}" : "{\"percent\":" + num + "}";
+    std::vector<char> buf(s.begin(), s.end());
+    json_tok_t toks[kMaxToks];
+    json_doc_t doc;
+    int v = 0;
+    if (json_parse(&doc, buf.data(), buf.size(), toks, kMaxToks) <= 0 || !json_doc_get_int(&doc, "percent", &v) ||
+        v != ref_int(num)) {
+        std::printf("FALHA inteiro %s -> %d (esperado %d)\n", s.c_str(), v, ref_int(num));
+        bad++;
+    }
+}
+
+void run_int_cases(std::mt19937 &rng)
+{
+    static const char *const kNums[] = { "0", "-0", "100", "-3", "2147483646", "2147483647", "2147483648",
+                                         "2147483649", "2147483650", "2147483657", "-2147483647",
+                                         "-2147483648", "-2147483649", "214748364", "2147483640",
+                                         "99999999999", "-99999999999", "00000000002147483647",
+                                         "1844674407370955161600", "4294967296", "4294967306" };
+    int bad = 0;
+    for (const char *n : kNums) {
+        check_int(n, false, bad);
+        check_int(n, true, bad);
+    }
+    for (int i = 0; i < 200000; i++) {
+        std::string n = (rng() & 1u) ? "-" : "";
+        int digits = 1 + static_cast<int>(rng() % 24);
+        for (int d = 0; d < digits; d++) n += static_cast<char>('0' + rng() % 10);
+        check_int(n, (rng() % 4) == 0, bad);
+    }
+    std::printf("inteiros: %zu fixos + 200000 aleatórios, %d falha(s)\n", sizeof(kNums) / sizeof(kNums[0]), bad);
+    if (bad) std::exit(1);
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    run_one(data, size);
+    return 0;
+}
+
+#ifndef JSON_FUZZ_LIBFUZZER
+int main(int argc, char **argv)
+{
+    const long iters = (argc > 1) ? std::atol(argv[1]) : 1000000L;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(std::atoi(argv[2])) : 1u;
+
+    run_cases();
+
+    std::mt19937 rng(seed);
+    run_int_cases(rng);
+
+    std::vector<std::string> corpus;
+    for (const Case &c : kCases) corpus.emplace_back(c.json);
+    corpus.emplace_back("{\"op\":\"auth\",\"pass\":\"1234\",\"id\":\"7\"}");
+    corpus.emplace_back("{\"op\":\"sub\",\"fields\":[\"lux\",\"temp\"],\"rate_ms\":200}");
+    corpus.emplace_back("{\"matrixPercent\":\"60\",\"brightness\":-3,\"x\":\"\\\"\\\\\\u0041\"}");
+    corpus.emplace_back("{\"percent\":2147483647,\"channel\":-99999999999,\"id\":\"4294967296\"}");
+
+    static const char kAlpha[] = "{}[]:,\"\\ 0123456789-tfnul.eE";
+    long accepted = 0;
+
+    for (long i = 0; i < iters; i++) {
+        std::string s = corpus[rng() % corpus.size()];
+        int edits = 1 + static_cast<int>(rng() % 4);
+        for (int e = 0; e < edits; e++) {
+            size_t at = s.empty() ? 0 : rng() % (s.size() + 1);
+            switch (rng() % 6) {
+            case 0: if (at < s.size()) s[at] = kAlpha[rng() % (sizeof(kAlpha) - 1)]; break;
+            case 1: s.insert(at, 1, kAlpha[rng() % (sizeof(kAlpha) - 1)]); break;
+            case 2: if (at < s.size()) s.erase(at, 1 + rng() % 3); break;
+            case 3: if (at < s.size()) s.insert(at, s.substr(at, 1 + rng() % 8)); break;
+            case 4: s.resize(at); break;
+            default: if (at < s.size()) s[at] = static_cast<char>(rng()); break;
+            }
+        }
+        if (run_one(reinterpret_cast<const uint8_t *>(s.data()), s.size()) > 0) accepted++;
+    }
+
+    std::printf("mutação: %ld entradas, %ld aceitas, 0 falhas\n", iters, accepted);
+    return 0;
+}
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file pwm_duty_test.cpp
+ * @brief Teste no host do mapeamento percentual -> duty de 16 bits (pwm_dimmer_curve.c).
+ *
+ * Uso: pwm_duty_test [-v]   (-v imprime a tabela percent,level,duty%)
+ *
+ * Confere, para 0..100 e para entradas fora da faixa:
+ *  - extremos: 0 -> 0 (desligado), >= 100 -> PWM_DIMMER_LEVEL_MAX (sempre ligado);
+ *  - 1..99 ficam em [1, PWM_DIMMER_TOP]: nunca apaga nem satura um canal aceso;
+ *  - monotonia estrita (cada passo de 1% muda o duty);
+ *  - erro <= 1 LSB contra a curva CIE 1931 calculada em double.
+ * Lista todas as falhas e sai com 1 se houver alguma.
+ *
+ * Compilação (a partir de projetoFinal/tools):
+ *   gcc -O2 -c -I../include ../src/pwm_dimmer_curve.c -o pwm_dimmer_curve.o
+ *   g++ -std=c++17 -O2 -I../include pwm_duty_test.cpp pwm_dimmer_curve.o -o pwm_duty_test
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+
+#include "pwm_dimmer.h"
+
+namespace {
+
+int g_fail = 0;
+
+void fail(const char *what, int pct, uint32_t got, uint32_t want)
+{
+    std::printf("FALHA %-12s p=%3d duty=%5u esperado=%5u\n", what, pct, got, want);
+    g_fail++;
+}
+
+/** @brief Curva de referência (double), mesma fórmula do firmware. */
+double cie_ref(int pct)
+{
+    double L = pct;
+    double Y = (L <= 8.0) ? (L / 903.3) : std::pow((L + 16.0) / 116.0, 3.0);
+    return Y * PWM_DIMMER_LEVEL_MAX;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const bool verbose = (argc > 1 && std::strcmp(argv[1], "-v") == 0);
+
+    if (pwm_dimmer_duty_from_percent(0) != 0) fail("zero", 0, pwm_dimmer_duty_from_percent(0), 0);
+    for (int p : {100, 101, 200, 255}) {
+        uint16_t d = pwm_dimmer_duty_from_percent(static_cast<uint8_t>(p));
+        if (d != PWM_DIMMER_LEVEL_MAX) fail("maximo", p, d, PWM_DIMMER_LEVEL_MAX);
+    }
+
+    double max_err = 0.0;
+    uint16_t prev = 0;
+    for (int p = 1; p <= 99; p++) {
+        uint16_t d = pwm_dimmer_duty_from_percent(static_cast<uint8_t>(p));
+
+        if (d < 1u || d > PWM_DIMMER_TOP) fail("faixa", p, d, PWM_DIMMER_TOP);
+        if (d <= prev) fail("monotonia", p, d, prev + 1u);
+
+        double ref = cie_ref(p);
+        double err = std::fabs(d - ref);
+        if (ref >= 1.0 && err > 1.0) fail("cie1931", p, d, static_cast<uint32_t>(ref + 0.5));
+        if (err > max_err) max_err = err;
+
+        if (verbose) std::printf("%d,%u,%.4f\n", p, d, 100.0 * d / PWM_DIMMER_LEVEL_MAX);
+        prev = d;
+    }
+
+    std::printf("%s: 0..100 + fora da faixa, erro max %.3f LSB, %d falha(s)\n",
+                g_fail ? "FALHOU" : "OK", max_err, g_fail);
+    return g_fail ? 1 : 0;
+}
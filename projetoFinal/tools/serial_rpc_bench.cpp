@@ -0,0 +1,113 @@
+/**
+ * @file serial_rpc_bench.cpp
+ * @brief Vazão e latência do modo binário do SerialRPC (placa real via USB CDC).
+ *
+ * Uso: serial_rpc_bench /dev/ttyACM0 [senha] [segundos] [pings] [cmds]
+ *      (CDC do SerialRPC; o log sai na outra interface, ex.: /dev/ttyACM1)
+ *
+ * 1) autentica em JSON e envia M comandos "cmd" em pipeline (com "id", janela igual
+ *    à fila do firmware): comandos/s e latência por resposta, como no comissionamento;
+ * 2) negocia o modo binário e mede N round-trips PING -> ACK (min/média/p99/máx);
+ * 3) escuta o streaming por T segundos e informa quadros/s, bytes/s e quadros
+ *    descartados (COBS/CRC inválido, ex.: bytes perdidos).
+ *
+ * Compilação: ver serial_rpc_client.hpp.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "serial_rpc_client.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "uso: %s <tty> [senha] [segundos] [pings] [cmds]\n", argv[0]);
+        return 2;
+    }
+    const std::string dev  = argv[1];
+    const std::string pass = (argc > 2) ? argv[2] : "1234";
+    const int seconds      = (argc > 3) ? std::atoi(argv[3]) : 10;
+    const int pings        = (argc > 4) ? std::atoi(argv[4]) : 200;
+    const int cmds         = (argc > 5) ? std::atoi(argv[5]) : 500;
+
+    try {
+        serialrpc::Client c(dev);
+
+        if (!c.authenticate(pass)) { std::fprintf(stderr, "auth falhou\n"); return 1; }
+
+        // --- comandos em pipeline (JSON) ---
+        std::vector<double> rep_us;
+        rep_us.reserve(static_cast<size_t>(cmds));
+        c.onReply = [&](uint32_t, const std::string &, double us) { rep_us.push_back(us); };
+
+        auto p0 = Clock::now();
+        int sent = 0;
+        for (int i = 0; i < cmds; i++) {
+            std::string cmd = "{\"op\":\"cmd\",\"mode\":\"manual\",\"percent\":" + std::to_string(i % 101) + "}";
+            if (c.submit(cmd) == 0) break;
+            sent++;
+        }
+        bool drained = c.drain(2000);
+        double pdt = std::chrono::duration<double>(Clock::now() - p0).count();
+        c.onReply = nullptr;
+
+        if (!rep_us.empty()) {
+            std::sort(rep_us.begin(), rep_us.end());
+            std::printf("cmd: enviados=%d respostas=%zu erros=%llu %.0f cmd/s p50=%.0fus p99=%.0fus%s\n",
+                        sent, rep_us.size(), static_cast<unsigned long long>(c.stats().errors),
+                        rep_us.size() / pdt, rep_us[rep_us.size() / 2],
+                        rep_us[std::min(rep_us.size() - 1, rep_us.size() * 99 / 100)],
+                        drained ? "" : " (respostas faltando)");
+        }
+
+        if (!c.enterBinary())      { std::fprintf(stderr, "modo binario nao negociado\n"); return 1; }
+
+        // --- latência ---
+        std::vector<double> lat_us;
+        lat_us.reserve(static_cast<size_t>(pings));
+        int lost = 0;
+        for (int i = 0; i < pings; i++) {
+            auto t0 = Clock::now();
+            if (!c.ping(500)) { lost++; continue; }
+            lat_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+        if (!lat_us.empty()) {
+            std::sort(lat_us.begin(), lat_us.end());
+            double sum = 0;
+            for (double v : lat_us) sum += v;
+            std::printf("ping: n=%zu perdidos=%d min=%.0fus media=%.0fus p99=%.0fus max=%.0fus\n",
+                        lat_us.size(), lost, lat_us.front(), sum / lat_us.size(),
+                        lat_us[std::min(lat_us.size() - 1, lat_us.size() * 99 / 100)], lat_us.back());
+        }
+
+        // --- streaming ---
+        auto s0 = c.stats();
+        auto t0 = Clock::now();
+        auto end = t0 + std::chrono::seconds(seconds);
+        while (Clock::now() < end) c.poll(50);
+        double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+        auto s1 = c.stats();
+
+        std::printf("stream: %.1fs quadros=%llu (%.1f/s) tele=%llu lux=%llu bytes=%.0fB/s descartados=%llu\n",
+                    dt,
+                    static_cast<unsigned long long>(s1.frames - s0.frames), (s1.frames - s0.frames) / dt,
+                    static_cast<unsigned long long>(s1.telemetry - s0.telemetry),
+                    static_cast<unsigned long long>(s1.lux - s0.lux),
+                    (s1.rx_bytes - s0.rx_bytes) / dt,
+                    static_cast<unsigned long long>(s1.bad - s0.bad));
+
+        c.leaveBinary();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "erro: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,298 @@
+#include "serial_rpc_client.hpp"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace serialrpc {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int remaining_ms(Clock::time_point deadline)
+{
+    auto d = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return d > 0 ? static_cast<int>(d) : 0;
+}
+
+} // namespace
+
+Client::Client(const std::string &device)
+{
+    fd_ = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0) throw std::runtime_error("open " + device + ": " + std::strerror(errno));
+    owns_fd_ = true;
+
+    termios tio{};
+    if (tcgetattr(fd_, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);   // USB CDC ignora, mas UART real não
+        tcsetattr(fd_, TCSANOW, &tio);
+    }
+}
+
+Client::Client(int fd) : fd_(fd), owns_fd_(false)
+{
+}
+
+Client::~Client()
+{
+    if (owns_fd_ && fd_ >= 0) ::close(fd_);
+}
+
+void Client::writeAll(const uint8_t *p, size_t n)
+{
+    while (n > 0) {
+        ssize_t w = ::write(fd_, p, n);
+        if (w < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                pollfd pf{fd_, POLLOUT, 0};
+                ::poll(&pf, 1, 100);
+                continue;
+            }
+            throw std::runtime_error(std::string("write: ") + std::strerror(errno));
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+        stats_.tx_bytes += static_cast<uint64_t>(w);
+    }
+}
+
+void Client::sendLine(const std::string &json)
+{
+    std::string l = json + "\n";
+    writeAll(reinterpret_cast<const uint8_t *>(l.data()), l.size());
+}
+
+void Client::sendFrame(uint8_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t wire[SERIAL_BIN_WIRE_MAX];
+    size_t n = serial_bin_frame(type, payload, len, wire);
+    if (n == 0) throw std::runtime_error("payload grande demais");
+    writeAll(wire, n);
+}
+
+void Client::handleUnit(std::vector<uint8_t> &unit)
+{
+    if (!binary_) {
+        std::string line(unit.begin(), unit.end());
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) return;
+
+        // a troca para binário acontece logo após este ack
+        if (line.find("\"op\":\"ack\"") != std::string::npos &&
+            line.find("\"msg\":\"binary\"") != std::string::npos) {
+            binary_ = true;
+        }
+        if (takeReply(line)) return;
+        lines_.push_back(line);
+        if (onText) onText(line);
+        return;
+    }
+
+    if (unit.empty()) return;
+
+    uint8_t type;
+    const uint8_t *pl;
+    size_t plen;
+    if (!serial_bin_unframe(unit.data(), unit.size(), &type, &pl, &plen)) {
+        stats_.bad++;
+        if (onText) onText(std::string(unit.begin(), unit.end()));
+        return;
+    }
+    stats_.frames++;
+
+    switch (type) {
+    case SERIAL_BIN_T_ACK:
+        if (plen >= 2) {
+            ack_seen_ = true;
+            ack_req_ = pl[0];
+            ack_status_ = pl[1];
+            if (onAck) onAck(pl[0], pl[1]);
+            if (pl[0] == SERIAL_BIN_T_TEXT) binary_ = false;
+        }
+        break;
+
+    case SERIAL_BIN_T_TELEMETRY:
+        if (plen == SERIAL_BIN_TELE_LEN) {
+            serial_bin_tele_t t;
+            serial_bin_get_tele(pl, &t);
+            stats_.telemetry++;
+            if (onTelemetry) onTelemetry(t);
+        }
+        break;
+
+    case SERIAL_BIN_T_LUX:
+        if (plen == 8) {
+            uint32_t t_ms = 0, lx = 0;
+            for (int i = 0; i < 4; i++) {
+                t_ms |= static_cast<uint32_t>(pl[i]) << (8 * i);
+                lx   |= static_cast<uint32_t>(pl[4 + i]) << (8 * i);
+            }
+            stats_.lux++;
+            if (onLux) onLux(t_ms, static_cast<float>(static_cast<int32_t>(lx)) / 100.0f);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool Client::takeReply(const std::string &line)
+{
+    if (inflight_.empty()) return false;
+
+    size_t k = line.find("\"id\":");
+    if (k == std::string::npos) return false;
+    uint32_t id = static_cast<uint32_t>(std::strtoul(line.c_str() + k + 5, nullptr, 10));
+
+    auto it = inflight_.find(id);
+    if (it == inflight_.end()) return false;
+
+    double lat = std::chrono::duration<double, std::micro>(Clock::now() - it->second).count();
+    inflight_.erase(it);
+    stats_.replies++;
+    if (line.find("\"op\":\"err\"") != std::string::npos) stats_.errors++;
+    if (onReply) onReply(id, line, lat);
+    return true;
+}
+
+size_t Client::poll(int timeout_ms)
+{
+    pollfd pf{fd_, POLLIN, 0};
+    if (::poll(&pf, 1, timeout_ms) <= 0) return 0;
+
+    uint8_t buf[4096];
+    ssize_t n = ::read(fd_, buf, sizeof(buf));
+    if (n <= 0) return 0;
+    stats_.rx_bytes += static_cast<uint64_t>(n);
+
+    for (ssize_t i = 0; i < n; i++) {
+        uint8_t c = buf[i];
+        // o delimitador depende do modo vigente (pode mudar no meio do bloco lido)
+        if ((binary_ && c == 0x00) || (!binary_ && c == '\n')) {
+            handleUnit(acc_);
+            acc_.clear();
+        } else {
+            acc_.push_back(c);
+        }
+    }
+    return static_cast<size_t>(n);
+}
+
+bool Client::waitLine(const std::string &needle, int timeout_ms, std::string *out)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        for (auto it = lines_.begin(); it != lines_.end(); ++it) {
+            if (it->find(needle) != std::string::npos) {
+                if (out) *out = *it;
+                lines_.erase(lines_.begin(), it + 1);
+                return true;
+            }
+        }
+        lines_.clear();
+        int left = remaining_ms(deadline);
+        if (left == 0) return false;
+        poll(left);
+    }
+}
+
+bool Client::authenticate(const std::string &password, int timeout_ms)
+{
+    sendLine("{\"op\":\"auth\",\"password\":\"" + password + "\"}");
+    std::string l;
+    if (!waitLine("\"op\":\"auth\"", timeout_ms, &l)) return false;
+    return l.find("\"ok\":true") != std::string::npos;
+}
+
+bool Client::enterBinary(int timeout_ms)
+{
+    sendLine("{\"op\":\"binary\"}");
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!binary_) {
+        int left = remaining_ms(deadline);
+        if (left == 0) return false;
+        poll(left);
+    }
+    lines_.clear();
+    return true;
+}
+
+uint32_t Client::submit(const std::string &json, int timeout_ms)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (inflight_.size() >= window_) {
+        int left = remaining_ms(deadline);
+        if (left == 0) return 0;
+        poll(left);
+    }
+
+    uint32_t id = next_id_++;
+    if (next_id_ == 0) next_id_ = 1;
+
+    // {"op":...} -> {"id":N,"op":...}
+    size_t b = json.find('{');
+    if (b == std::string::npos) throw std::runtime_error("submit: esperado objeto JSON");
+    size_t f = json.find_first_not_of(" \t", b + 1);
+    bool empty = (f == std::string::npos || json[f] == '}');
+    std::string l = "{\"id\":" + std::to_string(id) + (empty ? "" : ",") + json.substr(b + 1);
+
+    inflight_[id] = Clock::now();
+    sendLine(l);
+    return id;
+}
+
+bool Client::drain(int timeout_ms)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!inflight_.empty()) {
+        int left = remaining_ms(deadline);
+        if (left == 0) return false;
+        poll(left);
+    }
+    return true;
+}
+
+bool Client::request(uint8_t type, const uint8_t *payload, size_t len, int timeout_ms, uint8_t *status)
+{
+    ack_seen_ = false;
+    sendFrame(type, payload, len);
+
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!(ack_seen_ && ack_req_ == type)) {
+        int left = remaining_ms(deadline);
+        if (left == 0) return false;
+        poll(left);
+    }
+    if (status) *status = ack_status_;
+    return ack_status_ == SERIAL_BIN_OK;
+}
+
+bool Client::ping(int timeout_ms)
+{
+    return request(SERIAL_BIN_T_PING, nullptr, 0, timeout_ms);
+}
+
+bool Client::sendCmd(const serial_bin_cmd_t &cmd, int timeout_ms)
+{
+    uint8_t p[SERIAL_BIN_CMD_LEN];
+    serial_bin_put_cmd(p, &cmd);
+    return request(SERIAL_BIN_T_CMD, p, sizeof(p), timeout_ms);
+}
+
+bool Client::leaveBinary(int timeout_ms)
+{
+    return request(SERIAL_BIN_T_TEXT, nullptr, 0, timeout_ms);
+}
+
+} // namespace serialrpc
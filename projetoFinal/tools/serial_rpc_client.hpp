@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * @file serial_rpc_client.hpp
+ * @brief Cliente host (POSIX) do SerialRPC: JSON por linha e modo binário COBS/CRC-16.
+ *
+ * Usa o mesmo serial_bin.c do firmware para quadros, CRC e layouts.
+ *
+ * Compilação (a partir de projetoFinal/tools):
+ *   gcc -O2 -c -I../include ../src/serial_bin.c -o serial_bin.o
+ *   g++ -std=c++17 -O2 -I../include <programa>.cpp serial_rpc_client.cpp serial_bin.o
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "serial_bin.h"
+
+namespace serialrpc {
+
+class Client {
+public:
+    struct Stats {
+        uint64_t rx_bytes  = 0;
+        uint64_t tx_bytes  = 0;
+        uint64_t frames    = 0;   ///< quadros binários válidos
+        uint64_t bad       = 0;   ///< unidades com COBS/CRC inválido (texto intercalado etc.)
+        uint64_t telemetry = 0;
+        uint64_t lux       = 0;
+        uint64_t replies   = 0;   ///< respostas JSON casadas por "id"
+        uint64_t errors    = 0;   ///< dessas, quantas foram {"op":"err"}
+    };
+
+    /// Abre a porta (ex.: /dev/ttyACM0) em modo raw. Lança std::runtime_error.
+    explicit Client(const std::string &device);
+    /// Usa um descritor já aberto (ex.: lado mestre de um pty). Não fecha ao destruir.
+    explicit Client(int fd);
+    ~Client();
+
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    // ---- modo JSON ----
+    void sendLine(const std::string &json);
+    /// Espera uma linha JSON contendo `needle`; outras linhas vão para onText.
+    bool waitLine(const std::string &needle, int timeout_ms, std::string *out = nullptr);
+    bool authenticate(const std::string &password, int timeout_ms = 1000);
+    /// {"op":"binary"} + espera o ack; a partir daí só quadros.
+    bool enterBinary(int timeout_ms = 1000);
+
+    // ---- pipelining (modo JSON) ----
+    /// Acrescenta "id" ao objeto `json` e envia sem esperar a resposta. Com `window`
+    /// pedidos em voo, lê respostas até abrir espaço. Retorna o id (0 = timeout).
+    uint32_t submit(const std::string &json, int timeout_ms = 1000);
+    /// Espera as respostas de todos os pedidos em voo.
+    bool drain(int timeout_ms);
+    size_t inflight() const { return inflight_.size(); }
+    /// Pedidos em voo permitidos (o firmware anuncia a fila em "pipeline" no hello).
+    void setWindow(size_t w) { window_ = w ? w : 1; }
+
+    // ---- modo binário ----
+    void sendFrame(uint8_t type, const uint8_t *payload, size_t len);
+    /// Envia e espera o ACK do tipo; status em *status (se não nulo).
+    bool request(uint8_t type, const uint8_t *payload, size_t len, int timeout_ms, uint8_t *status = nullptr);
+    bool ping(int timeout_ms = 500);
+    bool sendCmd(const serial_bin_cmd_t &cmd, int timeout_ms = 500);
+    bool leaveBinary(int timeout_ms = 500);
+
+    /// Lê o que houver (até timeout_ms) e dispara os callbacks. Retorna bytes lidos.
+    size_t poll(int timeout_ms);
+
+    bool binary() const { return binary_; }
+    const Stats &stats() const { return stats_; }
+
+    std::function<void(const serial_bin_tele_t &)> onTelemetry;
+    std::function<void(uint32_t t_ms, float lux)>   onLux;
+    std::function<void(uint8_t req, uint8_t status)> onAck;
+    std::function<void(const std::string &)>       onText;
+    /// Resposta a um submit(): id, linha completa e latência envio -> resposta.
+    std::function<void(uint32_t id, const std::string &line, double latency_us)> onReply;
+
+private:
+    void writeAll(const uint8_t *p, size_t n);
+    void handleUnit(std::vector<uint8_t> &unit);
+    bool takeReply(const std::string &line);
+
+    int  fd_ = -1;
+    bool owns_fd_ = false;
+    bool binary_ = false;
+    std::vector<uint8_t> acc_;
+    std::vector<std::string> lines_;   ///< linhas JSON ainda não consumidas por waitLine
+    bool     ack_seen_ = false;
+    uint8_t  ack_req_ = 0;
+    uint8_t  ack_status_ = 0;
+    uint32_t next_id_ = 1;
+    size_t   window_ = 8;
+    std::unordered_map<uint32_t, std::chrono::steady_clock::time_point> inflight_;
+    Stats stats_;
+};
+
+} // namespace serialrpc
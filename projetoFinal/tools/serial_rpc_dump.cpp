@@ -0,0 +1,136 @@
+/**
+ * @file serial_rpc_dump.cpp
+ * @brief Baixa o histórico do dispositivo (op "dump") em CSV, com créditos e retomada.
+ *
+ * Uso: serial_rpc_dump /dev/ttyACM0 [senha] [from_ms] [to_ms] [credito] > hist.csv
+ *
+ * Mantém `credito` blocos liberados (devolve um "dump_credit" por bloco recebido).
+ * Se a transferência parar (timeout), repete o pedido com "offset" = último "next".
+ * Ao final informa quadros, bytes e vazão em stderr.
+ *
+ * Compilação: ver serial_rpc_client.hpp.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "serial_rpc_client.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/// Valor numérico de "key":N na linha (0 se ausente).
+long long num(const std::string &l, const char *key)
+{
+    std::string k = std::string("\"") + key + "\":";
+    size_t p = l.find(k);
+    return (p == std::string::npos) ? 0 : std::strtoll(l.c_str() + p + k.size(), nullptr, 10);
+}
+
+/// Array de inteiros "key":[a,b,...].
+std::vector<long long> arr(const std::string &l, const char *key)
+{
+    std::vector<long long> v;
+    std::string k = std::string("\"") + key + "\":[";
+    size_t p = l.find(k);
+    if (p == std::string::npos) return v;
+    const char *s = l.c_str() + p + k.size();
+    while (*s && *s != ']') {
+        char *e;
+        v.push_back(std::strtoll(s, &e, 10));
+        s = (*e == ',') ? e + 1 : e;
+    }
+    return v;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "uso: %s <tty> [senha] [from_ms] [to_ms] [credito]\n", argv[0]);
+        return 2;
+    }
+    const std::string dev  = argv[1];
+    const std::string pass = (argc > 2) ? argv[2] : "1234";
+    const long long from   = (argc > 3) ? std::atoll(argv[3]) : 0;
+    const long long to     = (argc > 4) ? std::atoll(argv[4]) : -1;
+    const int credit       = (argc > 5) ? std::atoi(argv[5]) : 8;
+
+    try {
+        serialrpc::Client c(dev);
+        if (!c.authenticate(pass)) { std::fprintf(stderr, "auth falhou\n"); return 1; }
+
+        std::vector<double> scale = { 1, 100, 100, 1 };
+        long long next = -1, rows = 0, lost = 0;
+        bool done = false;
+
+        c.onText = [&](const std::string &l) {
+            if (l.find("\"op\":\"dump_chunk\"") != std::string::npos) {
+                long long t = num(l, "t0");
+                auto dt = arr(l, "dt"), lux = arr(l, "lux"), temp = arr(l, "temp");
+                auto hum = arr(l, "hum"), perc = arr(l, "perc");
+                long long off = num(l, "off");
+                for (size_t i = 0; i < dt.size() && i < lux.size() && i < temp.size() &&
+                                   i < hum.size() && i < perc.size(); i++) {
+                    t += dt[i];
+                    std::printf("%lld,%lld,%g,%g,%g,%g\n", off + static_cast<long long>(i), t,
+                                lux[i] / scale[0], temp[i] / scale[1], hum[i] / scale[2], perc[i] / scale[3]);
+                    rows++;
+                }
+                next = num(l, "next");
+                c.sendLine("{\"op\":\"dump_credit\",\"n\":1}");
+            } else if (l.find("\"op\":\"dump_end\"") != std::string::npos) {
+                next = num(l, "next");
+                lost += num(l, "lost");
+                done = true;
+            } else if (l.find("\"op\":\"dump\"") != std::string::npos) {
+                auto sc = arr(l, "scale");
+                for (size_t i = 0; i < sc.size() && i < scale.size(); i++) scale[i] = sc[i] ? sc[i] : 1;
+                if (next < 0) std::fprintf(stderr, "dump: first=%lld end=%lld\n", num(l, "first"), num(l, "end"));
+            }
+        };
+
+        std::printf("idx,t_ms,lux,temp,hum,perc\n");
+        auto t0 = Clock::now();
+        uint64_t rx0 = c.stats().rx_bytes;
+        int retries = 0;
+
+        while (!done && retries < 3) {
+            std::string req = "{\"op\":\"dump\",\"id\":1,\"credit\":" + std::to_string(credit) +
+                              ",\"from_ms\":" + std::to_string(from);
+            if (to >= 0)   req += ",\"to_ms\":" + std::to_string(to);
+            if (next >= 0) req += ",\"offset\":" + std::to_string(next);   // retomada
+            c.sendLine(req + "}");
+
+            // sem bloco por 2 s: considera a transferência parada e retoma
+            long long seen = rows;
+            auto last = Clock::now();
+            while (!done && Clock::now() - last < std::chrono::seconds(2)) {
+                c.poll(100);
+                if (rows != seen) { seen = rows; last = Clock::now(); }
+            }
+            if (!done) {
+                c.sendLine("{\"op\":\"dump_stop\"}");
+                auto stop = Clock::now() + std::chrono::milliseconds(500);
+                while (!done && Clock::now() < stop) c.poll(50);   // dump_end traz o "next"
+                done = false;
+                retries++;
+            }
+        }
+
+        double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+        double bytes = static_cast<double>(c.stats().rx_bytes - rx0);
+        std::fprintf(stderr, "dump: quadros=%lld perdidos=%lld %.2fs %.0f quadros/s %.0f B/s%s\n",
+                     rows, lost, dt, rows / dt, bytes / dt, done ? "" : " (incompleto)");
+        return done ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "erro: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,411 @@
+/**
+ * @file serial_rpc_load.cpp
+ * @brief Carga e latência do SerialRPC em JSON (hello/auth/cmd/telemetria), com CSV.
+ *
+ * Uso: serial_rpc_load <tty|--sim> [opções]
+ *   --pass P          senha (1234)
+ *   --rtt N           round-trips "cmd" com um pedido em voo por vez (500)
+ *   --rates a,b,...   degraus de comandos/s (50,100,200,500,1000,2000,5000)
+ *   --seconds S       duração de cada degrau (5)
+ *   --csv ARQ         acrescenta uma linha por fase (cabeçalho se o arquivo for novo)
+ *   --sim-cost-us U   --sim: custo de cada "cmd" no dublê (200)
+ *
+ * Fases:
+ * 1) rtt: latência ida e volta de "cmd" (p50/p90/p99/máx);
+ * 2) rate: degraus de taxa em malha aberta, com janela igual ao "pipeline" do hello.
+ *    Um degrau é sustentado se atinge >= 95% da taxa, sem erros nem respostas
+ *    faltando; a maior taxa sustentada vai para a saída e para o CSV;
+ * 3) em todas as fases: telemetria recebida, maior intervalo entre linhas e seq perdidos.
+ *
+ * --sim: sem placa, cria um pty e roda um dublê do firmware numa thread (mesmas
+ * respostas e "id" ecoado, telemetria a cada 200 ms quando autenticado). Serve para
+ * validar a ferramenta e o CSV; os números só valem para a placa real.
+ *
+ * Compilação: ver serial_rpc_client.hpp (acrescentar -pthread).
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "serial_rpc_client.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// ------------------------------------------------------------
+// Dublê do firmware (pty)
+// ------------------------------------------------------------
+class SimDevice {
+public:
+    explicit SimDevice(int cost_us) : cost_us_(cost_us)
+    {
+        master_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_ < 0 || ::grantpt(master_) != 0 || ::unlockpt(master_) != 0)
+            throw std::runtime_error("posix_openpt falhou");
+
+        slave_ = ::open(::ptsname(master_), O_RDWR | O_NOCTTY);
+        if (slave_ < 0) throw std::runtime_error("abrir pty escravo falhou");
+        termios tio{};
+        tcgetattr(slave_, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave_, TCSANOW, &tio);
+
+        int fl = ::fcntl(master_, F_GETFL);
+        ::fcntl(master_, F_SETFL, fl | O_NONBLOCK);
+
+        th_ = std::thread([this] { run(); });
+    }
+
+    ~SimDevice()
+    {
+        stop_ = true;
+        th_.join();
+        ::close(slave_);
+        ::close(master_);
+    }
+
+    /// Lado do host (o Client não fecha).
+    int hostFd() const { return master_; }
+
+private:
+    void send(const std::string &l)
+    {
+        std::string s = l + "\n";
+        const char *p = s.data();
+        size_t n = s.size();
+        while (n > 0) {
+            ssize_t w = ::write(slave_, p, n);
+            if (w <= 0) return;
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+    }
+
+    static std::string field(const std::string &l, const char *key)
+    {
+        std::string k = std::string("\"") + key + "\":";
+        size_t p = l.find(k);
+        if (p == std::string::npos) return {};
+        p += k.size();
+        size_t e = p;
+        if (l[p] == '"') e = l.find('"', p + 1) + 1;
+        else             e = l.find_first_of(",}", p);
+        return l.substr(p, e - p);
+    }
+
+    void handle(const std::string &l)
+    {
+        std::string op = field(l, "op");
+        std::string id = field(l, "id");
+        auto reply = [&](const std::string &o, const std::string &rest) {
+            send("{\"op\":\"" + o + "\"" + (id.empty() ? "" : ",\"id\":" + id) + rest + "}");
+        };
+
+        if (op == "\"hello\"") {
+            reply("hello", ",\"device\":\"sim\",\"fw\":\"pico-serial-v1\",\"need_auth\":" +
+                  std::string(authed_ ? "false" : "true") + ",\"bin\":false,\"pipeline\":8");
+        } else if (op == "\"auth\"") {
+            authed_ = (field(l, "password") == "\"1234\"");
+            reply("auth", std::string(",\"ok\":") + (authed_ ? "true" : "false"));
+            if (authed_) reply("ack", ",\"ok\":true,\"msg\":\"auth ok\"");
+        } else if (op == "\"cmd\"") {
+            if (!authed_) { reply("err", ",\"msg\":\"not authenticated\""); return; }
+            auto until = Clock::now() + std::chrono::microseconds(cost_us_);
+            while (Clock::now() < until) { }     // custo do tratamento (CPU ocupada)
+            reply("ack", ",\"ok\":true,\"msg\":\"cmd applied\"");
+        } else {
+            reply("err", ",\"msg\":\"unknown op\"");
+        }
+    }
+
+    void run()
+    {
+        std::string acc;
+        uint32_t seq = 0;
+        auto t0 = Clock::now();
+        auto next_tele = t0;
+        send("{\"op\":\"hello\",\"device\":\"sim\",\"need_auth\":true}");
+
+        while (!stop_) {
+            auto now = Clock::now();
+            if (authed_ && now >= next_tele) {
+                next_tele += std::chrono::milliseconds(200);
+                uint32_t t_ms = static_cast<uint32_t>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(now - t0).count());
+                send("{\"op\":\"telemetry\",\"device\":\"sim\",\"lux\":100.00,\"seq\":" +
+                     std::to_string(++seq) + ",\"t_ms\":" + std::to_string(t_ms) + "}");
+            }
+            if (!authed_) next_tele = now;
+
+            pollfd pf{slave_, POLLIN, 0};
+            if (::poll(&pf, 1, 5) <= 0) continue;
+            char buf[1024];
+            ssize_t n = ::read(slave_, buf, sizeof(buf));
+            for (ssize_t i = 0; i < n; i++) {
+                if (buf[i] == '\n') { handle(acc); acc.clear(); }
+                else if (buf[i] != '\r') acc.push_back(buf[i]);
+            }
+        }
+    }
+
+    int master_ = -1;
+    int slave_ = -1;
+    int cost_us_;
+    bool authed_ = false;
+    std::atomic<bool> stop_{false};
+    std::thread th_;
+};
+
+// ------------------------------------------------------------
+// Medidas
+// ------------------------------------------------------------
+struct TeleWatch {
+    uint64_t frames = 0;
+    uint64_t seq_lost = 0;
+    double   gap_max_ms = 0;
+    uint32_t last_seq = 0;
+    Clock::time_point last{};
+
+    void reset() { frames = 0; seq_lost = 0; gap_max_ms = 0; last = Clock::time_point{}; }
+
+    void onLine(const std::string &l)
+    {
+        if (l.find("\"op\":\"telemetry\"") == std::string::npos) return;
+        auto now = Clock::now();
+        if (frames > 0 || last != Clock::time_point{}) {
+            gap_max_ms = std::max(gap_max_ms, std::chrono::duration<double, std::milli>(now - last).count());
+        }
+        last = now;
+        frames++;
+
+        size_t k = l.find("\"seq\":");
+        if (k == std::string::npos) return;
+        uint32_t seq = static_cast<uint32_t>(std::strtoul(l.c_str() + k + 6, nullptr, 10));
+        if (last_seq && seq > last_seq + 1) seq_lost += seq - last_seq - 1;
+        last_seq = seq;
+    }
+};
+
+struct Row {
+    std::string phase;
+    double   target = 0;      ///< cmd/s pedidos (0 = rtt)
+    uint64_t sent = 0, replies = 0, errors = 0;
+    double   achieved = 0;
+    double   p50 = 0, p90 = 0, p99 = 0, max = 0;
+    uint64_t tele = 0, tele_lost = 0;
+    double   tele_gap_ms = 0;
+    bool     sustained = false;
+};
+
+double pct(const std::vector<double> &v, int p)
+{
+    if (v.empty()) return 0;
+    return v[std::min(v.size() - 1, v.size() * static_cast<size_t>(p) / 100)];
+}
+
+void fill_lat(Row &r, std::vector<double> &lat)
+{
+    std::sort(lat.begin(), lat.end());
+    r.p50 = pct(lat, 50);
+    r.p90 = pct(lat, 90);
+    r.p99 = pct(lat, 99);
+    r.max = lat.empty() ? 0 : lat.back();
+}
+
+void print_row(const Row &r)
+{
+    std::printf("%-5s alvo=%6.0f/s enviados=%llu respostas=%llu erros=%llu obtido=%7.1f/s "
+                "p50=%.0fus p90=%.0fus p99=%.0fus max=%.0fus tele=%llu gap=%.0fms seq_perdidos=%llu%s\n",
+                r.phase.c_str(), r.target,
+                static_cast<unsigned long long>(r.sent), static_cast<unsigned long long>(r.replies),
+                static_cast<unsigned long long>(r.errors), r.achieved, r.p50, r.p90, r.p99, r.max,
+                static_cast<unsigned long long>(r.tele), r.tele_gap_ms,
+                static_cast<unsigned long long>(r.tele_lost),
+                r.phase == "rate" ? (r.sustained ? " ok" : " NAO sustentado") : "");
+}
+
+void write_csv(const std::string &path, const std::string &target, const std::vector<Row> &rows,
+               double max_rate)
+{
+    bool fresh = (::access(path.c_str(), F_OK) != 0);
+    FILE *f = std::fopen(path.c_str(), "a");
+    if (!f) throw std::runtime_error("abrir " + path + ": " + std::strerror(errno));
+    if (fresh) {
+        std::fprintf(f, "run_unix,target,phase,rate_target,sent,replies,errors,rate_achieved,"
+                        "p50_us,p90_us,p99_us,max_us,tele_frames,tele_gap_max_ms,tele_seq_lost,"
+                        "sustained,max_sustained_rate\n");
+    }
+    long long run = static_cast<long long>(std::time(nullptr));
+    for (const Row &r : rows) {
+        std::fprintf(f, "%lld,%s,%s,%.0f,%llu,%llu,%llu,%.1f,%.0f,%.0f,%.0f,%.0f,%llu,%.1f,%llu,%d,%.0f\n",
+                     run, target.c_str(), r.phase.c_str(), r.target,
+                     static_cast<unsigned long long>(r.sent), static_cast<unsigned long long>(r.replies),
+                     static_cast<unsigned long long>(r.errors), r.achieved, r.p50, r.p90, r.p99, r.max,
+                     static_cast<unsigned long long>(r.tele), r.tele_gap_ms,
+                     static_cast<unsigned long long>(r.tele_lost), r.sustained ? 1 : 0, max_rate);
+    }
+    std::fclose(f);
+}
+
+std::string cmd_json(uint64_t i)
+{
+    return "{\"op\":\"cmd\",\"mode\":\"manual\",\"percent\":" + std::to_string(i % 101) + "}";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "uso: %s <tty|--sim> [--pass P] [--rtt N] [--rates a,b,...] "
+                             "[--seconds S] [--csv ARQ] [--sim-cost-us U]\n", argv[0]);
+        return 2;
+    }
+
+    std::string dev = argv[1], pass = "1234", csv;
+    int rtt_n = 500, seconds = 5, sim_cost = 200;
+    std::vector<double> rates = { 50, 100, 200, 500, 1000, 2000, 5000 };
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string k = argv[i], v = argv[i + 1];
+        if      (k == "--pass")        pass = v;
+        else if (k == "--rtt")         rtt_n = std::atoi(v.c_str());
+        else if (k == "--seconds")     seconds = std::max(1, std::atoi(v.c_str()));
+        else if (k == "--csv")         csv = v;
+        else if (k == "--sim-cost-us") sim_cost = std::atoi(v.c_str());
+        else if (k == "--rates") {
+            rates.clear();
+            for (const char *s = v.c_str(); *s; ) {
+                char *e;
+                double r = std::strtod(s, &e);
+                if (e == s) break;
+                if (r > 0) rates.push_back(r);
+                s = (*e == ',') ? e + 1 : e;
+            }
+        } else {
+            std::fprintf(stderr, "opção desconhecida: %s\n", k.c_str());
+            return 2;
+        }
+    }
+
+    try {
+        std::unique_ptr<SimDevice> sim;
+        std::unique_ptr<serialrpc::Client> cp;
+        if (dev == "--sim") {
+            sim.reset(new SimDevice(sim_cost));
+            cp.reset(new serialrpc::Client(sim->hostFd()));
+        } else {
+            cp.reset(new serialrpc::Client(dev));
+        }
+        serialrpc::Client &c = *cp;
+
+        TeleWatch tw;
+        c.onText = [&](const std::string &l) { tw.onLine(l); };
+
+        if (!c.authenticate(pass)) { std::fprintf(stderr, "auth falhou\n"); return 1; }
+
+        // janela = fila anunciada pelo firmware
+        std::string hello;
+        c.sendLine("{\"op\":\"hello\"}");
+        if (c.waitLine("\"op\":\"hello\"", 1000, &hello)) {
+            size_t k = hello.find("\"pipeline\":");
+            if (k != std::string::npos) c.setWindow(std::strtoul(hello.c_str() + k + 11, nullptr, 10));
+        }
+
+        std::vector<Row> rows;
+        std::vector<double> lat;
+        c.onReply = [&](uint32_t, const std::string &, double us) { lat.push_back(us); };
+
+        // --- 1) rtt: um pedido em voo ---
+        {
+            Row r;
+            r.phase = "rtt";
+            lat.clear();
+            tw.reset();
+            auto s0 = c.stats();
+            auto t0 = Clock::now();
+            for (int i = 0; i < rtt_n; i++) {
+                if (c.submit(cmd_json(static_cast<uint64_t>(i))) == 0) break;
+                r.sent++;
+                if (!c.drain(1000)) break;
+            }
+            double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+            r.replies = c.stats().replies - s0.replies;
+            r.errors  = c.stats().errors - s0.errors;
+            r.achieved = r.replies / dt;
+            fill_lat(r, lat);
+            r.tele = tw.frames; r.tele_gap_ms = tw.gap_max_ms; r.tele_lost = tw.seq_lost;
+            r.sustained = (r.replies == r.sent && r.errors == 0);
+            rows.push_back(r);
+            print_row(r);
+        }
+
+        // --- 2) degraus de taxa (malha aberta, janela do pipeline) ---
+        double max_rate = 0;
+        uint64_t n = 0;
+        for (double rate : rates) {
+            Row r;
+            r.phase = "rate";
+            r.target = rate;
+            lat.clear();
+            tw.reset();
+            auto s0 = c.stats();
+            auto t0 = Clock::now();
+            auto end = t0 + std::chrono::seconds(seconds);
+            const auto step = std::chrono::duration<double>(1.0 / rate);
+            auto due = t0;
+
+            while (Clock::now() < end) {
+                auto now = Clock::now();
+                if (now < due) {
+                    c.poll(static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count()));
+                    continue;
+                }
+                if (c.submit(cmd_json(n++), 1000) == 0) break;   // janela travada 1 s: desiste
+                r.sent++;
+                due += std::chrono::duration_cast<Clock::duration>(step);
+                // atrasou (janela cheia): não acumula rajada, a taxa obtida mostra o limite
+                if (Clock::now() - due > std::chrono::milliseconds(100)) due = Clock::now();
+            }
+            bool drained = c.drain(2000);
+            double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+
+            r.replies  = c.stats().replies - s0.replies;
+            r.errors   = c.stats().errors - s0.errors;
+            r.achieved = r.replies / dt;
+            fill_lat(r, lat);
+            r.tele = tw.frames; r.tele_gap_ms = tw.gap_max_ms; r.tele_lost = tw.seq_lost;
+            r.sustained = drained && r.errors == 0 && r.replies == r.sent && r.achieved >= 0.95 * rate;
+            rows.push_back(r);
+            print_row(r);
+
+            if (!r.sustained) break;
+            max_rate = rate;
+        }
+
+        std::printf("taxa maxima sustentada: %.0f cmd/s%s\n", max_rate, sim ? " (dublê pty)" : "");
+        if (!csv.empty()) write_csv(csv, sim ? "sim" : dev, rows, max_rate);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "erro: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
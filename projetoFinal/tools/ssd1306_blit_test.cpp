@@ -0,0 +1,392 @@
+/**
+ * @file ssd1306_blit_test.cpp
+ * @brief Teste no host do driver SSD1306 (src/ssd1306.c): blitter de colunas e lista de DMA.
+ *
+ * Uso: ssd1306_blit_test [passos] [semente]      (padrão: 200000, 1)
+ *
+ * O driver é compilado contra host/ (DMA, IRQ e I2C falsos, implementados aqui). Quando
+ * o canal de controle é disparado, a lista de blocos (count, addr) é executada como no
+ * hardware e as palavras de IC_DATA_CMD vão para um painel simulado (comandos 0x21/0x22,
+ * endereçamento horizontal). Em paralelo, o mesmo desenho é feito por uma cópia do
+ * caminho antigo (um ssd1306_draw_pixel por pixel do glifo) num framebuffer de referência.
+ *
+ * Confere, a cada ssd1306_show():
+ *  - painel simulado == referência, byte a byte (texto em todo x/y, inclusive cortado
+ *    na borda, caracteres fora da fonte, pixels, clear_pages, scroll_left);
+ *  - bytes no barramento == last_stats.bytes;
+ * e ainda campos retidos (só caracteres alterados, mesmo resultado que redesenhar tudo)
+ * e o abort: refresh interrompido, lista rearmada (write_addr/trans_count do canal de
+ * controle) e quadro seguinte completo e correto.
+ *
+ * Compilação (a partir de projetoFinal/tools; host/ substitui o SDK):
+ *   gcc -O2 -c -Ihost -I../include ../src/ssd1306.c -o ssd1306.o
+ *   g++ -std=c++17 -O2 -Ihost -I../include ssd1306_blit_test.cpp ssd1306.o -o ssd1306_blit_test
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "ssd1306.h"   // sem guarda extern "C" própria
+}
+#include "font6x8.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+namespace {
+
+constexpr int kPages = SSD1306_HEIGHT / 8;
+constexpr int kBytes = SSD1306_WIDTH * kPages;
+constexpr uint16_t kStop = I2C_IC_DATA_CMD_STOP_BITS;
+
+// mesmo formato de dma_cb_t em ssd1306.c (o que o canal de controle lê)
+struct Block {
+    uint32_t count;
+    const volatile void *addr;
+};
+
+// ---------------- painel simulado (lado do SSD1306) ----------------
+struct Panel {
+    uint8_t ram[kBytes] = {};
+    uint8_t c0 = 0, c1 = SSD1306_WIDTH - 1, p0 = 0, p1 = kPages - 1;
+    uint8_t col = 0, page = 0;
+    std::vector<uint8_t> tr;   // transação em curso
+    uint32_t bytes = 0;        // endereço + conteúdo de cada transação
+
+    void word(uint16_t w)
+    {
+        tr.push_back(static_cast<uint8_t>(w));
+        if (w & kStop) end();
+    }
+
+    void end()
+    {
+        bytes += 1u + static_cast<uint32_t>(tr.size());
+        if (!tr.empty() && tr[0] == 0x40) {
+            for (size_t i = 1; i < tr.size(); i++) data(tr[i]);
+        } else if (!tr.empty() && tr[0] == 0x00) {
+            commands();
+        }
+        tr.clear();
+    }
+
+    void data(uint8_t b)
+    {
+        ram[page * SSD1306_WIDTH + col] = b;
+        if (col++ >= c1) {
+            col = c0;
+            page = (page >= p1) ? p0 : page + 1;
+        }
+    }
+
+    void commands()
+    {
+        for (size_t i = 1; i < tr.size(); i++) {
+            uint8_t c = tr[i];
+            switch (c) {
+            case 0x21: c0 = col = tr.at(i + 1); c1 = tr.at(i + 2); i += 2; break;
+            case 0x22: p0 = page = tr.at(i + 1); p1 = tr.at(i + 2); i += 2; break;
+            case 0x20: case 0xA8: case 0xD3: case 0xDA: case 0x81: case 0xD5: case 0x8D: i += 1; break;
+            default: break;
+            }
+        }
+    }
+};
+
+Panel g_panel;
+irq_handler_t g_isr;
+bool g_irq_pending;
+bool g_irq_enabled;
+bool g_run_dma = true;       // false: disparo fica "preso" (simula NACK/timeout)
+int g_next_ch;
+uint32_t g_us;
+i2c_hw_t g_i2c_hw;
+volatile void *g_ctrl_write;  // write_addr do canal de controle (rearmado no abort)
+uint32_t g_ctrl_count;
+
+/** @brief Executa a lista do canal de controle até o bloco nulo. */
+void run_list(const Block *b)
+{
+    for (; b->count != 0; b++) {
+        const volatile uint16_t *w = static_cast<const volatile uint16_t *>(b->addr);
+        for (uint32_t i = 0; i < b->count; i++) g_panel.word(w[i]);
+    }
+    if (!g_panel.tr.empty()) {
+        std::printf("FALHA: lista terminou no meio de uma transação\n");
+        std::exit(1);
+    }
+    g_irq_pending = true;
+    if (g_irq_enabled && g_isr) g_isr();
+}
+
+} // namespace
+
+// ---------------- SDK falso (host/) ----------------
+extern "C" {
+
+dma_hw_t host_dma_hw;
+
+uint32_t time_us_32(void) { return g_us += 7u; }
+
+int dma_claim_unused_channel(bool) { return g_next_ch++; }
+dma_channel_config dma_channel_get_default_config(uint) { return dma_channel_config{0}; }
+void channel_config_set_transfer_data_size(dma_channel_config *, enum dma_channel_transfer_size) {}
+void channel_config_set_read_increment(dma_channel_config *, bool) {}
+void channel_config_set_write_increment(dma_channel_config *, bool) {}
+void channel_config_set_dreq(dma_channel_config *, uint) {}
+void channel_config_set_chain_to(dma_channel_config *, uint) {}
+void channel_config_set_irq_quiet(dma_channel_config *, bool) {}
+void channel_config_set_ring(dma_channel_config *, bool, uint) {}
+
+void dma_channel_configure(uint ch, const dma_channel_config *, volatile void *write_addr, const volatile void *,
+                           uint count, bool)
+{
+    if (ch == 1u) {   // controle (segundo canal reservado)
+        g_ctrl_write = write_addr;
+        g_ctrl_count = count;
+    }
+}
+
+void dma_channel_set_read_addr(uint, const volatile void *read_addr, bool trigger)
+{
+    if (trigger && g_run_dma) run_list(static_cast<const Block *>(const_cast<const void *>(read_addr)));
+}
+
+void dma_channel_set_write_addr(uint ch, volatile void *write_addr, bool)
+{
+    if (ch == 1u) g_ctrl_write = write_addr;
+}
+
+void dma_channel_set_trans_count(uint ch, uint32_t count, bool)
+{
+    if (ch == 1u) g_ctrl_count = count;
+}
+
+void dma_channel_set_irq1_enabled(uint, bool enabled) { g_irq_enabled = enabled; }
+bool dma_channel_get_irq1_status(uint) { return g_irq_pending; }
+void dma_channel_acknowledge_irq1(uint) { g_irq_pending = false; }
+void dma_channel_abort(uint)
+{
+    // RP2040-E13: o abort pode levantar a IRQ de fim
+    g_irq_pending = true;
+    g_ctrl_write = nullptr;
+    g_ctrl_count = 1;
+    g_panel.tr.clear();
+}
+
+void irq_add_shared_handler(uint, irq_handler_t handler, uint8_t) { g_isr = handler; }
+void irq_set_enabled(uint, bool) {}
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *) { return &g_i2c_hw; }
+uint i2c_get_dreq(i2c_inst_t *, bool) { return 0; }
+
+int i2c_write_blocking(i2c_inst_t *, uint8_t, const uint8_t *src, size_t len, bool)
+{
+    for (size_t i = 0; i < len; i++) g_panel.word(static_cast<uint16_t>(src[i] | (i + 1 == len ? kStop : 0u)));
+    return static_cast<int>(len);
+}
+
+} // extern "C"
+
+namespace {
+
+// ---------------- referência: caminho antigo, pixel a pixel ----------------
+uint8_t g_ref[kBytes];
+
+void ref_pixel(uint8_t x, uint8_t y, bool color)
+{
+    if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) return;
+    uint8_t &b = g_ref[x + (y / 8) * SSD1306_WIDTH];
+    if (color) b |= static_cast<uint8_t>(1u << (y % 8));
+    else       b &= static_cast<uint8_t>(~(1u << (y % 8)));
+}
+
+// cópia de ssd1306_draw_string() anterior ao blitter de colunas
+void ref_string(uint8_t x, uint8_t y, const char *text)
+{
+    while (*text) {
+        char c = *text++;
+        if (c < 32 || c > 126) c = '?';
+        for (uint8_t i = 0; i < 5; i++) {
+            uint8_t line = font6x8[(c - 32) * 5 + i];
+            for (uint8_t j = 0; j < 8; j++) {
+                bool pixel = line & (1 << j);
+                ref_pixel(x + i, y + j, pixel);
+            }
+        }
+        x += 6;
+    }
+}
+
+void ref_clear_pages(int p0, int p1)
+{
+    for (int p = p0; p <= p1; p++) std::memset(&g_ref[p * SSD1306_WIDTH], 0, SSD1306_WIDTH);
+}
+
+void ref_scroll_left(int p0, int p1)
+{
+    for (int p = p0; p <= p1; p++) {
+        uint8_t *row = &g_ref[p * SSD1306_WIDTH];
+        std::memmove(row, row + 1, SSD1306_WIDTH - 1);
+        row[SSD1306_WIDTH - 1] = 0;
+    }
+}
+
+int g_fail = 0;
+long g_shows = 0;
+uint64_t g_wire = 0;
+
+void show_and_compare(const char *what, long step)
+{
+    uint32_t before = g_panel.bytes;
+    ssd1306_show();
+
+    ssd1306_stats_t st;
+    ssd1306_get_stats(&st);
+    uint32_t sent = g_panel.bytes - before;
+    g_wire += sent;
+    g_shows++;
+
+    if (sent != st.bytes) {
+        std::printf("FALHA %s passo %ld: %u bytes no barramento, stats=%u\n", what, step, sent, st.bytes);
+        g_fail++;
+    }
+    for (int i = 0; i < kBytes; i++) {
+        if (g_panel.ram[i] != g_ref[i]) {
+            std::printf("FALHA %s passo %ld: página %d coluna %d painel=%02x referência=%02x\n", what, step,
+                        i / SSD1306_WIDTH, i % SSD1306_WIDTH, g_panel.ram[i], g_ref[i]);
+            g_fail++;
+            break;
+        }
+    }
+    if (g_fail) std::exit(1);
+}
+
+std::string random_text(std::mt19937 &rng, size_t max_len)
+{
+    std::string s(1 + rng() % max_len, ' ');
+    for (char &c : s) {
+        uint32_t r = rng() % 20;
+        c = (r == 0) ? static_cast<char>(1 + rng() % 31)              // controle -> '?'
+          : (r == 1) ? static_cast<char>(127 + rng() % 129)           // fora da fonte
+          : static_cast<char>(32 + rng() % 95);
+    }
+    return s;
+}
+
+void test_fields(std::mt19937 &rng)
+{
+    ssd1306_clear();
+    ref_clear_pages(0, kPages - 1);
+
+    ssd1306_field_t f[3];
+    const uint8_t fx[3] = { 0, 13, 40 }, fy[3] = { 0, 21, 50 }, fw[3] = { 21, 8, 14 };
+    for (int i = 0; i < 3; i++) ssd1306_field_init(&f[i], fx[i], fy[i], fw[i]);
+
+    for (long k = 0; k < 5000; k++) {
+        int i = static_cast<int>(rng() % 3);
+        std::string s = random_text(rng, fw[i] + 3u);
+        if (rng() % 50 == 0) {
+            ssd1306_field_invalidate(&f[i]);
+        }
+        ssd1306_field_set(&f[i], s.c_str());
+
+        // referência: redesenha o campo inteiro, completado com espaços
+        std::string padded = s.substr(0, fw[i]);
+        padded.resize(fw[i], ' ');
+        ref_string(fx[i], fy[i], padded.c_str());
+
+        show_and_compare("campo", k);
+    }
+}
+
+void test_abort(std::mt19937 &rng)
+{
+    for (long k = 0; k < 200; k++) {
+        std::string s = random_text(rng, 20);
+        uint8_t x = static_cast<uint8_t>(rng() % 128), y = static_cast<uint8_t>(rng() % 64);
+        ssd1306_draw_string(x, y, s.c_str());
+        ref_string(x, y, s.c_str());
+
+        // refresh preso: nada chega ao painel; abort rearma a lista e força quadro completo
+        g_run_dma = false;
+        bool started = ssd1306_show_start();
+        ssd1306_show_abort();
+        g_run_dma = true;
+
+        if (started && (g_ctrl_write != &dma_hw->ch[0].al3_transfer_count || g_ctrl_count != 2u)) {
+            std::printf("FALHA abort passo %ld: canal de controle não rearmado\n", k);
+            std::exit(1);
+        }
+        if (g_irq_pending) {
+            std::printf("FALHA abort passo %ld: IRQ de fim pendente após o abort\n", k);
+            std::exit(1);
+        }
+        show_and_compare("abort", k);
+
+        ssd1306_stats_t st;
+        ssd1306_get_stats(&st);
+        if (started && st.pages != kPages) {
+            std::printf("FALHA abort passo %ld: quadro após abort com %u páginas\n", k, st.pages);
+            std::exit(1);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const long steps = (argc > 1) ? std::atol(argv[1]) : 200000L;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(std::atoi(argv[2])) : 1u;
+    std::mt19937 rng(seed);
+
+    ssd1306_init(reinterpret_cast<i2c_inst_t *>(&g_i2c_hw));
+    show_and_compare("init", 0);
+
+    long strings = 0;
+    for (long k = 0; k < steps; k++) {
+        uint32_t op = rng() % 16;
+        if (op < 10) {
+            // x/y livres (inclui corte na borda direita/inferior); sem estourar x em uint8_t
+            std::string s = random_text(rng, 24);
+            uint8_t x = static_cast<uint8_t>(rng() % 140);
+            uint8_t y = static_cast<uint8_t>(rng() % 72);
+            if (x + 6u * s.size() > 255u) s.resize((255u - x) / 6u);
+            ssd1306_draw_string(x, y, s.c_str());
+            ref_string(x, y, s.c_str());
+            strings++;
+        } else if (op < 13) {
+            uint8_t x = static_cast<uint8_t>(rng() % 130), y = static_cast<uint8_t>(rng() % 66);
+            bool c = rng() & 1u;
+            ssd1306_draw_pixel(x, y, c);
+            ref_pixel(x, y, c);
+        } else if (op < 14) {
+            int p0 = static_cast<int>(rng() % kPages), p1 = p0 + static_cast<int>(rng() % 3);
+            ssd1306_scroll_left(static_cast<uint8_t>(p0), static_cast<uint8_t>(p1));
+            ref_scroll_left(p0, p1 >= kPages ? kPages - 1 : p1);
+        } else if (op < 15) {
+            int p0 = static_cast<int>(rng() % kPages), p1 = p0 + static_cast<int>(rng() % 2);
+            ssd1306_clear_pages(static_cast<uint8_t>(p0), static_cast<uint8_t>(p1));
+            ref_clear_pages(p0, p1 >= kPages ? kPages - 1 : p1);
+        } else {
+            ssd1306_clear();
+            ref_clear_pages(0, kPages - 1);
+        }
+
+        if (rng() % 3 == 0) show_and_compare("desenho", k);
+    }
+    show_and_compare("desenho", steps);
+
+    test_fields(rng);
+    test_abort(rng);
+
+    std::printf("OK: %ld passos (%ld textos), %ld refreshes, %.1f bytes I2C/refresh (quadro cheio: %d)\n",
+                steps, strings, g_shows, static_cast<double>(g_wire) / g_shows, kPages * (8 + 1 + SSD1306_WIDTH + 1));
+    return 0;
+}
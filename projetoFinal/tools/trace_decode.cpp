@@ -0,0 +1,178 @@
+/**
+ * @file trace_decode.cpp
+ * @brief Decodifica o trace binário (app_trace) do console serial de volta para texto.
+ *
+ * Uso: trace_decode [/dev/ttyACM1 | arquivo | -]   (padrão: stdin)
+ *      (CDC de log do dispositivo composto; a primeira CDC é a do SerialRPC)
+ *
+ * Linhas "~<base64>" viram "[T c<core> <ms>] <texto formatado>"; as demais linhas do
+ * console (log em texto, JSON do SerialRPC) passam sem alteração. A tabela de formatos
+ * vem de include/app_trace_ids.h, a mesma lista que gera os ids no firmware.
+ *
+ * Compilação (a partir de projetoFinal/tools):
+ *   gcc -O2 -c -I../include ../src/serial_bin.c -o serial_bin.o
+ *   g++ -std=c++17 -O2 -I../include trace_decode.cpp serial_bin.o -o trace_decode
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "app_trace_ids.h"
+#include "serial_bin.h"
+
+namespace {
+
+#define TRACE_FMT(name, fmt) fmt,
+const char *const k_formats[] = { APP_TRACE_EVENTS(TRACE_FMT) };
+
+struct Stats {
+    uint64_t events = 0;
+    uint64_t bad    = 0;   ///< base64/CRC inválido ou id desconhecido
+};
+
+bool b64_decode(const char *s, size_t n, std::vector<uint8_t> &out)
+{
+    auto val = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    };
+
+    if (n % 4 != 0) return false;
+    out.clear();
+    for (size_t i = 0; i < n; i += 4) {
+        int v[4];
+        for (int k = 0; k < 4; k++) v[k] = (s[i + k] == '=') ? 0 : val(s[i + k]);
+        if (v[0] < 0 || v[1] < 0 || v[2] < 0 || v[3] < 0) return false;
+
+        uint32_t w = (uint32_t)v[0] << 18 | (uint32_t)v[1] << 12 | (uint32_t)v[2] << 6 | (uint32_t)v[3];
+        out.push_back(static_cast<uint8_t>(w >> 16));
+        if (s[i + 2] != '=') out.push_back(static_cast<uint8_t>(w >> 8));
+        if (s[i + 3] != '=') out.push_back(static_cast<uint8_t>(w));
+    }
+    return true;
+}
+
+uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/// printf com argumentos de 32 bits tipados pela própria string de formato.
+std::string format_args(const char *fmt, const uint32_t *args, size_t nargs)
+{
+    std::string out;
+    size_t ai = 0;
+
+    for (const char *p = fmt; *p; p++) {
+        if (*p != '%') { out += *p; continue; }
+        if (p[1] == '%') { out += '%'; p++; continue; }
+
+        // %[flags][largura][.precisão][comprimento]conversão
+        const char *start = p++;
+        while (*p && std::strchr("-+ #0123456789.hlLjzt", *p)) p++;
+        if (!*p) break;
+
+        // modificadores de comprimento saem: o tipo real é decidido pela conversão
+        std::string spec;
+        for (const char *q = start; q < p; q++) {
+            if (!std::strchr("hlLjzt", *q)) spec += *q;
+        }
+        spec += *p;
+
+        uint32_t a = (ai < nargs) ? args[ai++] : 0;
+        char buf[64];
+        if (std::strchr("di", *p)) {
+            std::snprintf(buf, sizeof(buf), spec.c_str(), static_cast<int>(static_cast<int32_t>(a)));
+        } else if (std::strchr("uxXoc", *p)) {
+            std::snprintf(buf, sizeof(buf), spec.c_str(), static_cast<unsigned>(a));
+        } else if (std::strchr("feEgG", *p)) {
+            float f;
+            std::memcpy(&f, &a, sizeof(f));
+            std::snprintf(buf, sizeof(buf), spec.c_str(), static_cast<double>(f));
+        } else {
+            std::snprintf(buf, sizeof(buf), "<%%%c?>", *p);
+        }
+        out += buf;
+    }
+    return out;
+}
+
+void handle_line(std::string line, Stats &st)
+{
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line[0] != '~') {
+        std::printf("%s\n", line.c_str());
+        return;
+    }
+
+    std::vector<uint8_t> raw;
+    if (!b64_decode(line.c_str() + 1, line.size() - 1, raw) || raw.size() < 10) { st.bad++; return; }
+
+    size_t n = raw.size() - 2;
+    uint16_t crc = static_cast<uint16_t>(raw[n] | raw[n + 1] << 8);
+    if (serial_bin_crc16(raw.data(), n) != crc) { st.bad++; return; }
+
+    uint16_t id = static_cast<uint16_t>(raw[0] | raw[1] << 8);
+    uint8_t nargs = raw[2];
+    uint8_t core = raw[3];
+    uint32_t t_us = get_u32(&raw[4]);
+    if (id >= TRACE_ID_COUNT || n != 8u + 4u * nargs) { st.bad++; return; }
+
+    uint32_t args[8] = {};
+    for (uint8_t i = 0; i < nargs && i < 8; i++) args[i] = get_u32(&raw[8 + 4 * i]);
+
+    st.events++;
+    std::printf("[T c%u %lu.%03lu] %s\n", core,
+                static_cast<unsigned long>(t_us / 1000000u), static_cast<unsigned long>((t_us / 1000u) % 1000u),
+                format_args(k_formats[id], args, nargs).c_str());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int fd = STDIN_FILENO;
+    if (argc > 1 && std::strcmp(argv[1], "-") != 0) {
+        fd = ::open(argv[1], O_RDONLY | O_NOCTTY);
+        if (fd < 0) { std::perror(argv[1]); return 1; }
+
+        termios tio{};
+        if (tcgetattr(fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(fd, TCSANOW, &tio);
+        }
+    }
+
+    Stats st;
+    std::string acc;
+    char buf[4096];
+    for (;;) {
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] == '\n') {
+                handle_line(acc, st);
+                acc.clear();
+            } else {
+                acc += buf[i];
+            }
+        }
+        std::fflush(stdout);
+    }
+    if (!acc.empty()) handle_line(acc, st);
+
+    std::fprintf(stderr, "trace_decode: %llu eventos, %llu invalidos\n",
+                 static_cast<unsigned long long>(st.events), static_cast<unsigned long long>(st.bad));
+    return 0;
+}